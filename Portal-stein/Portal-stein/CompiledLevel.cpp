@@ -0,0 +1,527 @@
+#include "CompiledLevel.hpp"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <map>
+#include "LevelLoader.hpp"
+#include "SegmentBuilder.hpp"
+#include "MappedFile.hpp"
+#include "RayCaster.hpp"
+#include "TextureCache.hpp"
+#include "Profiler.hpp"
+
+namespace ps {
+
+	CompiledLevelException::CompiledLevelException(const std::string & description_) : description(description_) {
+	}
+
+	const char * CompiledLevelException::what() const noexcept
+	{
+		return description.c_str();
+	}
+
+
+
+	//**************************************************************************
+	// RECORDS
+	//**************************************************************************
+
+	// Compiled level is: header, textures, materials, segments, walls, portals, ids of visible segments and characters of the texture paths.
+	// All the fields of the records are 4 bytes wide (or they are packed into 4 bytes), so the records stay aligned and they are read in
+	// place. Numbers are stored in the byte order of the machine that compiled the level (the engine runs only on little-endian machines).
+
+	const char compiledLevelMagic[4] = { 'P', 'S', 'L', 'V' };
+	const std::uint32_t noIndex = 0xffffffff;	// texture index of materials without texture, portal index of walls without portal
+
+	struct CompiledHeader {
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t sourceHash;
+		std::uint32_t textureCount;
+		std::uint32_t materialCount;
+		std::uint32_t segmentCount;
+		std::uint32_t wallCount;
+		std::uint32_t portalCount;
+		std::uint32_t visibleCount;
+		std::uint32_t pathsSize;
+		std::uint32_t playerSegment;
+		float playerPosition[3];
+		float playerDirection[2];
+		std::uint32_t visibilityDepth;	// number of portals the potentially visible set was computed for (RayCaster::recursionLimit)
+	};
+
+	struct CompiledTexture {
+		std::uint32_t pathOffset;	// offset of the path in the characters of the paths
+		std::uint32_t pathSize;
+	};
+
+	struct CompiledMaterial {
+		std::uint8_t color[4];		// r, g, b, a
+		std::uint32_t texture;
+	};
+
+	struct CompiledSegment {
+		float floorHeight;
+		float wallHeight;
+		std::uint32_t floorMaterial;
+		std::uint32_t ceilingMaterial;
+		std::uint32_t firstWall;
+		std::uint32_t wallCount;
+		std::uint32_t firstVisible;
+		std::uint32_t visibleCount;
+		std::uint32_t finish;
+	};
+
+	struct CompiledWall {
+		float from[2];
+		float to[2];
+		std::uint32_t material;
+		std::uint32_t portal;
+	};
+
+	struct CompiledPortal {
+		std::uint32_t type;			// Portal::Type
+		std::uint32_t targetSegment;
+		float linear[4];			// elements 00, 01, 10, 11 of the matrix
+		float translation[2];
+		float cosRotation;
+		float sinRotation;
+	};
+
+	static_assert(sizeof(CompiledHeader) == 72, "Compiled level header must not be padded!");
+	static_assert(sizeof(CompiledMaterial) == 8 && sizeof(CompiledSegment) == 36 && sizeof(CompiledWall) == 24 && sizeof(CompiledPortal) == 40,
+		"Records of compiled level must not be padded!");
+
+
+
+	//**************************************************************************
+	// WRITING
+	//**************************************************************************
+
+	// Collects distinct textures and materials of the level, while its records are made.
+	class MaterialTable {
+	private:
+		std::map<const sf::Texture *, std::uint32_t> textureIndices;
+
+	public:
+		std::vector<std::string> paths;
+		std::vector<CompiledMaterial> materials;
+
+		// Textures loaded from the same path more times are stored once.
+		explicit MaterialTable(const std::vector<LevelTexture> & textures) {
+			std::map<std::string, std::uint32_t> pathIndices;
+			for (auto & texture : textures) {
+				auto it = pathIndices.find(texture.path);
+				if (it == pathIndices.end()) {
+					it = pathIndices.insert(std::make_pair(texture.path, (std::uint32_t)paths.size())).first;
+					paths.push_back(texture.path);
+				}
+				textureIndices[texture.texture.get()] = it->second;
+			}
+		}
+
+		std::uint32_t add(const sf::Color & color, const sf::Texture * texture) {
+			CompiledMaterial material;
+			material.color[0] = color.r;
+			material.color[1] = color.g;
+			material.color[2] = color.b;
+			material.color[3] = color.a;
+			material.texture = noIndex;
+
+			if (texture != nullptr) {
+				auto it = textureIndices.find(texture);
+				if (it == textureIndices.end())
+					throw CompiledLevelException("Texture of the level was not loaded from a file, so it cannot be compiled!");
+				material.texture = it->second;
+			}
+
+			for (std::size_t i = 0; i < materials.size(); ++i) {
+				if (std::memcmp(&materials[i], &material, sizeof(CompiledMaterial)) == 0)
+					return (std::uint32_t)i;
+			}
+
+			materials.push_back(material);
+			return (std::uint32_t)(materials.size() - 1);
+		}
+	};
+
+	template<typename T>
+	void writeRecords(std::ostream & output, const std::vector<T> & records) {
+		output.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(T));
+	}
+
+	void writeCompiledLevel(std::ostream & output, const Level & level, std::uint64_t sourceHash)
+	{
+		const LevelGeometry & geometry = level.getGeometry();
+		MaterialTable table{ level.getTextures() };
+
+		std::vector<CompiledSegment> segments;
+		std::vector<CompiledWall> walls;
+		std::vector<CompiledPortal> portals;
+		std::vector<std::uint32_t> visible;
+
+		for (std::size_t i = 0; i < geometry.getSegmentCount(); ++i) {
+			const Segment & segment = geometry.getSegment(i);
+
+			CompiledSegment record;
+			record.floorHeight = segment.segmentFloorHeight;
+			record.wallHeight = segment.segmentWallHeight;
+			record.floorMaterial = table.add(segment.floor.getColor(), segment.floor.getTexture().get());
+			record.ceilingMaterial = table.add(segment.ceiling.getColor(), segment.ceiling.getTexture().get());
+			record.firstWall = (std::uint32_t)walls.size();
+			record.wallCount = (std::uint32_t)segment.getWalls().size();
+			record.firstVisible = (std::uint32_t)visible.size();
+			record.visibleCount = (std::uint32_t)level.getVisibility().getVisibleSegments(i).size();
+			record.finish = (segment.finish) ? 1 : 0;
+			segments.push_back(record);
+
+			for (auto & wall : segment.getWalls()) {
+				WallMaterial material = wall.getMaterial();
+
+				CompiledWall wallRecord;
+				wallRecord.from[0] = wall.getFrom().x;
+				wallRecord.from[1] = wall.getFrom().y;
+				wallRecord.to[0] = wall.getTo().x;
+				wallRecord.to[1] = wall.getTo().y;
+				wallRecord.material = table.add(material.color, material.texture);
+				wallRecord.portal = noIndex;
+
+				if (wall.isPortal()) {
+					// transformation of the portal is stored, so it is not computed from the walls again
+					const Portal & portal = wall.getPortal();
+					const AffineTransform & transform = portal.getTransform();
+
+					CompiledPortal portalRecord;
+					portalRecord.type = (std::uint32_t)portal.getType();
+					portalRecord.targetSegment = (std::uint32_t)portal.getTargetSegment();
+					portalRecord.linear[0] = transform.getLinear().getElement(0, 0);
+					portalRecord.linear[1] = transform.getLinear().getElement(0, 1);
+					portalRecord.linear[2] = transform.getLinear().getElement(1, 0);
+					portalRecord.linear[3] = transform.getLinear().getElement(1, 1);
+					portalRecord.translation[0] = transform.getTranslation().x;
+					portalRecord.translation[1] = transform.getTranslation().y;
+					portalRecord.cosRotation = transform.getCosRotation();
+					portalRecord.sinRotation = transform.getSinRotation();
+
+					wallRecord.portal = (std::uint32_t)portals.size();
+					portals.push_back(portalRecord);
+				}
+
+				walls.push_back(wallRecord);
+			}
+
+			for (std::size_t id : level.getVisibility().getVisibleSegments(i))
+				visible.push_back((std::uint32_t)id);
+		}
+
+		std::vector<CompiledTexture> textures;
+		std::string paths;
+		for (auto & path : table.paths) {
+			textures.push_back(CompiledTexture{ (std::uint32_t)paths.size(), (std::uint32_t)path.size() });
+			paths += path;
+		}
+
+		const ObjectInScene & player = level.getInitialCamera();
+
+		CompiledHeader header;
+		std::memcpy(header.magic, compiledLevelMagic, sizeof(header.magic));
+		header.version = COMPILED_LEVEL_VERSION;
+		header.sourceHash = sourceHash;
+		header.textureCount = (std::uint32_t)textures.size();
+		header.materialCount = (std::uint32_t)table.materials.size();
+		header.segmentCount = (std::uint32_t)segments.size();
+		header.wallCount = (std::uint32_t)walls.size();
+		header.portalCount = (std::uint32_t)portals.size();
+		header.visibleCount = (std::uint32_t)visible.size();
+		header.pathsSize = (std::uint32_t)paths.size();
+		header.playerSegment = (std::uint32_t)player.getSegmentId();
+		header.playerPosition[0] = player.getPosition().x;
+		header.playerPosition[1] = player.getPosition().y;
+		header.playerPosition[2] = player.getPosition().z;
+		header.playerDirection[0] = player.getDirection().x;
+		header.playerDirection[1] = player.getDirection().y;
+		header.visibilityDepth = (std::uint32_t)RayCaster::recursionLimit;
+
+		output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		writeRecords(output, textures);
+		writeRecords(output, table.materials);
+		writeRecords(output, segments);
+		writeRecords(output, walls);
+		writeRecords(output, portals);
+		writeRecords(output, visible);
+		output.write(paths.data(), paths.size());
+	}
+
+
+
+	//**************************************************************************
+	// READING
+	//**************************************************************************
+
+	// Compiled level being read. Records point into the data of the level, they are never copied.
+	struct CompiledLevelView {
+		const CompiledHeader * header;
+		const CompiledTexture * textures;
+		const CompiledMaterial * materials;
+		const CompiledSegment * segments;
+		const CompiledWall * walls;
+		const CompiledPortal * portals;
+		const std::uint32_t * visible;
+		const char * paths;
+
+		// Finds the records in the data and checks that all the indices are in range.
+		CompiledLevelView(const char * data, std::size_t size, std::uint64_t sourceHash);
+	};
+
+	// Throws CompiledLevelException with given description, if the condition does not hold.
+	void checkCompiledLevel(bool condition, const char * description) {
+		if (!condition)
+			throw CompiledLevelException(description);
+	}
+
+	CompiledLevelView::CompiledLevelView(const char * data, std::size_t size, std::uint64_t sourceHash)
+	{
+		checkCompiledLevel(size >= sizeof(CompiledHeader), "Compiled level is truncated!");
+		header = reinterpret_cast<const CompiledHeader *>(data);
+		checkCompiledLevel(std::memcmp(header->magic, compiledLevelMagic, sizeof(header->magic)) == 0, "File is not a compiled level!");
+		checkCompiledLevel(header->version == COMPILED_LEVEL_VERSION, "Compiled level has other version of the format!");
+		checkCompiledLevel(header->sourceHash == sourceHash, "Compiled level was compiled from other source!");
+		checkCompiledLevel(header->visibilityDepth == (std::uint32_t)RayCaster::recursionLimit,
+			"Potentially visible set of compiled level was computed for other recursion limit!");
+
+		// sizes are summed in 64 bits, so the counts of a damaged file cannot overflow
+		std::uint64_t offset = sizeof(CompiledHeader);
+		auto next = [&](std::uint64_t bytes) {
+			const char * records = data + offset;
+			offset += bytes;
+			return records;
+		};
+		textures = reinterpret_cast<const CompiledTexture *>(next((std::uint64_t)header->textureCount * sizeof(CompiledTexture)));
+		materials = reinterpret_cast<const CompiledMaterial *>(next((std::uint64_t)header->materialCount * sizeof(CompiledMaterial)));
+		segments = reinterpret_cast<const CompiledSegment *>(next((std::uint64_t)header->segmentCount * sizeof(CompiledSegment)));
+		walls = reinterpret_cast<const CompiledWall *>(next((std::uint64_t)header->wallCount * sizeof(CompiledWall)));
+		portals = reinterpret_cast<const CompiledPortal *>(next((std::uint64_t)header->portalCount * sizeof(CompiledPortal)));
+		visible = reinterpret_cast<const std::uint32_t *>(next((std::uint64_t)header->visibleCount * sizeof(std::uint32_t)));
+		paths = next(header->pathsSize);
+		checkCompiledLevel(offset == size, "Compiled level is truncated!");
+
+		for (std::uint32_t i = 0; i < header->textureCount; ++i)
+			checkCompiledLevel((std::uint64_t)textures[i].pathOffset + textures[i].pathSize <= header->pathsSize, "Texture path is out of range!");
+		for (std::uint32_t i = 0; i < header->materialCount; ++i)
+			checkCompiledLevel(materials[i].texture == noIndex || materials[i].texture < header->textureCount, "Material refers to unknown texture!");
+		for (std::uint32_t i = 0; i < header->segmentCount; ++i) {
+			const CompiledSegment & segment = segments[i];
+			checkCompiledLevel(segment.floorMaterial < header->materialCount && segment.ceilingMaterial < header->materialCount, "Segment refers to unknown material!");
+			checkCompiledLevel((std::uint64_t)segment.firstWall + segment.wallCount <= header->wallCount, "Walls of segment are out of range!");
+			checkCompiledLevel((std::uint64_t)segment.firstVisible + segment.visibleCount <= header->visibleCount, "Visible segments are out of range!");
+		}
+		for (std::uint32_t i = 0; i < header->wallCount; ++i) {
+			checkCompiledLevel(walls[i].material < header->materialCount, "Wall refers to unknown material!");
+			checkCompiledLevel(walls[i].portal == noIndex || walls[i].portal < header->portalCount, "Wall refers to unknown portal!");
+		}
+		for (std::uint32_t i = 0; i < header->portalCount; ++i) {
+			checkCompiledLevel(portals[i].type <= (std::uint32_t)Portal::Type::WALL_PORTAL, "Portal has unknown type!");
+			checkCompiledLevel(portals[i].targetSegment < header->segmentCount, "Portal leads to unknown segment!");
+		}
+		for (std::uint32_t i = 0; i < header->visibleCount; ++i)
+			checkCompiledLevel(visible[i] < header->segmentCount, "Visible segment is unknown!");
+		checkCompiledLevel(header->playerSegment < header->segmentCount, "Player is in unknown segment!");
+	}
+
+	Portal makeCompiledPortal(const CompiledPortal & record) {
+		Matrix2<float> linear{ record.linear[0], record.linear[1], record.linear[2], record.linear[3] };
+		sf::Vector2f translation{ record.translation[0], record.translation[1] };
+		AffineTransform transform{ linear, translation, record.cosRotation, record.sinRotation };
+
+		return Portal((Portal::Type)record.type, record.targetSegment, transform);
+	}
+
+	Level readCompiledLevel(const char * data, std::size_t size, std::uint64_t sourceHash)
+	{
+		CompiledLevelView view{ data, size, sourceHash };
+		const CompiledHeader & header = *view.header;
+
+		// images of the textures are decoded by the texture cache, while the segments are built
+		std::vector<LevelTexture> textures;
+		for (std::uint32_t i = 0; i < header.textureCount; ++i) {
+			std::string path{ view.paths + view.textures[i].pathOffset, view.textures[i].pathSize };
+			textures.push_back(LevelTexture{ path, TextureCache::getInstance().request(path) });
+		}
+
+		auto materialColor = [&](std::uint32_t material) {
+			const std::uint8_t * color = view.materials[material].color;
+			return sf::Color(color[0], color[1], color[2], color[3]);
+		};
+		auto materialTexture = [&](std::uint32_t material) {
+			std::uint32_t texture = view.materials[material].texture;
+			return (texture == noIndex) ? std::shared_ptr<sf::Texture>() : textures[texture].texture;
+		};
+
+		std::vector<Segment> segments;
+		std::vector<std::vector<std::size_t>> visible;
+		segments.reserve(header.segmentCount);
+		visible.reserve(header.segmentCount);
+
+		for (std::uint32_t i = 0; i < header.segmentCount; ++i) {
+			const CompiledSegment & record = view.segments[i];
+			Floor floor{ materialColor(record.floorMaterial), materialTexture(record.floorMaterial) };
+			Ceiling ceiling{ materialColor(record.ceilingMaterial), materialTexture(record.ceilingMaterial) };
+			SegmentBuilder builder{ floor, ceiling };
+
+			try {
+				for (std::uint32_t w = record.firstWall; w < record.firstWall + record.wallCount; ++w) {
+					const CompiledWall & wallRecord = view.walls[w];
+					PortalWall wall{ sf::Vector2f(wallRecord.from[0], wallRecord.from[1]), sf::Vector2f(wallRecord.to[0], wallRecord.to[1]),
+						materialColor(wallRecord.material), materialTexture(wallRecord.material) };
+					if (wallRecord.portal != noIndex)
+						wall.setPortal(makeCompiledPortal(view.portals[wallRecord.portal]));
+
+					builder.addWall(std::move(wall));
+				}
+
+				builder.setFinish(record.finish != 0);
+				segments.push_back(builder.finalize());
+			}
+			catch (WallsAreNotConnected &) {
+				throw CompiledLevelException("Walls of compiled segment are not connected!");
+			}
+			catch (EmptySegment &) {
+				throw CompiledLevelException("Compiled segment has no walls!");
+			}
+
+			segments.back().segmentFloorHeight = record.floorHeight;
+			segments.back().segmentWallHeight = record.wallHeight;
+			visible.push_back(std::vector<std::size_t>(view.visible + record.firstVisible, view.visible + record.firstVisible + record.visibleCount));
+		}
+
+		sf::Vector3f playerPosition{ header.playerPosition[0], header.playerPosition[1], header.playerPosition[2] };
+		sf::Vector2f playerDirection{ header.playerDirection[0], header.playerDirection[1] };
+		ObjectInScene player{ playerPosition, playerDirection, header.playerSegment };
+
+		for (auto & texture : textures) {
+			if (!TextureCache::getInstance().waitForImage(texture.path))
+				throw TexureLoadFailedException(texture.path, 0);
+		}
+
+		// potentially visible set is stored, so loading the level does not compute it again
+		Level level{ std::move(segments), player, PotentiallyVisibleSet(std::move(visible)) };
+		for (auto & texture : textures)
+			level.addTexture(texture.path, texture.texture);
+
+		return level;
+	}
+
+
+
+	//**************************************************************************
+	// LEVEL FILES
+	//**************************************************************************
+
+	std::uint64_t hashLevelSource(const char * data, std::size_t size)
+	{
+		std::uint64_t hash = 14695981039346656037ull;
+		for (std::size_t i = 0; i < size; ++i) {
+			hash ^= (unsigned char)data[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	std::string getCompiledLevelPath(const std::string & sourcePath)
+	{
+		return sourcePath + COMPILED_LEVEL_EXTENSION;
+	}
+
+	bool isCompiledLevelPath(const std::string & path)
+	{
+		std::size_t extensionSize = std::strlen(COMPILED_LEVEL_EXTENSION);
+		return path.size() >= extensionSize && path.compare(path.size() - extensionSize, extensionSize, COMPILED_LEVEL_EXTENSION) == 0;
+	}
+
+	// Reads the whole level source. The source is read in text mode, as the lexer expects it.
+	std::string readLevelSource(const std::string & sourcePath) {
+		std::ifstream input{ sourcePath };
+		if (!input.is_open())
+			throw std::runtime_error("Level file \"" + sourcePath + "\" could not be opened!");
+
+		std::ostringstream source;
+		source << input.rdbuf();
+		return source.str();
+	}
+
+	Level parseLevelSource(const std::string & source) {
+		PS_PROFILE_SCOPE("parseLevel");
+		LevelLoader loader(source.data(), source.size());
+		return loader.loadLevel();
+	}
+
+	// Writes the compiled level into temporary file first, so that a compiled level is never left half written.
+	void writeCompiledLevelFile(const std::string & compiledPath, const Level & level, std::uint64_t sourceHash) {
+		PS_PROFILE_SCOPE("writeCompiledLevel");
+		std::string temporaryPath = compiledPath.substr(0, compiledPath.size() - std::strlen(COMPILED_LEVEL_EXTENSION)) + ".tmp" + COMPILED_LEVEL_EXTENSION;
+
+		{
+			std::ofstream output{ temporaryPath, std::ios_base::binary };
+			writeCompiledLevel(output, level, sourceHash);
+			if (!output)
+				throw CompiledLevelException("Compiled level could not be written to \"" + temporaryPath + "\"!");
+		}
+
+		std::remove(compiledPath.c_str());
+		if (std::rename(temporaryPath.c_str(), compiledPath.c_str()) != 0) {
+			std::remove(temporaryPath.c_str());
+			throw CompiledLevelException("Compiled level could not be written to \"" + compiledPath + "\"!");
+		}
+	}
+
+	Level compileLevelFile(const std::string & sourcePath, const std::string & compiledPath)
+	{
+		std::string source = readLevelSource(sourcePath);
+		Level level = parseLevelSource(source);
+		writeCompiledLevelFile(compiledPath, level, hashLevelSource(source.data(), source.size()));
+		return level;
+	}
+
+	Level loadLevelFile(const std::string & sourcePath)
+	{
+		// source is only hashed, it is parsed just when the compiled level is missing or out of date
+		std::string source = readLevelSource(sourcePath);
+		std::uint64_t sourceHash = hashLevelSource(source.data(), source.size());
+		std::string compiledPath = getCompiledLevelPath(sourcePath);
+
+		{
+			MappedFile compiled{ compiledPath };
+			if (compiled.isOpen()) {
+				try {
+					PS_PROFILE_SCOPE("readCompiledLevel");
+					return readCompiledLevel(compiled.getData(), compiled.getSize(), sourceHash);
+				}
+				catch (CompiledLevelException &) {
+					// source was changed (or the compiled level is damaged) => it is compiled again
+				}
+			}
+		}
+
+		Level level = parseLevelSource(source);
+		try {
+			writeCompiledLevelFile(compiledPath, level, sourceHash);
+		}
+		catch (CompiledLevelException &) {
+			// level directory may be read-only, the level is just parsed next time
+		}
+
+		return level;
+	}
+
+	Level reloadLevelFile(const std::string & sourcePath, const Level & previous)
+	{
+		std::string source = readLevelSource(sourcePath);
+
+		PS_PROFILE_SCOPE("reloadLevel");
+		LevelLoader loader(source.data(), source.size());
+		return loader.reloadLevel(previous);
+	}
+}
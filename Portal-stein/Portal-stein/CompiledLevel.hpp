@@ -0,0 +1,69 @@
+#pragma once
+#ifndef PS_COMPILED_LEVEL_INCLUDED
+#define PS_COMPILED_LEVEL_INCLUDED
+#include <string>
+#include <iostream>
+#include <exception>
+#include <cstdint>
+#include "Level.hpp"
+
+namespace ps {
+
+	//**************************************************************************
+	// EXCEPTIONS
+	//**************************************************************************
+
+	/// Exception that is thrown when compiled level cannot be used (it is damaged, it has other version of the format, or it was compiled
+	/// from other content of the source), or when it cannot be written.
+	class CompiledLevelException : public std::exception {
+	private:
+		std::string description;
+
+	public:
+		CompiledLevelException(const std::string & description_);
+
+		virtual const char * what() const noexcept override;
+	};
+
+
+
+	//**************************************************************************
+	// COMPILED LEVEL
+	//**************************************************************************
+
+	/// Version of the compiled level format. It is raised whenever the layout of the compiled level changes, so the old files are compiled again.
+	const std::uint32_t COMPILED_LEVEL_VERSION = 2;
+	/// Compiled level is cached next to its source, in the file with this extension appended to the name of the source.
+	const char * const COMPILED_LEVEL_EXTENSION = ".psl";
+
+	/// Computes 64-bit FNV-1a hash of the level source. Compiled level is used only if it was compiled from the source with the same hash.
+	std::uint64_t hashLevelSource(const char * data, std::size_t size);
+	/// Gets the path of the compiled level cached for the source.
+	std::string getCompiledLevelPath(const std::string & sourcePath);
+	/// Returns true if the path has the extension of compiled levels (such files are not level sources).
+	bool isCompiledLevelPath(const std::string & path);
+
+	/// Writes the level in compiled format. Segments, walls, portals (with their transformations), materials, paths of the textures and
+	/// the potentially visible set are stored as arrays of fixed-size records, so reading them needs no parsing.
+	/// \param sourceHash Hash of the source the level was loaded from.
+	void writeCompiledLevel(std::ostream & output, const Level & level, std::uint64_t sourceHash);
+	/// Makes the level from compiled level in memory (usually a mapped file). Records are read in place, only the textures are requested
+	/// from TextureCache (they are empty until TextureCache::uploadTextures() is called). CompiledLevelException is thrown if the data is
+	/// not a valid compiled level of the current version, if it was compiled from source with other hash, or if its potentially visible
+	/// set was computed for other RayCaster::recursionLimit. TexureLoadFailedException (with line number 0) is thrown if a texture cannot
+	/// be loaded.
+	Level readCompiledLevel(const char * data, std::size_t size, std::uint64_t sourceHash);
+
+	/// Parses the level source and writes the compiled level to given path. Exceptions of LevelLoader are passed on, CompiledLevelException
+	/// is thrown if the compiled level cannot be written and std::runtime_error if the source cannot be opened.
+	Level compileLevelFile(const std::string & sourcePath, const std::string & compiledPath);
+	/// Loads level from its source file. The compiled level cached next to the source is mapped and used, if it was compiled from the same
+	/// content of the source. Otherwise the source is parsed and the cache is written again (levels in read-only directories are just
+	/// parsed). Exceptions of LevelLoader are passed on, std::runtime_error is thrown if the source cannot be opened.
+	Level loadLevelFile(const std::string & sourcePath);
+	/// Loads level from its edited source file as new version of previous level (see LevelLoader::reloadLevel()). The source is always
+	/// parsed, compiled level is neither used nor written (it is compiled again when the level is loaded next time).
+	Level reloadLevelFile(const std::string & sourcePath, const Level & previous);
+}
+
+#endif // !PS_COMPILED_LEVEL_INCLUDED
@@ -19,17 +19,15 @@ namespace ps {
 		}
 		)raw";
 
+		// Texture coordinates of the vertices are (point * vp), where point is position on the floor/ceiling and vp is the view plane
+		// coordinate of the vertex. Both are linear along the strip, so point is recovered by dividing by vp of the fragment.
 		std::string fragmentShaderCode = R"raw(
-		uniform float hD;
-		uniform float vpDistance;
-		uniform vec2 from;
-		uniform vec2 dir;
+		uniform vec2 viewPlaneMapping;
 		uniform sampler2D myTexture;
 	
 		void main() {
-			float sigma = gl_TexCoord[0].x / gl_TexCoord[0].y;
-			float d = (hD * vpDistance) / sigma;
-			vec2 point = from + d * dir;
+			float vp = viewPlaneMapping.x + viewPlaneMapping.y * gl_FragCoord.y;
+			vec2 point = gl_TexCoord[0].xy / vp;
 			vec4 pixel = texture(myTexture, point);
 		
 			gl_FragColor = gl_Color * pixel;
@@ -43,37 +41,48 @@ namespace ps {
 		shader.setUniform("myTexture", sf::Shader::CurrentTexture);
 	}
 
-	void FloorCeiling::draw(sf::RenderTarget & rt, const FloorCeilingDrawParameters & params) const {
+	const sf::Shader * FloorCeiling::prepareShader(float viewPlaneOffset, float viewPlaneScale)
+	{
+		shader.setUniform("viewPlaneMapping", sf::Vector2f(viewPlaneOffset, viewPlaneScale));
+		return &shader;
+	}
+
+	void FloorCeiling::draw(RenderBatch & batch, const FloorCeilingDrawParameters & params) const {
 		if (texture) {
-			shader.setUniform("hD", params.deltaH);
-			shader.setUniform("from", params.uvCamera);
-			shader.setUniform("dir", params.uvDirection);
+			// point on floor/ceiling seen at view plane coordinate vp is: uvCamera + (deltaH * viewPlaneDistance / vp) * uvDirection
+			sf::Vector2f offset = params.deltaH * params.viewPlaneDistance * params.uvDirection;
+			sf::Vector2f uvTop = params.vpTop * params.uvCamera + offset;
+			sf::Vector2f uvBottom = params.vpBottom * params.uvCamera + offset;
 
-			shader.setUniform("vpDistance", params.viewPlaneDistance);
+			float texSizeX = (float)texture->getSize().x;
+			float texSizeY = (float)texture->getSize().y;
 
-			sf::VertexArray arr(sf::Lines, 2);
-			arr[0] = sf::Vertex(params.scrTop, color, sf::Vector2f(params.vpTop, 1.0f));
-			arr[1] = sf::Vertex(params.scrBottom, color, sf::Vector2f(params.vpBottom, 1.0f));
+			uvTop.x *= texSizeX;
+			uvTop.y *= texSizeY;
+			uvBottom.x *= texSizeX;
+			uvBottom.y *= texSizeY;
 
-			sf::RenderStates states;
-			states.shader = &shader;
-			states.texture = texture.get();
-			rt.draw(arr, states);
+			batch.addFloorCeilingLine(sf::Vertex(params.scrTop, color, uvTop), sf::Vertex(params.scrBottom, color, uvBottom), texture.get());
 		}
 		else {
-			sf::VertexArray arr(sf::Lines, 2);
-			arr[0] = sf::Vertex(params.scrTop, color);
-			arr[1] = sf::Vertex(params.scrBottom, color);
-			rt.draw(arr);
+			batch.addLine(sf::Vertex(params.scrTop, color), sf::Vertex(params.scrBottom, color));
 		}	
 	}
 
+	const sf::Color & FloorCeiling::getColor() const
+	{
+		return color;
+	}
+
+	const std::shared_ptr<sf::Texture> & FloorCeiling::getTexture() const
+	{
+		return texture;
+	}
+
 	FloorCeiling::FloorCeiling(const sf::Color & color_) : FloorCeiling(color_, nullptr)	{
 	}
 
 	FloorCeiling::FloorCeiling(const sf::Color & color_, std::shared_ptr<sf::Texture> texture_) : color(color_), texture(texture_) {
-		if (texture != nullptr)
-			texture->setRepeated(true);
 	}
 
 }
\ No newline at end of file
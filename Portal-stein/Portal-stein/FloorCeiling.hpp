@@ -3,6 +3,7 @@
 #define PS_FLOOR_CEILING_INCLUDED
 #include <memory>
 #include <SFML\Graphics.hpp>
+#include "RenderBatch.hpp"
 
 namespace ps {
 
@@ -35,10 +36,18 @@ namespace ps {
 	public:
 		/// Compiles the GLSL shaders that are used to draw floors and ceilings. This must be done prior to drawing any floor or ceiling.
 		static void compileShaders();
+		/// Sets up the floor/ceiling shader for drawing one frame and returns it. View plane coordinate of each fragment is computed as
+		/// viewPlaneOffset + viewPlaneScale * gl_FragCoord.y
+		static const sf::Shader * prepareShader(float viewPlaneOffset, float viewPlaneScale);
 
-		/// Draws this floor / ceiling according to draw parameters.
-		/// \param rt Render target used for drawing.
-		void draw(sf::RenderTarget & rt, const FloorCeilingDrawParameters & params) const;
+		/// Adds this floor / ceiling strip to the render batch according to draw parameters.
+		/// \param batch Batch collecting the lines of the frame.
+		void draw(RenderBatch & batch, const FloorCeilingDrawParameters & params) const;
+
+		/// Gets color of the floor/ceiling.
+		const sf::Color & getColor() const;
+		/// Gets texture of the floor/ceiling (nullptr if it has only color).
+		const std::shared_ptr<sf::Texture> & getTexture() const;
 
 		/// Creates colored floor/ceiling.
 		FloorCeiling(const sf::Color & color_);
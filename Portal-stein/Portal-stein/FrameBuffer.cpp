@@ -0,0 +1,223 @@
+#include "FrameBuffer.hpp"
+#include <cmath>
+#include "Math.hpp"
+#include "TextureCache.hpp"
+
+namespace ps {
+
+	// Returns index of texel for texture coordinate (in pixels) of repeated texture.
+	inline unsigned int repeatTexel(float coordinate, unsigned int size) {
+		int texel = (int)std::floor(coordinate) % (int)size;
+		return (texel < 0) ? (unsigned int)(texel + (int)size) : (unsigned int)texel;
+	}
+
+	FrameBuffer::FrameBuffer() : FrameBuffer(0, 0) {
+	}
+
+	FrameBuffer::FrameBuffer(unsigned int width_, unsigned int height_) : width(0), height(0), pixels(), images(), texture() {
+		resize(width_, height_);
+	}
+
+	void FrameBuffer::resize(unsigned int width_, unsigned int height_)
+	{
+		if (width == width_ && height == height_)
+			return;
+
+		width = width_;
+		height = height_;
+		pixels.assign(4 * (std::size_t)width * height, 0);
+	}
+
+	unsigned int FrameBuffer::getWidth() const
+	{
+		return width;
+	}
+
+	unsigned int FrameBuffer::getHeight() const
+	{
+		return height;
+	}
+
+	void FrameBuffer::clear(const sf::Color & color)
+	{
+		for (std::size_t i = 0; i < pixels.size(); i += 4) {
+			pixels[i + 0] = color.r;
+			pixels[i + 1] = color.g;
+			pixels[i + 2] = color.b;
+			pixels[i + 3] = color.a;
+		}
+	}
+
+	const sf::Image & FrameBuffer::getImage(const sf::Texture * texture_) const
+	{
+		return *images.at(texture_);
+	}
+
+	bool FrameBuffer::getRows(float yTop, float yBottom, int & rowFrom, int & rowTo) const
+	{
+		// pixel row is covered by the line if its center lies in [yTop, yBottom)
+		rowFrom = getMax((int)std::ceil(yTop - 0.5f), 0);
+		rowTo = getMin((int)std::ceil(yBottom - 0.5f), (int)height);
+		return rowFrom < rowTo;
+	}
+
+	void FrameBuffer::setPixel(unsigned int column, unsigned int row, const sf::Color & pixel, const sf::Color & color)
+	{
+		sf::Uint8 * target = &pixels[4 * ((std::size_t)row * width + column)];
+		target[0] = (sf::Uint8)((pixel.r * color.r) / 255);
+		target[1] = (sf::Uint8)((pixel.g * color.g) / 255);
+		target[2] = (sf::Uint8)((pixel.b * color.b) / 255);
+		target[3] = (sf::Uint8)((pixel.a * color.a) / 255);
+	}
+
+	void FrameBuffer::rasterizeLine(const sf::Vertex & top, const sf::Vertex & bottom)
+	{
+		if (bottom.position.y < top.position.y) {
+			rasterizeLine(bottom, top);
+			return;
+		}
+
+		int column = (int)top.position.x;
+		int rowFrom, rowTo;
+		if (column < 0 || (int)width <= column || !getRows(top.position.y, bottom.position.y, rowFrom, rowTo))
+			return;
+
+		for (int row = rowFrom; row < rowTo; ++row)
+			setPixel(column, row, sf::Color::White, top.color);
+	}
+
+	void FrameBuffer::rasterizeTexturedLine(const sf::Vertex & top, const sf::Vertex & bottom, const sf::Image & image)
+	{
+		if (bottom.position.y < top.position.y) {
+			rasterizeTexturedLine(bottom, top, image);
+			return;
+		}
+
+		int column = (int)top.position.x;
+		int rowFrom, rowTo;
+		if (column < 0 || (int)width <= column || !getRows(top.position.y, bottom.position.y, rowFrom, rowTo))
+			return;
+
+		float invLength = 1.0f / (bottom.position.y - top.position.y);
+		unsigned int texelX = repeatTexel(top.texCoords.x, image.getSize().x);	// wall strip has constant x texture coordinate
+
+		for (int row = rowFrom; row < rowTo; ++row) {
+			float t = ((float)row + 0.5f - top.position.y) * invLength;
+			float v = top.texCoords.y + t * (bottom.texCoords.y - top.texCoords.y);
+
+			sf::Color texel = image.getPixel(texelX, repeatTexel(v, image.getSize().y));
+			setPixel(column, row, texel, top.color);
+		}
+	}
+
+	void FrameBuffer::rasterizeFloorCeilingLine(const sf::Vertex & top, const sf::Vertex & bottom, const sf::Image & image, const RenderBatch & batch)
+	{
+		if (bottom.position.y < top.position.y) {
+			rasterizeFloorCeilingLine(bottom, top, image, batch);
+			return;
+		}
+
+		int column = (int)top.position.x;
+		int rowFrom, rowTo;
+		if (column < 0 || (int)width <= column || !getRows(top.position.y, bottom.position.y, rowFrom, rowTo))
+			return;
+
+		float invLength = 1.0f / (bottom.position.y - top.position.y);
+
+		// This is the floor/ceiling shader of FloorCeiling class: texture coordinates are (point * vp), point is recovered by dividing by vp.
+		for (int row = rowFrom; row < rowTo; ++row) {
+			float y = (float)row + 0.5f;
+			float t = (y - top.position.y) * invLength;
+			sf::Vector2f uv = top.texCoords + t * (bottom.texCoords - top.texCoords);
+			float vp = batch.screenToViewPlane(y);
+
+			sf::Color texel = image.getPixel(repeatTexel(uv.x / vp, image.getSize().x), repeatTexel(uv.y / vp, image.getSize().y));
+			setPixel(column, row, texel, top.color);
+		}
+	}
+
+	void FrameBuffer::rasterize(const RenderBatch & batch)
+	{
+		prepareTextures(batch);
+		rasterizeLines(batch);
+	}
+
+	void FrameBuffer::prepareTexture(const sf::Texture * texture_)
+	{
+		// textures live as long as their level, so the pointer identifies the texture until clearTextures() is called
+		if (images.find(texture_) != images.end())
+			return;
+
+		std::shared_ptr<const sf::Image> image = TextureCache::getInstance().getImage(texture_);
+		if (!image)
+			image = std::make_shared<const sf::Image>(texture_->copyToImage());	// texture was not loaded by the cache
+		images.insert(std::make_pair(texture_, std::move(image)));
+	}
+
+	void FrameBuffer::prepareTextures(const RenderBatch & batch)
+	{
+		for (auto & pair : batch.textured) {
+			if (pair.second.getVertexCount() != 0)
+				prepareTexture(pair.first);
+		}
+
+		for (auto & pair : batch.floorCeilings) {
+			if (pair.second.getVertexCount() != 0)
+				prepareTexture(pair.first);
+		}
+	}
+
+	void FrameBuffer::clearTextures()
+	{
+		images.clear();
+	}
+
+	void FrameBuffer::rasterizeLines(const RenderBatch & batch)
+	{
+		const sf::VertexArray & untextured = batch.untextured;
+		for (std::size_t i = 0; i + 1 < untextured.getVertexCount(); i += 2)
+			rasterizeLine(untextured[i], untextured[i + 1]);
+
+		for (auto & pair : batch.textured) {
+			const sf::VertexArray & arr = pair.second;
+			if (arr.getVertexCount() == 0)
+				continue;
+
+			const sf::Image & image = getImage(pair.first);
+			for (std::size_t i = 0; i + 1 < arr.getVertexCount(); i += 2)
+				rasterizeTexturedLine(arr[i], arr[i + 1], image);
+		}
+
+		for (auto & pair : batch.floorCeilings) {
+			const sf::VertexArray & arr = pair.second;
+			if (arr.getVertexCount() == 0)
+				continue;
+
+			const sf::Image & image = getImage(pair.first);
+			for (std::size_t i = 0; i + 1 < arr.getVertexCount(); i += 2)
+				rasterizeFloorCeilingLine(arr[i], arr[i + 1], image, batch);
+		}
+	}
+
+	const sf::Uint8 * FrameBuffer::getPixels() const
+	{
+		return pixels.data();
+	}
+
+	void FrameBuffer::display(sf::RenderTarget & rt)
+	{
+		if (width == 0 || height == 0)
+			return;
+
+		// texture only grows, so changing the resolution every frame does not recreate it
+		if (texture.getSize().x < width || texture.getSize().y < height)
+			texture.create(getMax(texture.getSize().x, width), getMax(texture.getSize().y, height));
+
+		texture.update(pixels.data(), width, height, 0, 0);	// the only upload of the frame
+
+		sf::Sprite sprite(texture, sf::IntRect(0, 0, (int)width, (int)height));
+		sprite.setScale((float)rt.getSize().x / width, (float)rt.getSize().y / height);
+		rt.draw(sprite);
+	}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef PS_FRAME_BUFFER_INCLUDED
+#define PS_FRAME_BUFFER_INCLUDED
+#include <vector>
+#include <map>
+#include <memory>
+#include <SFML\Graphics.hpp>
+#include "RenderBatch.hpp"
+
+namespace ps {
+
+	//**************************************************************************
+	// FRAME BUFFER
+	//**************************************************************************
+
+	/// CPU-side RGBA image, that the lines of a RenderBatch can be rasterized into. This is a software rendering backend: no draw calls
+	/// are issued while rendering, the finished image can be uploaded to GPU by one texture update (or not at all in headless mode).
+	class FrameBuffer {
+	private:
+		unsigned int width;
+		unsigned int height;
+		std::vector<sf::Uint8> pixels;						///< RGBA pixels, row by row.
+
+		std::map<const sf::Texture *, std::shared_ptr<const sf::Image>> images;	///< CPU images of the textures, that are used for sampling.
+		sf::Texture texture;								///< Texture the image is uploaded to in display().
+
+		/// Finds CPU image of the texture, unless it was found before.
+		void prepareTexture(const sf::Texture * texture_);
+		/// Gets CPU image of the texture, that was found by prepareTextures().
+		const sf::Image & getImage(const sf::Texture * texture_) const;
+		/// Returns range of pixel rows [rowFrom, rowTo), whose centers lie in the line. Returns false if there is no such row.
+		bool getRows(float yTop, float yBottom, int & rowFrom, int & rowTo) const;
+		/// Writes pixel that is modulated by color.
+		void setPixel(unsigned int column, unsigned int row, const sf::Color & pixel, const sf::Color & color);
+
+		void rasterizeLine(const sf::Vertex & top, const sf::Vertex & bottom);
+		void rasterizeTexturedLine(const sf::Vertex & top, const sf::Vertex & bottom, const sf::Image & image);
+		void rasterizeFloorCeilingLine(const sf::Vertex & top, const sf::Vertex & bottom, const sf::Image & image, const RenderBatch & batch);
+
+	public:
+		/// Creates empty frame buffer.
+		FrameBuffer();
+		/// Creates frame buffer of given size.
+		FrameBuffer(unsigned int width_, unsigned int height_);
+
+		/// Changes the size of the frame buffer. Content of the buffer is lost if the size changes.
+		void resize(unsigned int width_, unsigned int height_);
+		/// Gets width of the image (in pixels).
+		unsigned int getWidth() const;
+		/// Gets height of the image (in pixels).
+		unsigned int getHeight() const;
+		/// Fills whole image with given color.
+		void clear(const sf::Color & color);
+
+		/// Rasterizes all lines of the batch into the image.
+		void rasterize(const RenderBatch & batch);
+		/// Finds CPU images of the textures used by the batch. Images of the textures loaded by TextureCache are shared with the cache, other
+		/// textures are copied from GPU. Each texture is looked up only the first time it is encountered.
+		void prepareTextures(const RenderBatch & batch);
+		/// Drops the CPU images of the textures. This must be called when textures are released while the frame buffer is used (e.g. when
+		/// the level is reloaded), because new texture can get the address of the released one.
+		void clearTextures();
+		/// Rasterizes all lines of the batch into the image. prepareTextures() must be called for the batch first. This method can be called
+		/// concurrently for batches, that cover distinct columns of the image.
+		void rasterizeLines(const RenderBatch & batch);
+		/// Gets RGBA pixels of the image (row by row, top row first).
+		const sf::Uint8 * getPixels() const;
+		/// Uploads the image to the GPU (by one texture update) and draws it over the whole render target.
+		void display(sf::RenderTarget & rt);
+	};
+}
+
+#endif // !PS_FRAME_BUFFER_INCLUDED
@@ -1,11 +1,19 @@
 #include "Game.hpp"
 #include <memory>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <chrono>
+#include <thread>
+#include <exception>
+#include <functional>
+#include <mutex>
 
 #include "Math.hpp"
 #include "LevelLoader.hpp"
+#include "CompiledLevel.hpp"
+#include "TextureCache.hpp"
+#include "Profiler.hpp"
 
 namespace ps {
 
@@ -31,7 +39,76 @@ namespace ps {
 			throw std::runtime_error("Texture win.png could not be loaded!");
 	}
 
-	Game::Game() : levels()
+	// Loads the level file by given function. The result of the loading is written into the log (when it fails, the error is described
+	// there, and nullptr is returned).
+	std::unique_ptr<Level> loadAndLog(const std::string & filePath, const std::function<Level()> & load, const std::string & successMessage) {
+		using namespace std::chrono;
+
+		std::ofstream logFile;
+		logFile.open("log.txt", std::ios_base::app);	// opens file in append mode
+
+		time_point<system_clock> time = system_clock::now();
+		std::time_t ttime = system_clock::to_time_t(time);
+		std::string timeString;
+		{
+			// levels are loaded by several threads at once and ctime returns its own static buffer
+			static std::mutex ctimeMutex;
+			std::lock_guard<std::mutex> lock(ctimeMutex);
+			timeString = std::string(std::ctime(&ttime));
+		}
+		timeString.pop_back();	// ctime inserts a line-feed character at the end => pop it
+
+		try {
+			auto level = std::make_unique<Level>(load());
+
+			logFile << timeString << " : \"" << filePath << "\" " << successMessage << std::endl;
+			return level;
+		}
+		catch (UnexpectedTokenException & e) {
+			std::string expectedType = getTokenString(e.expected);
+			std::string actualType = getTokenString(e.actual);
+			logFile << timeString << " : Syntax error in \"" << filePath << "\" | Line " << e.lineNumber << 
+				": Expected: \"" << expectedType << "\", but \"" << actualType << "\" was read!" << std::endl;
+		}
+		catch (TexureLoadFailedException & e) {
+			logFile << timeString << " : Error in \"" << filePath << "\" | Line " << e.lineNumber << 
+				": Texture could not be loaded from \"" << e.path << "\"!" << std::endl;
+		}
+		catch (IdentifierException & e) {
+			logFile << timeString << " : Error in \"" << filePath << "\" | Line " << e.lineNumber <<
+				": Identifier \"" << e.id << "\" of type \"" << e.type << "\" : " << e.message << std::endl;
+		}
+		catch (OpenStringLiteralException & e) {
+			logFile << timeString << " : Error in \"" << filePath << "\" | Line " << e.lineNumber <<
+				": Ending quote of string literal was not found!" << std::endl;
+		}
+		catch (std::exception & e) {
+			// broken level is skipped, so the other errors are logged too
+			logFile << timeString << " : Error in \"" << filePath << "\" : " << e.what() << std::endl;
+		}
+
+		return nullptr;
+	}
+
+	// Loads the level file. Errors are written into the log.
+	std::unique_ptr<Level> loadLevelAndLog(const std::string & filePath) {
+		return loadAndLog(filePath, [&filePath]() {
+			PS_PROFILE_SCOPE("loadLevelFile");
+			return loadLevelFile(filePath);
+		}, "parsed successfuly!");
+	}
+
+	// Loads the edited level file as new version of the previous level. Errors are written into the log (the level is usually edited,
+	// while the game runs, so the errors are expected).
+	std::unique_ptr<Level> reloadLevelAndLog(const std::string & filePath, const Level & previous) {
+		std::unique_ptr<Level> level = loadAndLog(filePath, [&filePath, &previous]() { return reloadLevelFile(filePath, previous); },
+			"reloaded successfuly!");
+		if (level)
+			TextureCache::getInstance().uploadTextures();	// textures added to the level by the edit
+		return level;
+	}
+
+	Game::Game() : levelStreamer(loadLevelAndLog), levelWatcher(reloadLevelAndLog), resolutionController(1000.0 / 60.0)
 	{
 		walkForce = 200.0f;
 		ascendForce = 20.0f;
@@ -41,56 +118,54 @@ namespace ps {
 		walkDragCoefficient2 = 10.0f;
 		rotateDragCoefficient = 100.0f;
 
+		simulationTimeStep = 1.0f / 120.0f;
+		maxFrameTime = 0.25f;
+
 		infoEnabled = false;
+		softwareRendering = false;
+		dynamicResolution = false;
+		statsFrame = 0;
+
+		// columns of the screen are rendered by all available cores
+		caster.setThreadCount(getMax(std::thread::hardware_concurrency(), 1u));
+
+		// frame time stays bounded, when the player looks into a portal loop (it is enough for full recursion depth in 1080p)
+		caster.setRayStepBudget(1920 * 24);
 	}
 
 	void Game::loadLevels(const std::string & levelDirPath) {
 		using namespace std::experimental::filesystem;
-		using namespace std::chrono;
-
-		std::ofstream logFile;
-		logFile.open("log.txt", std::ios_base::app);	// opens file in append mode
 
+		std::vector<std::string> filePaths;
 		for (const path & file : directory_iterator(levelDirPath)) {
-			if (is_regular_file(file)) {
-				std::string filePath = file.string();
-
-				time_point<system_clock> time = system_clock::now();
-				std::time_t ttime = system_clock::to_time_t(time);
-				std::string timeString = std::string(std::ctime(&ttime)); // TODO : this may be unsafe
-				timeString.pop_back();	// ctime inserts a line-feed character at the end => pop it
+			// compiled levels cached next to the sources are not levels of their own
+			if (is_regular_file(file) && !isCompiledLevelPath(file.string()))
+				filePaths.push_back(file.string());
+		}
 
-				try {
-					std::ifstream fileStream;
-					fileStream.open(filePath);
+		// order of the directory entries is not specified, levels are played in the order of their names
+		std::sort(filePaths.begin(), filePaths.end());
 
-					LevelLoader loader(fileStream);
-					levels.push_back(loader.loadLevel());
+		levelStreamer.start(std::move(filePaths));
+	}
 
-					logFile << timeString << " : \"" << filePath << "\" parsed successfuly!" << std::endl;
+	std::unique_ptr<Level> Game::takeNextLevel()
+	{
+		std::unique_ptr<Level> level = levelStreamer.takeNext();
+		if (level)
+			levelWatcher.watch(levelStreamer.getCurrentFile());
+		else
+			levelWatcher.stop();
 
-					fileStream.close();
-				}
-				catch (UnexpectedTokenException & e) {
-					std::string expectedType = getTokenString(e.expected);
-					std::string actualType = getTokenString(e.actual);
-					logFile << timeString << " : Syntax error in \"" << filePath << "\" | Line " << e.lineNumber << 
-						": Expected: \"" << expectedType << "\", but \"" << actualType << "\" was read!" << std::endl;
-				}
-				catch (TexureLoadFailedException & e) {
-					logFile << timeString << " : Error in \"" << filePath << "\" | Line " << e.lineNumber << 
-						": Texture could not be loaded from \"" << e.path << "\"!" << std::endl;
-				}
-				catch (IdentifierException & e) {
-					logFile << timeString << " : Error in \"" << filePath << "\" | Line " << e.lineNumber <<
-						": Identifier \"" << e.id << "\" of type \"" << e.type << "\" : " << e.message << std::endl;
-				}
-				catch (OpenStringLiteralException & e) {
-					logFile << timeString << " : Error in \"" << filePath << "\" | Line " << e.lineNumber <<
-						": Ending quote of string literal was not found!" << std::endl;
-				}
-			}
+		std::ofstream logFile;
+		logFile.open("log.txt", std::ios_base::app);
+		if (level) {
+			TextureCache & textureCache = TextureCache::getInstance();
+			logFile << "Level switched in " << levelStreamer.getLastSwapMs() << " ms (" << textureCache.getTextureCount() <<
+				" textures, " << textureCache.getTextureMemory() / 1024 << " KiB)" << std::endl;
 		}
+
+		return level;
 	}
 
 	void processBasicEvent(sf::RenderWindow & window, sf::Event & e) {
@@ -110,6 +185,9 @@ namespace ps {
 	{
 		sf::Sprite splash;
 		splash.setTexture(splashTex);
+
+		sf::Text loading{ "Loading levels...", Game::textFont };
+		loading.setFillColor(sf::Color::Black);
 		
 		bool enterPressed = false;
 		do {
@@ -126,48 +204,234 @@ namespace ps {
 			splash.setScale(sX, sY);
 
 			window.draw(splash);
+			if (!levelStreamer.isReady())
+				window.draw(loading);
 			window.display();
-		} while (!enterPressed && window.isOpen());
+		} while (!(enterPressed && levelStreamer.isReady()) && window.isOpen());
 	}
 
 	void Game::runGameplay(Level & level, sf::RenderWindow & window)
 	{
-		auto && scene = level.makeScene();
+		using namespace std::chrono;
+
+		Scene scene = level.makeScene();
+		// textures of the previous level may be released, their CPU copies must not be used for new textures at the same address
+		frameBuffer.clearTextures();
 		// get the clock object
 		sf::Clock clock;
 		float deltaTime = 0.001f;
 
+		// simulation thread has its own copy of the camera and only reads the segments of the scene, camera of the scene is only used
+		// for rendering
+		Camera simulatedCamera = scene.camera;
+		TripleBuffer<CameraSnapshot> snapshots{ CameraSnapshot(scene.camera, steady_clock::now()) };
+		std::atomic<bool> simulationRunning{ true };
+		std::exception_ptr simulationError;
+		auto startSimulation = [&]() {
+			simulationRunning = true;
+			return std::thread{ [&]() {
+				try {
+					runSimulation(simulatedCamera, snapshots, simulationRunning);
+				}
+				catch (...) {
+					simulationError = std::current_exception();
+					simulationRunning = false;
+				}
+			} };
+		};
+		std::thread simulation = startSimulation();
+
 		bool finish = false;
 		do
 		{
+			PS_PROFILE_SCOPE("frame");
+
 			// measure the time elapsed from the last draw
 			deltaTime = clock.getElapsedTime().asSeconds();
 			clock.restart();
 
-			sf::Event e;
-			while (window.pollEvent(e)) {
-				processBasicEvent(window, e);
+			{
+				PS_PROFILE_SCOPE("pollEvents");
+				sf::Event e;
+				while (window.pollEvent(e)) {
+					processBasicEvent(window, e);
+
+					// Toggle info drawing on pressing F1
+					if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::F1)
+						infoEnabled = !infoEnabled;
+
+					// Toggle software rendering on pressing F2
+					if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::F2)
+						softwareRendering = !softwareRendering;
+
+					// Toggle span traversal on pressing F3
+					if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::F3)
+						caster.setSpanTraversal(!caster.getSpanTraversal());
+
+					// Toggle recording of render statistics on pressing F4
+					if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::F4)
+						toggleStatsRecording();
+
+					// Toggle dynamic resolution on pressing F5
+					if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::F5) {
+						dynamicResolution = !dynamicResolution;
+						resolutionController.reset();
+					}
+				}
+			}
 
-				// Toggle info drawing on pressing F1
-				if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::F1)
-					infoEnabled = !infoEnabled;
+			std::unique_ptr<Level> reloaded = levelWatcher.poll(level);
+			if (reloaded) {
+				// simulation reads the geometry of the level, so it is stopped while the level is replaced
+				simulationRunning = false;
+				simulation.join();
+				if (simulationError)
+					std::rethrow_exception(simulationError);
+
+				// camera stays where it is, if its segment (or a neighbour of it) still contains its position, or if only one segment
+				// contains it (segments keep their ids while they keep the order of the first references in the file, overlapping segments
+				// can be anywhere in the level), otherwise it starts at the initial position of the reloaded level
+				ObjectInScene pose = snapshots.getReadBuffer().current;
+				level = std::move(*reloaded);
+				scene = level.makeScene();
+				const LevelGeometry & geometry = scene.getGeometry();
+				const Portal * portal = geometry.findNeighbourPortal(toVector2(pose.getPosition()), pose.getSegmentId());
+				if (portal) {
+					portal->stepThrough(pose);
+				}
+				else if (!geometry.isInSegment(pose.getSegmentId(), toVector2(pose.getPosition()))) {
+					std::vector<std::size_t> segments = geometry.findSegments(toVector2(pose.getPosition()));
+					if (segments.size() == 1)
+						pose.moveIntoSegment(segments.front());
+				}
+				if (geometry.isInSegment(pose.getSegmentId(), toVector2(pose.getPosition())))
+					scene.camera.setPose(pose);
+				frameBuffer.clearTextures();
+
+				simulatedCamera = scene.camera;
+				snapshots.getWriteBuffer() = CameraSnapshot(scene.camera, steady_clock::now());
+				snapshots.publish();
+				simulation = startSimulation();
+
+				std::ofstream logFile;
+				logFile.open("log.txt", std::ios_base::app);
+				logFile << "Level reloaded in " << levelWatcher.getLastReloadMs() << " ms" << std::endl;
 			}
 
-			processGameInput(window, scene, deltaTime);
-			simulateDrag(scene);
-			scene.camera.simulate(deltaTime);
+			// steps are simulated ahead of their time, so the frame is rendered from the pose between the last two of them
+			snapshots.update();
+			const CameraSnapshot & snapshot = snapshots.getReadBuffer();
+			float alpha = 1.0f - duration<float>(snapshot.time - steady_clock::now()).count() / simulationTimeStep;
+			scene.camera.setPose(snapshot.interpolate(getMin(getMax(alpha, 0.0f), 1.0f)));
 
 			window.clear(sf::Color::Black);			// clear the window
-			caster.render(window, scene);			// render the game
+			renderScene(window, scene);
+
+			if (statsFile.is_open())
+				writeStatsCsvRow(statsFile, statsFrame++, caster.getStats());
 			
-			if (infoEnabled)
-				drawInfo(window, scene, deltaTime);		// draw some additional info like position, direction, fps
+			if (infoEnabled) {
+				PS_PROFILE_SCOPE("drawInfo");
+				drawInfo(window, level, scene, deltaTime);		// draw some additional info like position, direction, fps
+			}
 
-			Segment & cameraSegment = scene.getSegment(scene.camera.getSegmentId());
+			const Segment & cameraSegment = scene.getSegment(snapshot.current.getSegmentId());
 			finish = cameraSegment.finish;
 
-			window.display();
-		} while (finish == false && window.isOpen());
+			{
+				PS_PROFILE_SCOPE("display");
+				window.display();
+			}
+		} while (finish == false && window.isOpen() && simulationRunning);
+
+		simulationRunning = false;
+		simulation.join();
+		if (simulationError)
+			std::rethrow_exception(simulationError);
+	}
+
+	void Game::runSimulation(Camera camera, TripleBuffer<CameraSnapshot> & snapshots, std::atomic<bool> & running)
+	{
+		using namespace std::chrono;
+
+		steady_clock::duration step = duration_cast<steady_clock::duration>(duration<float>(simulationTimeStep));
+		steady_clock::duration maxDelay = duration_cast<steady_clock::duration>(duration<float>(maxFrameTime));
+		steady_clock::time_point stepTime = steady_clock::now();
+
+		while (running) {
+			stepTime += step;
+			ObjectInScene previousPose = camera;
+			{
+				PS_PROFILE_SCOPE("processGameInput");
+				processGameInput(camera);
+			}
+			{
+				PS_PROFILE_SCOPE("simulateDrag");
+				simulateDrag(camera);
+			}
+			{
+				PS_PROFILE_SCOPE("simulateCamera");
+				camera.simulate(simulationTimeStep);
+				camera.recoverSegment();
+			}
+
+			snapshots.getWriteBuffer() = CameraSnapshot(previousPose, camera, stepTime);
+			snapshots.publish();
+
+			// steps run at fixed rate, the late ones are run immediately to catch up (unless they are too late)
+			steady_clock::time_point now = steady_clock::now();
+			if (now - stepTime > maxDelay)
+				stepTime = now;
+			std::this_thread::sleep_until(stepTime);
+		}
+	}
+
+	void Game::renderScene(sf::RenderWindow & window, const Scene & scene)
+	{
+		PS_PROFILE_SCOPE("render");
+		sf::Clock renderClock;
+
+		sf::Vector2u windowSize = window.getSize();
+		sf::Vector2u renderSize = (dynamicResolution) ? resolutionController.getRenderSize(windowSize) : windowSize;
+
+		if (softwareRendering) {
+			frameBuffer.resize(renderSize.x, renderSize.y);
+			frameBuffer.clear(sf::Color::Black);
+			caster.render(frameBuffer, scene);	// render the game on CPU ...
+			frameBuffer.display(window);		// ... and upload it (it is stretched over the window)
+		}
+		else if (dynamicResolution) {
+			// render texture only grows, the frame is rendered into its corner and stretched over the window
+			if (scaledTarget.getSize().x < windowSize.x || scaledTarget.getSize().y < windowSize.y)
+				scaledTarget.create(windowSize.x, windowSize.y);
+
+			scaledTarget.clear(sf::Color::Black);
+			caster.render(scaledTarget, renderSize.x, renderSize.y, scene);
+			scaledTarget.display();
+
+			sf::Sprite sprite(scaledTarget.getTexture(), sf::IntRect(0, 0, (int)renderSize.x, (int)renderSize.y));
+			sprite.setScale((float)windowSize.x / renderSize.x, (float)windowSize.y / renderSize.y);
+			window.draw(sprite);
+		}
+		else {
+			caster.render(window, scene);		// render the game
+		}
+
+		if (dynamicResolution)
+			resolutionController.update(renderClock.getElapsedTime().asMicroseconds() / 1000.0);
+	}
+
+	void Game::toggleStatsRecording()
+	{
+		if (statsFile.is_open()) {
+			statsFile.close();
+			return;
+		}
+
+		statsFile.open("render_stats.csv");
+		statsFrame = 0;
+		if (statsFile.is_open())
+			writeStatsCsvHeader(statsFile);
 	}
 
 	void Game::runWinScreen(sf::RenderWindow & window)
@@ -189,46 +453,46 @@ namespace ps {
 		} 
 	}
 
-	void Game::processGameInput(sf::RenderWindow & window, Scene & scene, float deltaTime)
+	void Game::processGameInput(FloatingObjInScene & camera)
 	{
-		auto direction = ps::toVector3(scene.camera.getDirection());
+		auto direction = ps::toVector3(camera.getDirection());
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::W)) {
-			scene.camera.applyForce(walkForce * direction);
+			camera.applyForce(walkForce * direction);
 		}
 
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::S)) {
-			scene.camera.applyForce(-1.0f * walkForce * direction);
+			camera.applyForce(-1.0f * walkForce * direction);
 		}
 
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::A)) {
-			scene.camera.applyTorque(rotateTorque);
+			camera.applyTorque(rotateTorque);
 		}
 
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::D)) {
-			scene.camera.applyTorque(-1.0f * rotateTorque);
+			camera.applyTorque(-1.0f * rotateTorque);
 		}
 
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::Q)) {
-			scene.camera.applyForce(ascendForce * sf::Vector3f(0.0f, 0.0f, 1.0f));
+			camera.applyForce(ascendForce * sf::Vector3f(0.0f, 0.0f, 1.0f));
 		}
 
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::E)) {
-			scene.camera.applyForce(ascendForce * sf::Vector3f(0.0f, 0.0f, -1.0f));
+			camera.applyForce(ascendForce * sf::Vector3f(0.0f, 0.0f, -1.0f));
 		}
 	}
 	
-	void Game::simulateDrag(Scene & scene) {
-		auto speed = scene.camera.getSpeed();
-		auto angularSpeed = scene.camera.getAngularSpeed();
+	void Game::simulateDrag(FloatingObjInScene & camera) {
+		auto speed = camera.getSpeed();
+		auto angularSpeed = camera.getAngularSpeed();
 
 		auto walkDrag = -1.0f * walkDragCoefficient1 * speed - walkDragCoefficient2 * norm(speed) * speed;
 		auto rotateDrag = -1.0f * angularSpeed * rotateDragCoefficient;
 
-		scene.camera.applyForce(walkDrag);
-		scene.camera.applyTorque(rotateDrag);
+		camera.applyForce(walkDrag);
+		camera.applyTorque(rotateDrag);
 	}
 
-	void Game::drawInfo(sf::RenderTarget & window, Scene & scene, float secondsElapsed)
+	void Game::drawInfo(sf::RenderTarget & window, const Level & level, Scene & scene, float secondsElapsed)
 	{
 		sf::Text info{ "N/A", Game::textFont };
 		info.setFillColor(sf::Color::Black);
@@ -238,13 +502,33 @@ namespace ps {
 		auto direction = scene.camera.getDirection();
 		auto segmentId = scene.camera.getSegmentId();
 
-		info.setString(
+		std::string text =
 			"pos = (" + std::to_string(position.x) + "," + std::to_string(position.y) + "," + std::to_string(position.z) + ")\n" +
 			"dir = (" + std::to_string(direction.x) + "," + std::to_string(direction.y) + ")\n" +
 			"segment = " + std::to_string(segmentId) + "\n" +
-			"fps = " + std::to_string((int)(1.0f / secondsElapsed))
-		);
-
+			"visible segments = " + std::to_string(level.getVisibility().getVisibleSegments(segmentId).size()) + "/" + std::to_string(scene.getSegmentCount()) + "\n" +
+			"level switch = " + std::to_string(levelStreamer.getLastSwapMs()) + " ms\n" +
+			"level reload = " + std::to_string(levelWatcher.getLastReloadMs()) + " ms\n" +
+			"ray steps = " + std::to_string(caster.getRayStepCount()) + "/" + std::to_string(caster.getRayStepBudget()) + "\n" +
+			((dynamicResolution) ? "resolution scale = " + std::to_string(resolutionController.getHorizontalScale()) + " x " +
+				std::to_string(resolutionController.getVerticalScale()) + "\n" : "") +
+			"fps = " + std::to_string((int)(1.0f / secondsElapsed));
+
+#ifdef PS_RENDER_STATS
+		// statistics of the last frame explain, why the frame took so long
+		const RenderStats & stats = caster.getStats();
+		const RenderCounters & counters = stats.counters;
+		text += "\n"
+			"rays = " + std::to_string(counters.raysGenerated) + ", wall tests = " + std::to_string(counters.wallTests) +
+			" (back-facing " + std::to_string(counters.backFacingWalls) + ")\n" +
+			"portal traversals = " + std::to_string(counters.portalTraversals) + ", depth max = " + std::to_string(counters.maxDepth) +
+			", mean = " + std::to_string(counters.getMeanDepth()) + "\n" +
+			"draw calls = " + std::to_string(stats.drawCalls) + ", floor/ceiling strips = " + std::to_string(counters.floorCeilingStrips) + "\n" +
+			"cast = " + std::to_string(stats.castMs) + " ms, merge = " + std::to_string(stats.mergeMs) + " ms, draw = " + std::to_string(stats.drawMs) + " ms" +
+			((statsFile.is_open()) ? "\nrecording stats" : "");
+#endif
+
+		info.setString(text);
 		window.draw(info);
 	}
 
@@ -259,10 +543,15 @@ namespace ps {
 
 		runSplashScreen(window);
 
-		for (Level & level : levels)
-			runGameplay(level, window);
+		// level being played is released only after the next one is taken, so the textures they share stay uploaded
+		for (auto level = takeNextLevel(); level; level = takeNextLevel())
+			runGameplay(*level, window);
 
 		runWinScreen(window);
+
+#ifdef PS_PROFILING
+		Profiler::writeChromeTrace("trace.json");
+#endif
 	}
 
 }
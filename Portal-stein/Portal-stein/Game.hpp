@@ -3,7 +3,14 @@
 #define PS_GAME_INCLUDED
 #include "RayCaster.hpp"
 #include "Level.hpp"
+#include "TripleBuffer.hpp"
+#include "ResolutionController.hpp"
+#include "LevelStreamer.hpp"
+#include "LevelWatcher.hpp"
 #include <vector>
+#include <string>
+#include <fstream>
+#include <atomic>
 
 namespace ps {
 
@@ -15,17 +22,35 @@ namespace ps {
 		static sf::Texture winTex;				///< Texture for win screen.
 
 		bool infoEnabled;
-		std::vector<Level> levels;
+		bool softwareRendering;		///< If set, frames are rasterized on CPU into frameBuffer and uploaded once per frame.
+		LevelStreamer levelStreamer;	///< Prepares the next levels while the current one is played.
+		LevelWatcher levelWatcher;		///< Reloads the current level when its file is edited.
 		RayCaster caster;
+		FrameBuffer frameBuffer;
+		bool dynamicResolution;				///< If set, frames are rendered in the resolution chosen by resolutionController and upscaled.
+		ResolutionController resolutionController;
+		sf::RenderTexture scaledTarget;		///< Frames rendered on GPU in lower resolution are rendered into its top-left corner.
+		std::ofstream statsFile;	///< CSV file the render statistics of each frame are written to (when it is open).
+		std::size_t statsFrame;		///< Number of frames written to statsFile.
 
-		void simulateDrag(Scene & scene);
-		void processGameInput(sf::RenderWindow & window, Scene & caster, float deltaTime);
-		void drawInfo(sf::RenderTarget & window, Scene & scene, float secondsElapsed);
+		void simulateDrag(FloatingObjInScene & camera);
+		void processGameInput(FloatingObjInScene & camera);
+		void drawInfo(sf::RenderTarget & window, const Level & level, Scene & scene, float secondsElapsed);
+		/// Starts writing render statistics of each frame into CSV file, or stops it if it is already being written.
+		void toggleStatsRecording();
+		/// Renders the scene into the window (in the resolution chosen by resolutionController, if dynamicResolution is set).
+		void renderScene(sf::RenderWindow & window, const Scene & scene);
 
-		/// Runs part of the game, when splash screen is showed.
+		/// Takes the next level from levelStreamer and writes the time of the switch into the log. Returns nullptr after the last level.
+		std::unique_ptr<Level> takeNextLevel();
+		/// Runs part of the game, when splash screen is showed. It is showed until the first level is loaded.
 		void runSplashScreen(sf::RenderWindow & window);
-		/// Runs specific level.
+		/// Runs specific level. Camera is simulated by another thread (see runSimulation()), this thread renders the snapshots it publishes.
+		/// When the file of the level is edited, the level is replaced by the reloaded one (the camera stays where it is, if its segment
+		/// still exists).
 		void runGameplay(Level & level, sf::RenderWindow & window);
+		/// Simulates the camera in fixed steps, until running is cleared. Snapshot of the camera is published after each step.
+		void runSimulation(Camera camera, TripleBuffer<CameraSnapshot> & snapshots, std::atomic<bool> & running);
 		/// Runs final part of the game, when win screen is showed.
 		void runWinScreen(sf::RenderWindow & window);
 
@@ -39,11 +64,15 @@ namespace ps {
 		float walkDragCoefficient2;
 		float rotateDragCoefficient;
 
+		float simulationTimeStep;	///< Length of one simulation step (in seconds). Movement does not depend on the frame rate.
+		float maxFrameTime;			///< Simulation that falls behind by more than this (in seconds) skips the missed steps instead of catching up.
+
 		/// Loads the font and the textures used in Game class. This must be called prior to using the Game class.
 		static void init();
 		Game();
 
-		/// Loads all the levels in specified directory.
+		/// Starts loading the levels in specified directory. Levels are loaded in background several levels ahead of the player, so this
+		/// returns immediately. They are played in the order of their file names. Errors are written into log.txt.
 		/// \param levelDirPath Directory where to look for level files.
 		void loadLevels(const std::string & levelDirPath);
 		/// Runs the game. 
@@ -17,32 +17,108 @@ namespace ps {
 
 	void LineSegment::mapLineSegments(const LineSegment & a, const LineSegment & b, ObjectInScene & obj)
 	{
-		auto aDirection = a.to - a.from;
-		auto bDirection = b.to - b.from;
-		float aSegmentLength = norm(aDirection);
-		float bSegmentLength = norm(bDirection);
+		AffineTransform::mapLineSegments(a, b).apply(obj);
+	}
 
-		float angleOfA = angleBetween(aDirection, sf::Vector2f{ 1.0f, 0.0f });
-		float angleFromAtoB = angleBetween(aDirection, bDirection);
+	AffineTransform::AffineTransform() : AffineTransform(Matrix2<float>(1.0f, 0.0f, 0.0f, 1.0f), sf::Vector2f(0.0f, 0.0f), 1.0f, 0.0f)
+	{
+	}
 
-		sf::Vector2f position2D = toVector2(obj.getPosition());
+	AffineTransform::AffineTransform(const Matrix2<float> & linear_, const sf::Vector2f & translation_, float cosRotation_, float sinRotation_) :
+		linear(linear_), translation(translation_), cosRotation(cosRotation_), sinRotation(sinRotation_)
+	{
+	}
 
-		position2D -= a.from;					// move a.from to origin
+	AffineTransform AffineTransform::mapLineSegments(const LineSegment & a, const LineSegment & b)
+	{
+		auto aDirection = normalized(a.getTo() - a.getFrom());
+		auto bDirection = normalized(b.getTo() - b.getFrom());
+		float scale = norm(b.getTo() - b.getFrom()) / norm(a.getTo() - a.getFrom());
+
+		// rotation from direction of a to direction of b
+		float cosAngle = dot(aDirection, bDirection);
+		float sinAngle = cross(aDirection, bDirection);
+		Matrix2<float> rotation{ cosAngle, -sinAngle, sinAngle, cosAngle };
+
+		// scaling along direction of a: I + (scale - 1) * aDirection * aDirection^T
+		float k = scale - 1.0f;
+		Matrix2<float> scaling{
+			1.0f + k * aDirection.x * aDirection.x, k * aDirection.x * aDirection.y,
+			k * aDirection.y * aDirection.x, 1.0f + k * aDirection.y * aDirection.y };
+
+		// linear = rotation * scaling, point a.from is mapped to b.from
+		Matrix2<float> linear;
+		for (std::size_t row = 0; row < 2; ++row) {
+			for (std::size_t column = 0; column < 2; ++column) {
+				linear.setElement(row, column,
+					rotation.getElement(row, 0) * scaling.getElement(0, column) + rotation.getElement(row, 1) * scaling.getElement(1, column));
+			}
+		}
 
-		ps::rotate(position2D, angleOfA);					// rotate a.direction to positive x-axis
-		position2D.x *= (bSegmentLength / aSegmentLength);	// scale by desired amount the x coordinate
-		ps::rotate(position2D, -angleOfA);					// rotate a.direction back
+		sf::Vector2f translation = b.getFrom() - matrixMultiply(linear, a.getFrom());
+		return AffineTransform(linear, translation, cosAngle, sinAngle);
+	}
 
-		ps::rotate(position2D, angleFromAtoB);				// rotate by desired angle
-		position2D += b.from;								// move origin to b.from
+	AffineTransform AffineTransform::inverse() const
+	{
+		float determinant = linear.determinant();
+		Matrix2<float> inverseLinear{
+			linear.getElement(1, 1) / determinant, -linear.getElement(0, 1) / determinant,
+			-linear.getElement(1, 0) / determinant, linear.getElement(0, 0) / determinant };
 
-		// This whole tranformation can be expressed as move + rotation
-		sf::Vector2f finalOffset = position2D - sf::Vector2f{ obj.position.x, obj.position.y };
-		float finalRotation = angleFromAtoB;
+		sf::Vector2f inverseTranslation = -1.0f * matrixMultiply(inverseLinear, translation);
+		return AffineTransform(inverseLinear, inverseTranslation, cosRotation, -sinRotation);
+	}
+
+	AffineTransform AffineTransform::then(const AffineTransform & next) const
+	{
+		// columns of the linear part are the images of the axes
+		Matrix2<float> composedLinear{
+			matrixMultiply(next.linear, sf::Vector2f(linear.getElement(0, 0), linear.getElement(1, 0))),
+			matrixMultiply(next.linear, sf::Vector2f(linear.getElement(0, 1), linear.getElement(1, 1))) };
+
+		return AffineTransform(composedLinear, next.transformPoint(translation),
+			cosRotation * next.cosRotation - sinRotation * next.sinRotation, sinRotation * next.cosRotation + cosRotation * next.sinRotation);
+	}
+
+	const Matrix2<float> & AffineTransform::getLinear() const
+	{
+		return linear;
+	}
 
-		// Apply the actual transformation to object.
-		obj.position += toVector3(finalOffset);
-		obj.rotate(finalRotation);
+	const sf::Vector2f & AffineTransform::getTranslation() const
+	{
+		return translation;
+	}
+
+	float AffineTransform::getCosRotation() const
+	{
+		return cosRotation;
+	}
+
+	float AffineTransform::getSinRotation() const
+	{
+		return sinRotation;
+	}
+
+	sf::Vector2f AffineTransform::transformPoint(const sf::Vector2f & point) const
+	{
+		return matrixMultiply(linear, point) + translation;
+	}
+
+	sf::Vector2f AffineTransform::transformDirection(const sf::Vector2f & direction) const
+	{
+		sf::Vector2f result = direction;
+		ps::rotate(result, cosRotation, sinRotation);
+		return result;
+	}
+
+	void AffineTransform::apply(ObjectInScene & obj) const
+	{
+		sf::Vector2f position2D = transformPoint(toVector2(obj.position));
+		obj.position.x = position2D.x;
+		obj.position.y = position2D.y;
+		obj.rotate(cosRotation, sinRotation);
 	}
 
 	RayLineSegmentIntersection intersect(const Ray & ray, const LineSegment & lineSegment)
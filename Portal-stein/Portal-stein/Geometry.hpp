@@ -2,6 +2,7 @@
 #ifndef PS_GEOMETRY_INCLUDED
 #define PS_GEOMETRY_INCLUDED
 #include "ObjectInScene.hpp"
+#include "Solve.hpp"
 
 namespace ps {
 
@@ -42,6 +43,46 @@ namespace ps {
 		static void mapLineSegments(const LineSegment & a, const LineSegment & b, ObjectInScene & obj);
 	};
 
+	/// Affine transformation of the plane, that maps point p to (linear * p + translation) (2x3 matrix). Directions are only rotated
+	/// (rotation is stored along the matrix), so they are not skewed by the scaling part of the transformation.
+	class AffineTransform {
+	private:
+		Matrix2<float> linear;
+		sf::Vector2f translation;
+		float cosRotation;	///< Cosine of the angle directions are rotated by.
+		float sinRotation;	///< Sine of the angle directions are rotated by.
+
+	public:
+		/// Creates identity transformation.
+		AffineTransform();
+		/// Creates transformation from its matrix and rotation of directions (given by cosine and sine of the angle).
+		AffineTransform(const Matrix2<float> & linear_, const sf::Vector2f & translation_, float cosRotation_, float sinRotation_);
+
+		/// Makes the transformation, that maps line segment a onto line segment b (the same mapping as LineSegment::mapLineSegments).
+		/// Segment a is scaled along its direction to the length of b, rotated to the direction of b and moved onto b.
+		static AffineTransform mapLineSegments(const LineSegment & a, const LineSegment & b);
+		/// Makes the inverse transformation (it maps the wall the portal leads to back onto the wall the portal is in).
+		AffineTransform inverse() const;
+		/// Makes the transformation, that applies this transformation first and the next one after it.
+		AffineTransform then(const AffineTransform & next) const;
+
+		/// Gets the linear part of the transformation of points.
+		const Matrix2<float> & getLinear() const;
+		/// Gets the translation of points (it is applied after the linear part).
+		const sf::Vector2f & getTranslation() const;
+		/// Gets cosine of the angle directions are rotated by.
+		float getCosRotation() const;
+		/// Gets sine of the angle directions are rotated by.
+		float getSinRotation() const;
+
+		/// Transforms a point.
+		sf::Vector2f transformPoint(const sf::Vector2f & point) const;
+		/// Transforms a direction (it is only rotated).
+		sf::Vector2f transformDirection(const sf::Vector2f & direction) const;
+		/// Transforms position and direction of the object (z coordinate is not changed).
+		void apply(ObjectInScene & obj) const;
+	};
+
 	/// Intersects a 2D ray and line segment.
 	RayLineSegmentIntersection intersect(const Ray & ray, const LineSegment & lineSegment);
 
@@ -0,0 +1,326 @@
+#include "Intersect.hpp"
+
+#if defined(PS_SIMD_AVX)
+#include <immintrin.h>
+#elif defined(PS_SIMD_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace ps {
+
+	//**************************************************************************
+	// SIMD HELPERS
+	//**************************************************************************
+
+#if defined(PS_SIMD_AVX)
+	using SimdFloats = __m256;
+	const std::size_t simdLanes = 8;
+
+	inline SimdFloats simdLoad(const float * p) { return _mm256_loadu_ps(p); }
+	inline void simdStore(float * p, SimdFloats a) { _mm256_storeu_ps(p, a); }
+	inline SimdFloats simdSplat(float x) { return _mm256_set1_ps(x); }
+	inline SimdFloats simdLaneIndices(std::size_t first) { return _mm256_add_ps(_mm256_set1_ps((float)first), _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7)); }
+	inline SimdFloats simdSub(SimdFloats a, SimdFloats b) { return _mm256_sub_ps(a, b); }
+	inline SimdFloats simdMul(SimdFloats a, SimdFloats b) { return _mm256_mul_ps(a, b); }
+	inline SimdFloats simdDiv(SimdFloats a, SimdFloats b) { return _mm256_div_ps(a, b); }
+	inline SimdFloats simdAnd(SimdFloats a, SimdFloats b) { return _mm256_and_ps(a, b); }
+	inline SimdFloats simdGreater(SimdFloats a, SimdFloats b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	inline SimdFloats simdGreaterEqual(SimdFloats a, SimdFloats b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	inline SimdFloats simdLess(SimdFloats a, SimdFloats b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	inline SimdFloats simdLessEqual(SimdFloats a, SimdFloats b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	inline SimdFloats simdSelect(SimdFloats mask, SimdFloats a, SimdFloats b) { return _mm256_blendv_ps(b, a, mask); }
+	inline int simdMask(SimdFloats mask) { return _mm256_movemask_ps(mask); }
+#elif defined(PS_SIMD_SSE2)
+	using SimdFloats = __m128;
+	const std::size_t simdLanes = 4;
+
+	inline SimdFloats simdLoad(const float * p) { return _mm_loadu_ps(p); }
+	inline void simdStore(float * p, SimdFloats a) { _mm_storeu_ps(p, a); }
+	inline SimdFloats simdSplat(float x) { return _mm_set1_ps(x); }
+	inline SimdFloats simdLaneIndices(std::size_t first) { return _mm_add_ps(_mm_set1_ps((float)first), _mm_setr_ps(0, 1, 2, 3)); }
+	inline SimdFloats simdSub(SimdFloats a, SimdFloats b) { return _mm_sub_ps(a, b); }
+	inline SimdFloats simdMul(SimdFloats a, SimdFloats b) { return _mm_mul_ps(a, b); }
+	inline SimdFloats simdDiv(SimdFloats a, SimdFloats b) { return _mm_div_ps(a, b); }
+	inline SimdFloats simdAnd(SimdFloats a, SimdFloats b) { return _mm_and_ps(a, b); }
+	inline SimdFloats simdGreater(SimdFloats a, SimdFloats b) { return _mm_cmpgt_ps(a, b); }
+	inline SimdFloats simdGreaterEqual(SimdFloats a, SimdFloats b) { return _mm_cmpge_ps(a, b); }
+	inline SimdFloats simdLess(SimdFloats a, SimdFloats b) { return _mm_cmplt_ps(a, b); }
+	inline SimdFloats simdLessEqual(SimdFloats a, SimdFloats b) { return _mm_cmple_ps(a, b); }
+	inline SimdFloats simdSelect(SimdFloats mask, SimdFloats a, SimdFloats b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	inline int simdMask(SimdFloats mask) { return _mm_movemask_ps(mask); }
+#endif
+
+	// Ray (origin + t * direction) and wall (from + s * wallDirection) intersect, where
+	//     det = cross(wallDirection, direction)	... wall faces the ray if det > 0 (this is Wall::facesRay)
+	//     t = cross(wallDirection, from - origin) / det
+	//     s = cross(direction, from - origin) / det
+	// Range of the parameters is tested on the numerators, so only t needs division while searching for the nearest wall.
+
+	// Intersects one ray with one wall. Returns false if the wall does not face the ray, or if it is not hit.
+	inline bool intersectScalar(float fromX, float fromY, float wallX, float wallY, float originX, float originY, float directionX, float directionY,
+		float & rayParameter, float & wallParameter) {
+		float bX = fromX - originX;
+		float bY = fromY - originY;
+
+		float det = wallX * directionY - wallY * directionX;
+		float tNumerator = wallX * bY - wallY * bX;
+		float sNumerator = directionX * bY - directionY * bX;
+
+		if (!(0.0f < det && 0.0f <= tNumerator && 0.0f <= sNumerator && sNumerator <= det))
+			return false;
+
+		rayParameter = tNumerator / det;
+		wallParameter = sNumerator / det;
+		return true;
+	}
+
+
+
+	//**************************************************************************
+	// WALL ARRAYS
+	//**************************************************************************
+
+	constexpr std::size_t WallArrays::padding;
+
+	WallArrays::WallArrays() : count(0), fromX(), fromY(), directionX(), directionY() {
+	}
+
+	void WallArrays::add(const sf::Vector2f & from, const sf::Vector2f & to)
+	{
+		if (count == fromX.size()) {
+			// arrays are full => next block of padding walls is appended (zero direction makes det == 0, so the padding is never hit)
+			fromX.resize(count + padding, 0.0f);
+			fromY.resize(count + padding, 0.0f);
+			directionX.resize(count + padding, 0.0f);
+			directionY.resize(count + padding, 0.0f);
+		}
+
+		// wall replaces the first padding wall
+		fromX[count] = from.x;
+		fromY[count] = from.y;
+		directionX[count] = to.x - from.x;
+		directionY[count] = to.y - from.y;
+		count++;
+	}
+
+	std::size_t WallArrays::size() const
+	{
+		return count;
+	}
+
+	std::size_t WallArrays::paddedSize() const
+	{
+		return fromX.size();
+	}
+
+	WallRange::WallRange(const float * fromX_, const float * fromY_, const float * directionX_, const float * directionY_, std::size_t count_, std::size_t paddedCount_) :
+		fromX(fromX_), fromY(fromY_), directionX(directionX_), directionY(directionY_), count(count_), paddedCount(paddedCount_) {
+	}
+
+	WallRange::WallRange(const WallArrays & walls) : WallRange(walls.fromX.data(), walls.fromY.data(), walls.directionX.data(), walls.directionY.data(),
+		walls.size(), walls.paddedSize()) {
+	}
+
+
+
+	//**************************************************************************
+	// INTERSECTION KERNELS
+	//**************************************************************************
+
+	WallHit::WallHit() : wall(-1), rayParameter(std::numeric_limits<float>::infinity()), wallParameter(0.0f) {
+	}
+
+	constexpr std::size_t RayPacket::size;
+
+	void RayPacket::set(std::size_t index, const sf::Vector2f & origin, const sf::Vector2f & direction)
+	{
+		originX[index] = origin.x;
+		originY[index] = origin.y;
+		directionX[index] = direction.x;
+		directionY[index] = direction.y;
+	}
+
+	WallHit intersectWallsScalar(const WallRange & walls, const sf::Vector2f & origin, const sf::Vector2f & direction, float maxRayParameter)
+	{
+		WallHit result;
+
+		for (std::size_t i = 0; i < walls.size(); ++i) {
+			float t, s;
+			bool hit = intersectScalar(walls.fromX[i], walls.fromY[i], walls.directionX[i], walls.directionY[i], origin.x, origin.y, direction.x, direction.y, t, s);
+
+			if (hit && t <= maxRayParameter && t < result.rayParameter) {
+				result.wall = (int)i;
+				result.rayParameter = t;
+				result.wallParameter = s;
+			}
+		}
+
+		return result;
+	}
+
+	WallHit intersectWalls(const WallRange & walls, const sf::Vector2f & origin, const sf::Vector2f & direction, float maxRayParameter)
+	{
+#if defined(PS_SIMD_AVX) || defined(PS_SIMD_SSE2)
+		SimdFloats originX = simdSplat(origin.x);
+		SimdFloats originY = simdSplat(origin.y);
+		SimdFloats directionX = simdSplat(direction.x);
+		SimdFloats directionY = simdSplat(direction.y);
+		SimdFloats zero = simdSplat(0.0f);
+		SimdFloats maxT = simdSplat(maxRayParameter);
+
+		// each lane keeps the nearest hit of the walls it went through
+		SimdFloats bestT = simdSplat(std::numeric_limits<float>::infinity());
+		SimdFloats bestWall = simdSplat(-1.0f);
+
+		for (std::size_t i = 0; i < walls.paddedSize(); i += simdLanes) {
+			SimdFloats wallX = simdLoad(&walls.directionX[i]);
+			SimdFloats wallY = simdLoad(&walls.directionY[i]);
+			SimdFloats bX = simdSub(simdLoad(&walls.fromX[i]), originX);
+			SimdFloats bY = simdSub(simdLoad(&walls.fromY[i]), originY);
+
+			SimdFloats det = simdSub(simdMul(wallX, directionY), simdMul(wallY, directionX));
+			SimdFloats tNumerator = simdSub(simdMul(wallX, bY), simdMul(wallY, bX));
+			SimdFloats sNumerator = simdSub(simdMul(directionX, bY), simdMul(directionY, bX));
+			SimdFloats t = simdDiv(tNumerator, det);
+
+			SimdFloats hit = simdAnd(simdGreater(det, zero), simdGreaterEqual(tNumerator, zero));
+			hit = simdAnd(hit, simdAnd(simdGreaterEqual(sNumerator, zero), simdLessEqual(sNumerator, det)));
+			hit = simdAnd(hit, simdAnd(simdLessEqual(t, maxT), simdLess(t, bestT)));
+
+			bestT = simdSelect(hit, t, bestT);
+			bestWall = simdSelect(hit, simdLaneIndices(i), bestWall);
+		}
+
+		float laneT[simdLanes];
+		float laneWall[simdLanes];
+		simdStore(laneT, bestT);
+		simdStore(laneWall, bestWall);
+
+		// lanes are merged, so that ties go to the lowest wall index (the same as in the scalar version)
+		int wall = -1;
+		float t = std::numeric_limits<float>::infinity();
+		for (std::size_t k = 0; k < simdLanes; ++k) {
+			int laneWallIndex = (int)laneWall[k];
+			if (laneWallIndex >= 0 && (wall < 0 || laneT[k] < t || (laneT[k] == t && laneWallIndex < wall))) {
+				wall = laneWallIndex;
+				t = laneT[k];
+			}
+		}
+
+		WallHit result;
+		if (wall >= 0) {
+			// only the nearest wall gets its wall parameter computed
+			float bX = walls.fromX[wall] - origin.x;
+			float bY = walls.fromY[wall] - origin.y;
+			float det = walls.directionX[wall] * direction.y - walls.directionY[wall] * direction.x;
+
+			result.wall = wall;
+			result.rayParameter = t;
+			result.wallParameter = (direction.x * bY - direction.y * bX) / det;
+		}
+
+		return result;
+#else
+		return intersectWallsScalar(walls, origin, direction, maxRayParameter);
+#endif
+	}
+
+	std::size_t countBackFacingWalls(const WallRange & walls, const sf::Vector2f & direction)
+	{
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < walls.size(); ++i) {
+			if (walls.directionX[i] * direction.y - walls.directionY[i] * direction.x <= 0.0f)
+				count++;
+		}
+
+		return count;
+	}
+
+	void intersectWall(const WallRange & walls, std::size_t wall, const sf::Vector2f & origin, const sf::Vector2f & direction, WallHit & hit)
+	{
+		float t, s;
+		bool wallHit = intersectScalar(walls.fromX[wall], walls.fromY[wall], walls.directionX[wall], walls.directionY[wall],
+			origin.x, origin.y, direction.x, direction.y, t, s);
+
+		if (wallHit && t < hit.rayParameter) {
+			hit.wall = (int)wall;
+			hit.rayParameter = t;
+			hit.wallParameter = s;
+		}
+	}
+
+	void intersectWallScalar(const RayPacket & rays, const WallRange & walls, std::size_t wall, PacketHits & hits)
+	{
+		for (std::size_t k = 0; k < RayPacket::size; ++k) {
+			float t, s;
+			bool hit = intersectScalar(walls.fromX[wall], walls.fromY[wall], walls.directionX[wall], walls.directionY[wall],
+				rays.originX[k], rays.originY[k], rays.directionX[k], rays.directionY[k], t, s);
+
+			if (hit && t < hits[k].rayParameter) {
+				hits[k].wall = (int)wall;
+				hits[k].rayParameter = t;
+				hits[k].wallParameter = s;
+			}
+		}
+	}
+
+	void intersectWall(const RayPacket & rays, const WallRange & walls, std::size_t wall, PacketHits & hits)
+	{
+#if defined(PS_SIMD_AVX) || defined(PS_SIMD_SSE2)
+		SimdFloats fromX = simdSplat(walls.fromX[wall]);
+		SimdFloats fromY = simdSplat(walls.fromY[wall]);
+		SimdFloats wallX = simdSplat(walls.directionX[wall]);
+		SimdFloats wallY = simdSplat(walls.directionY[wall]);
+		SimdFloats zero = simdSplat(0.0f);
+
+		for (std::size_t i = 0; i < RayPacket::size; i += simdLanes) {
+			SimdFloats directionX = simdLoad(&rays.directionX[i]);
+			SimdFloats directionY = simdLoad(&rays.directionY[i]);
+			SimdFloats bX = simdSub(fromX, simdLoad(&rays.originX[i]));
+			SimdFloats bY = simdSub(fromY, simdLoad(&rays.originY[i]));
+
+			float currentT[simdLanes];
+			for (std::size_t k = 0; k < simdLanes; ++k)
+				currentT[k] = hits[i + k].rayParameter;
+
+			SimdFloats det = simdSub(simdMul(wallX, directionY), simdMul(wallY, directionX));
+			SimdFloats tNumerator = simdSub(simdMul(wallX, bY), simdMul(wallY, bX));
+			SimdFloats sNumerator = simdSub(simdMul(directionX, bY), simdMul(directionY, bX));
+			SimdFloats t = simdDiv(tNumerator, det);
+
+			SimdFloats hit = simdAnd(simdGreater(det, zero), simdGreaterEqual(tNumerator, zero));
+			hit = simdAnd(hit, simdAnd(simdGreaterEqual(sNumerator, zero), simdLessEqual(sNumerator, det)));
+			hit = simdAnd(hit, simdLess(t, simdLoad(currentT)));
+
+			int mask = simdMask(hit);
+			if (mask == 0)
+				continue;
+
+			float laneT[simdLanes];
+			float laneS[simdLanes];
+			simdStore(laneT, t);
+			simdStore(laneS, simdDiv(sNumerator, det));
+
+			for (std::size_t k = 0; k < simdLanes; ++k) {
+				if (mask & (1 << k)) {
+					hits[i + k].wall = (int)wall;
+					hits[i + k].rayParameter = laneT[k];
+					hits[i + k].wallParameter = laneS[k];
+				}
+			}
+		}
+#else
+		intersectWallScalar(rays, walls, wall, hits);
+#endif
+	}
+
+	void intersectWalls(const RayPacket & rays, const WallRange & walls, PacketHits & hits)
+	{
+		for (std::size_t k = 0; k < RayPacket::size; ++k)
+			hits[k] = WallHit();
+
+		for (std::size_t i = 0; i < walls.size(); ++i)
+			intersectWall(rays, walls, i, hits);
+	}
+
+}
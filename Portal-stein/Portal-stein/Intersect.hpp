@@ -0,0 +1,126 @@
+#pragma once
+#ifndef PS_INTERSECT_INCLUDED
+#define PS_INTERSECT_INCLUDED
+#include <vector>
+#include <limits>
+#include <SFML\Graphics.hpp>
+
+// Intersection kernels use AVX (8 lanes) or SSE2 (4 lanes) when the compiler targets them, and plain C++ otherwise. Defining
+// PS_NO_SIMD forces the scalar version.
+#if !defined(PS_NO_SIMD) && (defined(__AVX2__) || defined(__AVX__))
+#define PS_SIMD_AVX
+#elif !defined(PS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define PS_SIMD_SSE2
+#endif
+
+namespace ps {
+
+	//**************************************************************************
+	// WALL ARRAYS
+	//**************************************************************************
+
+	/// Walls of one segment stored in structure-of-arrays layout, so several walls can be intersected by one instruction. Arrays are padded
+	/// by degenerate walls to a multiple of WallArrays::padding. Degenerate walls are never hit.
+	class WallArrays {
+	private:
+		std::size_t count;		///< Number of walls (without the padding).
+
+	public:
+		/// Number of walls the arrays are padded to (widest SIMD register holds 8 floats).
+		static constexpr std::size_t padding = 8;
+
+		std::vector<float> fromX;
+		std::vector<float> fromY;
+		std::vector<float> directionX;		///< x coordinate of (to - from)
+		std::vector<float> directionY;		///< y coordinate of (to - from)
+
+		/// Creates empty arrays.
+		WallArrays();
+
+		/// Appends wall going from one point to another.
+		void add(const sf::Vector2f & from, const sf::Vector2f & to);
+		/// Gets number of walls (without the padding).
+		std::size_t size() const;
+		/// Gets number of walls including the padding.
+		std::size_t paddedSize() const;
+	};
+
+	/// Walls in structure-of-arrays layout, that the intersection kernels read. It does not own the arrays: it views either WallArrays, or
+	/// the walls of one segment in the arrays of the whole level (LevelWalls). Walls are padded by degenerate walls the same way as in
+	/// WallArrays. Wall indices are relative to the first wall of the range.
+	struct WallRange {
+		const float * fromX;
+		const float * fromY;
+		const float * directionX;		///< x coordinate of (to - from)
+		const float * directionY;		///< y coordinate of (to - from)
+		std::size_t count;				///< Number of walls (without the padding).
+		std::size_t paddedCount;		///< Number of walls including the padding (multiple of WallArrays::padding).
+
+		/// Creates range of walls from the arrays (first wall of the range is the first element of the arrays).
+		WallRange(const float * fromX_, const float * fromY_, const float * directionX_, const float * directionY_, std::size_t count_, std::size_t paddedCount_);
+		/// Creates range of all the walls of the arrays.
+		WallRange(const WallArrays & walls);
+
+		/// Gets number of walls (without the padding).
+		std::size_t size() const { return count; }
+		/// Gets number of walls including the padding.
+		std::size_t paddedSize() const { return paddedCount; }
+	};
+
+
+
+	//**************************************************************************
+	// INTERSECTION KERNELS
+	//**************************************************************************
+
+	/// Nearest wall hit by a ray.
+	struct WallHit {
+		int wall;				///< Index of the wall that was hit (-1 if no wall was hit).
+		float rayParameter;		///< Hit point is (origin + rayParameter * direction).
+		float wallParameter;	///< Hit point is (from + wallParameter * (to - from)).
+
+		/// Creates hit that represents no wall.
+		WallHit();
+	};
+
+	/// Packet of rays, that are intersected together (each SIMD lane holds one ray).
+	struct RayPacket {
+		static constexpr std::size_t size = 8;
+
+		float originX[size];
+		float originY[size];
+		float directionX[size];
+		float directionY[size];
+
+		/// Sets ray of the packet.
+		void set(std::size_t index, const sf::Vector2f & origin, const sf::Vector2f & direction);
+	};
+
+	/// Hits of the rays of one packet.
+	using PacketHits = WallHit[RayPacket::size];
+
+	/// Intersects ray with all walls at once. Only walls facing the ray are hit (the same test as Wall::facesRay()). Returns the nearest hit,
+	/// whose ray parameter lies in [0, maxRayParameter]. When more walls are hit at the same distance, the one with lowest index is returned.
+	WallHit intersectWalls(const WallRange & walls, const sf::Vector2f & origin, const sf::Vector2f & direction,
+		float maxRayParameter = std::numeric_limits<float>::infinity());
+	/// Does the same as intersectWalls(), but without SIMD instructions. It is used as a fallback and as a reference in tests.
+	WallHit intersectWallsScalar(const WallRange & walls, const sf::Vector2f & origin, const sf::Vector2f & direction,
+		float maxRayParameter = std::numeric_limits<float>::infinity());
+
+	/// Counts the walls, that do not face the ray going in given direction (render statistics use it).
+	std::size_t countBackFacingWalls(const WallRange & walls, const sf::Vector2f & direction);
+
+	/// Intersects ray with one wall. Hit is replaced if the wall faces the ray and it is hit nearer than the current hit (ties keep the
+	/// current hit). It computes the same hit as intersectWalls() does for the wall.
+	void intersectWall(const WallRange & walls, std::size_t wall, const sf::Vector2f & origin, const sf::Vector2f & direction, WallHit & hit);
+
+	/// Intersects all rays of the packet with one wall at once. Hit of each ray is replaced if the wall faces the ray and it is hit nearer
+	/// than the current hit of the ray (ties keep the current hit).
+	void intersectWall(const RayPacket & rays, const WallRange & walls, std::size_t wall, PacketHits & hits);
+	/// Does the same as intersectWall(), but without SIMD instructions. It is used as a fallback and as a reference in tests.
+	void intersectWallScalar(const RayPacket & rays, const WallRange & walls, std::size_t wall, PacketHits & hits);
+	/// Finds the nearest hits of all rays of the packet, by intersecting the packet with the walls one by one.
+	void intersectWalls(const RayPacket & rays, const WallRange & walls, PacketHits & hits);
+}
+
+#endif // !PS_INTERSECT_INCLUDED
@@ -1,22 +1,77 @@
 #include "Level.hpp"
+#include "RayCaster.hpp"
+#include "Profiler.hpp"
 
 namespace ps {
-	Level::Level(std::vector<Segment>&& segments_, ObjectInScene playerPos) : initialScene(playerPos) {
-		initialScene.segments = std::move(segments_);
+	// Collects portal walls of all the segments of the level.
+	PortalGraph makePortalGraph(const LevelGeometry & geometry) {
+		PortalGraph graph(geometry.getSegmentCount());
+		for (std::size_t i = 0; i < graph.size(); ++i) {
+			for (auto & wall : geometry.getSegment(i).getWalls()) {
+				if (wall.isPortal())
+					graph[i].push_back(PortalEdge{ LineSegment(wall.getFrom(), wall.getTo()), wall.getPortal() });
+			}
+		}
+
+		return graph;
+	}
+
+	Level::Level(std::vector<Segment>&& segments_, ObjectInScene playerPos) :
+		geometry(std::make_shared<const LevelGeometry>(std::move(segments_))), initialCamera(playerPos), visibility() {
+
+		PS_PROFILE_SCOPE("computeVisibility");
+		visibility = PotentiallyVisibleSet(makePortalGraph(*geometry), RayCaster::recursionLimit);
+	}
+
+	Level::Level(std::vector<Segment>&& segments_, ObjectInScene playerPos, const Level & previous) :
+		geometry(std::make_shared<const LevelGeometry>(std::move(segments_))), initialCamera(playerPos), visibility() {
+
+		PS_PROFILE_SCOPE("updateVisibility");
+		visibility = PotentiallyVisibleSet(makePortalGraph(*geometry), RayCaster::recursionLimit, makePortalGraph(*previous.geometry), previous.visibility);
+	}
+
+	Level::Level(std::vector<Segment>&& segments_, ObjectInScene playerPos, PotentiallyVisibleSet && visibility_) :
+		geometry(std::make_shared<const LevelGeometry>(std::move(segments_))), initialCamera(playerPos), visibility(std::move(visibility_)) {
 	}
 
 	sf::Texture * Level::addTexture(std::string fileName)
 	{
 		auto tex = std::make_shared<sf::Texture>();
 		tex->loadFromFile(fileName);
+		tex->setRepeated(true);		// walls and floors repeat their textures (TextureCache sets it for the textures it loads)
 
-		textures.push_back(tex);
+		textures.push_back(LevelTexture{ fileName, tex });
 		return tex.get();
 	}
 
-	Scene Level::makeScene()
+	void Level::addTexture(const std::string & path, std::shared_ptr<sf::Texture> texture)
+	{
+		textures.push_back(LevelTexture{ path, std::move(texture) });
+	}
+
+	const std::vector<LevelTexture> & Level::getTextures() const
+	{
+		return textures;
+	}
+
+	Scene Level::makeScene() const
+	{
+		// segments are shared, only the camera is created
+		return Scene(geometry, initialCamera);
+	}
+
+	const LevelGeometry & Level::getGeometry() const
+	{
+		return *geometry;
+	}
+
+	const ObjectInScene & Level::getInitialCamera() const
+	{
+		return initialCamera;
+	}
+
+	const PotentiallyVisibleSet & Level::getVisibility() const
 	{
-		// scene is copied
-		return initialScene;
+		return visibility;
 	}
 }
\ No newline at end of file
@@ -5,22 +5,48 @@
 #include <memory>
 #include "SFML\Graphics.hpp"
 #include "Scene.hpp"
+#include "PotentiallyVisibleSet.hpp"
 
 namespace ps {
 
+	/// Texture used by a level, with the path it was loaded from.
+	struct LevelTexture {
+		std::string path;
+		std::shared_ptr<sf::Texture> texture;
+	};
+
 	/// Represents level for the game. That means all the segments (+ textures).
 	class Level {
 	private:
-		std::vector<std::shared_ptr<sf::Texture>> textures;
-		Scene initialScene;
+		std::vector<LevelTexture> textures;
+		std::shared_ptr<const LevelGeometry> geometry;	///< Segments of the level, shared by all the scenes made from the level.
+		ObjectInScene initialCamera;					///< Initial position of the player.
+		PotentiallyVisibleSet visibility;	///< Segments that can be seen from each segment (computed when the level is created).
 
 	public:
+		/// Creates level from its segments. Potentially visible set of the segments is computed for the recursion limit of RayCaster.
 		Level(std::vector<Segment> && segments_, ObjectInScene playerPos);
+		/// Creates level, that replaces previous version of the level (e.g. after its file was edited). Potentially visible set is computed
+		/// only for the segments, that can be affected by the changes of the portals, the sets of the other segments are taken from previous.
+		Level(std::vector<Segment> && segments_, ObjectInScene playerPos, const Level & previous);
+		/// Creates level from its segments and potentially visible set computed before (e.g. stored in a compiled level).
+		Level(std::vector<Segment> && segments_, ObjectInScene playerPos, PotentiallyVisibleSet && visibility_);
 
 		/// Loads texture from file.
 		sf::Texture * addTexture(std::string fileName);
-		/// Makes scene that corresponds to the initial state of this level. (Can be called multiple times)
-		Scene makeScene();
+		/// Adds texture, that was loaded from given path. Textures are kept so that the level can be compiled (it refers to them by path).
+		void addTexture(const std::string & path, std::shared_ptr<sf::Texture> texture);
+		/// Gets the textures used by the level.
+		const std::vector<LevelTexture> & getTextures() const;
+		/// Makes scene that corresponds to the initial state of this level. (Can be called multiple times) The scene shares the geometry
+		/// of the level, so this does not depend on the size of the level.
+		Scene makeScene() const;
+		/// Gets the segments of the level.
+		const LevelGeometry & getGeometry() const;
+		/// Gets the initial position of the player.
+		const ObjectInScene & getInitialCamera() const;
+		/// Gets segments that can be seen from each segment of the level.
+		const PotentiallyVisibleSet & getVisibility() const;
 	};
 
 }
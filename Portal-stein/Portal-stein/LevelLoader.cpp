@@ -1,6 +1,9 @@
 #include "LevelLoader.hpp"
 #include "SegmentBuilder.hpp"
+#include "TextureCache.hpp"
+#include "Profiler.hpp"
 #include <assert.h>
+#include <iterator>
 
 namespace ps {
 
@@ -28,8 +31,23 @@ namespace ps {
 	// PARSER
 	//********************************************
 
-	LevelLoader::LevelLoader(std::istream & input_) : 
-		lexer(input_), 
+	// Reads the rest of the stream into string.
+	std::string readWholeStream(std::istream & input) {
+		return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+	}
+
+	LevelLoader::LevelLoader(std::istream & input_) :
+		source(readWholeStream(input_)),
+		lexer(source.data(), source.size()),
+		namedTextures("Texture"), namedColors("Color"), namedVertices("Vertex"), namedSegments("Segment"),
+		initialPlayer(sf::Vector3f{ 0.0f, 0.0f, 0.0f }, sf::Vector2f{ 1.0f, 0.0f }, 0),
+		defaultFloor(sf::Color::Blue), defaultCeiling(sf::Color::Green)
+	{
+	}
+
+	LevelLoader::LevelLoader(const char * data, std::size_t size) :
+		source(),
+		lexer(data, size), 
 		namedTextures("Texture"), namedColors("Color"), namedVertices("Vertex"), namedSegments("Segment"), 
 		initialPlayer(sf::Vector3f{ 0.0f, 0.0f, 0.0f }, sf::Vector2f{ 1.0f, 0.0f }, 0),
 		defaultFloor(sf::Color::Blue), defaultCeiling(sf::Color::Green)
@@ -47,10 +65,11 @@ namespace ps {
 
 		Token pathToken = lexer.eat(TokenType::STRING);
 
-		std::shared_ptr<sf::Texture> texPtr = std::make_shared<sf::Texture>();
-		if (!texPtr->loadFromFile(pathToken.value.s))		
-			throw TexureLoadFailedException(pathToken.value.s, pathToken.lineNumber);
-			
+		// image is decoded by the texture cache while the parsing continues, failure is found out at the end of the level
+		std::string path = pathToken.getString();
+		std::shared_ptr<sf::Texture> texPtr = TextureCache::getInstance().request(path);
+
+		loadedTextures.push_back(LoadedTexture{ LevelTexture{ path, texPtr }, pathToken.lineNumber });
 		return texPtr;
 	}
 
@@ -131,29 +150,30 @@ namespace ps {
 
 	void LevelLoader::loadMap()
 	{
-		std::istream & input = lexer.input;
-		char c;
+		const char * & position = lexer.position;
 
 		// skip all characters to first line-feed
-		do {
-			c = input.get();
-		} while (input.good() && c != '\n');
+		while (position != lexer.end && *position++ != '\n') {
+		}
 		lexer.lineNumber++;
 
 		int x = 0;
 		int y = 0;
 		while (true) {
-			c = input.get();
-
-			if (input.good() == false) {
-				// end of stream => end of map
+			if (position == lexer.end) {
+				// end of input => end of map
 				lexer.lookahead = Token(TokenType::END_OF_STREAM, lexer.lineNumber);
+				lexer.lookahead.offset = (std::size_t)(position - lexer.begin);
 				return;
 			}
-			
+
+			const char * vertexName = position;
+			char c = *position++;
+
 			if (c == '*') {
 				// * means beginning of next sectino => end of map
 				lexer.lookahead = Token(TokenType::ASTERISK, lexer.lineNumber);
+				lexer.lookahead.offset = (std::size_t)(vertexName - lexer.begin);
 				return;
 			}
 
@@ -162,10 +182,9 @@ namespace ps {
 				--y;
 				x = -1;
 			}
-			else if (c != ' ') {
-				Token idToken(TokenType::ID, lexer.lineNumber);
-				idToken.value.s = std::string(1, c);	// string of only one character
-
+			else if (c != ' ' && c != '\r') {	// line-feeds of the files written on Windows are not vertices (when the file is not read in text mode)
+				Token idToken(TokenType::ID, StringRef{ vertexName, 1 }, lexer.lineNumber);	// name of only one character
+				idToken.value.symbol = lexer.intern(idToken.value.s);
 				namedVertices.insertNew(idToken, sf::Vector2f((float)x, (float)y));
 			}
 
@@ -183,10 +202,14 @@ namespace ps {
 
 		const Token & lookahead = lexer.getLookahead();
 
-		bool nextIsIdTexture = lookahead.type == TokenType::ID && namedTextures.contains(lookahead);
-		bool nextIsStringTexture = lookahead.type == TokenType::STRING;
-		if (nextIsIdTexture || nextIsStringTexture) {
+		std::shared_ptr<sf::Texture> * namedTexture = (lookahead.type == TokenType::ID) ? namedTextures.find(lookahead) : nullptr;
+		if (namedTexture != nullptr) {
 			// this id represents texture
+			//     "(" texture ")"
+			texture_ = *namedTexture;
+			lexer.eat(TokenType::ID);
+		}
+		else if (lookahead.type == TokenType::STRING) {
 			//     "(" texture ")"
 			texture_ = texture();
 		}
@@ -290,7 +313,7 @@ namespace ps {
 		while (lexer.lookahead.type != TokenType::RCBRA) {
 			sf::Color currentColor = defaultColor;
 			std::shared_ptr<sf::Texture> currentTexture = defaultTexture;
-			portalPtr currentPortal = nullptr;
+			Portal currentPortal;
 
 			LoadedPortal portal;
 			wallModifier(currentColor, currentTexture, portal);
@@ -328,12 +351,12 @@ namespace ps {
 	LevelLoader::SegmentWithId & LevelLoader::getSegment(const Token & idToken) {
 		assert(idToken.type == TokenType::ID);
 
-		if (namedSegments.contains(idToken) == false) {
-			LevelLoader::SegmentWithId newSegment(nullptr, namedSegments.size());
-			namedSegments.insertNew(idToken, newSegment);
-		}
+		SegmentWithId * segment = namedSegments.find(idToken);
+		if (segment != nullptr)
+			return *segment;
 
-		return namedSegments.get(idToken);
+		// segment referenced for the first time gets next id
+		return namedSegments.insertNew(idToken, SegmentWithId(nullptr, namedSegments.size()));
 	}
 
 	Segment LevelLoader::segment()
@@ -343,7 +366,7 @@ namespace ps {
 		lexer.eat(TokenType::LCBRA);
 		while (lexer.lookahead.type == TokenType::ID) {
 			auto idToken = lexer.eat(TokenType::ID);
-			auto & attribute = idToken.value.s;
+			StringRef attribute = idToken.value.s;
 
 			if (attribute == "floor") {
 				floorAttribute(builder);
@@ -358,7 +381,7 @@ namespace ps {
 				builder.setFinish(true);
 			}
 			else {
-				throw IdentifierException(attribute, "Attribute", "Unknown segment attribute!", idToken.lineNumber);
+				throw IdentifierException(attribute.str(), "Attribute", "Unknown segment attribute!", idToken.lineNumber);
 			}
 		}
 
@@ -375,8 +398,9 @@ namespace ps {
 			lexer.eat(TokenType::COLON);
 			auto segment_ = segment();
 
-			getSegment(idToken).segment = std::make_shared<Segment>(segment_);
-			getSegment(idToken).defined = true;		// segment was defined now
+			SegmentWithId & segmentWithId = getSegment(idToken);
+			segmentWithId.segment = std::make_shared<Segment>(std::move(segment_));
+			segmentWithId.defined = true;		// segment was defined now
 		}
 	}
 
@@ -394,53 +418,85 @@ namespace ps {
 	}
 
 	Level LevelLoader::loadLevel()
+	{
+		return load(nullptr);
+	}
+
+	Level LevelLoader::reloadLevel(const Level & previous)
+	{
+		return load(&previous);
+	}
+
+	Level LevelLoader::load(const Level * previous)
 	{
 		while (lexer.lookahead.type == TokenType::ASTERISK) {
 			lexer.eat(TokenType::ASTERISK);
 			Token idToken = lexer.lookahead;
-			std::string keyword = idToken.value.s;
+			StringRef keyword = idToken.value.s;
 
 			if (keyword != "MAP")
 				// map is handled differently so it needs that the "MAP" token is not eaten when loadMap() starts
 				lexer.eat(TokenType::ID);
 
 			if (keyword == "TEXTURES") {
+				PS_PROFILE_SCOPE("loadTextures");
 				textures();
 			}
 			else if (keyword == "COLORS") {
+				PS_PROFILE_SCOPE("parseColors");
 				colors();
 			}
 			else if (keyword == "VERTICES") {
+				PS_PROFILE_SCOPE("parseVertices");
 				vertices();
 			}
 			else if (keyword == "MAP") {
+				PS_PROFILE_SCOPE("parseMap");
 				loadMap();
 			}
 			else if (keyword == "SEGMENTS") {
+				PS_PROFILE_SCOPE("parseSegments");
 				segments();
 			}
 			else if (keyword == "PLAYER") {
+				PS_PROFILE_SCOPE("parsePlayer");
 				player();
 			}
 			else {
-				throw IdentifierException(keyword, "Section", "Unknown section!", idToken.lineNumber);
+				throw IdentifierException(keyword.str(), "Section", "Unknown section!", idToken.lineNumber);
 			}
 		}
 
 		lexer.eat(TokenType::END_OF_STREAM);
 
+		{
+			PS_PROFILE_SCOPE("waitForTextures");
+			for (auto & loaded : loadedTextures) {
+				if (!TextureCache::getInstance().waitForImage(loaded.texture.path))
+					throw TexureLoadFailedException(loaded.texture.path, loaded.lineNumber);
+			}
+		}
+
+		PS_PROFILE_SCOPE("buildLevel");
+
 		std::vector<Segment> segmentsVector(namedSegments.size(), Segment(defaultFloor, defaultCeiling));
-		for (auto & pair : namedSegments.data) {
-			SegmentWithId & segment = pair.second;
+		for (Symbol symbol = 0; symbol < (Symbol)namedSegments.data.size(); ++symbol) {
+			if (namedSegments.defined[symbol] == false)
+				continue;	// symbol is not name of segment
 
+			SegmentWithId & segment = namedSegments.data[symbol];
 			if (segment.defined == false)
 				// segment was reference (in portal definition) but it was not defined
-				throw IdentifierException(pair.first, "Segment", "Segment with this id was referenced, but it was not defined!", lexer.lineNumber);
+				throw IdentifierException(lexer.getSymbols().getName(symbol).str(), "Segment", "Segment with this id was referenced, but it was not defined!", lexer.lineNumber);
 
 			segmentsVector[segment.id] = *(segment.segment);	// segment is coppied
 		}
 
-		return Level(std::move(segmentsVector), initialPlayer);
+		Level level = (previous != nullptr) ? Level(std::move(segmentsVector), initialPlayer, *previous) : Level(std::move(segmentsVector), initialPlayer);
+		for (auto & loaded : loadedTextures)
+			level.addTexture(loaded.texture.path, loaded.texture.texture);
+
+		return level;
 	}
 
 	LevelLoader::SegmentWithId::SegmentWithId() : 
@@ -457,19 +513,19 @@ namespace ps {
 	{
 	}
 
-	std::shared_ptr<Portal> LevelLoader::LoadedPortal::makePortal(sf::Vector2f from0, sf::Vector2f from1)
+	Portal LevelLoader::LoadedPortal::makePortal(sf::Vector2f from0, sf::Vector2f from1)
 	{
 		switch (type) {
-		case PortalType::NONE: return nullptr;
+		case PortalType::NONE: return Portal();
 			break;
-		case PortalType::DOOR: return std::make_shared<Door>(targetSegment);
+		case PortalType::DOOR: return makeDoor(targetSegment);
 			break;
-		case PortalType::WALL_PORTAL: return std::make_shared<WallPortal>(LineSegment(from0, from1), LineSegment(to0, to1), targetSegment);
+		case PortalType::WALL_PORTAL: return makeWallPortal(LineSegment(from0, from1), LineSegment(to0, to1), targetSegment);	// transform is precomputed here
 			break;
 		}
 		
 		assert(false);
-		return nullptr;
+		return Portal();
 	}
 
 }
\ No newline at end of file
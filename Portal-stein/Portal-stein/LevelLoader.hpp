@@ -3,7 +3,7 @@
 #define PS_LEVEL_LOADER_INCLUDED
 #include <string>
 #include <iostream>
-#include <map>
+#include <vector>
 #include <memory>
 #include <assert.h>
 
@@ -47,48 +47,63 @@ namespace ps {
 	//**************************************************
 
 	/// Class for storing values tied to some identifiers. This class handles errors as multiple defined identifier, or undefined identifier that is used, by throwing exception. 
+	/// Values are stored in flat array indexed by the symbol of the identifier, so no lookup compares the names.
 	template<typename ValueT>
 	class NamedValues {
-		std::map<std::string, ValueT> data;
+		std::vector<ValueT> data;		///< Value of each symbol (default value for symbols that were not defined).
+		std::vector<bool> defined;		///< Whether the symbol was defined.
+		std::size_t count;
 		std::string typeDescription;
 
 	public:
-		NamedValues(const std::string & typeDescription_) : typeDescription(typeDescription_) {
+		NamedValues(const std::string & typeDescription_) : count(0), typeDescription(typeDescription_) {
 		}
 		
-		/// Inserts value to the database. If this identifier was already defined IdentifierException will be thrown.
+		/// Inserts value to the database, and returns the inserted value. If this identifier was already defined IdentifierException will be thrown.
 		/// \sa IdentifierException
-		void insertNew(const Token & idToken, const ValueT & value) {
+		ValueT & insertNew(const Token & idToken, const ValueT & value) {
 			assert(idToken.type == TokenType::ID);
 
-			auto it = data.find(idToken.value.s);
-			if (it == data.end()) {
-				data.insert(it, std::make_pair(idToken.value.s, value));
+			Symbol symbol = idToken.value.symbol;
+			if (symbol >= data.size()) {
+				data.resize(symbol + 1);
+				defined.resize(symbol + 1, false);
 			}
-			else {
-				throw IdentifierException(idToken.value.s, typeDescription, "Identifier cannot be defined twice!", idToken.lineNumber);
+			else if (defined[symbol]) {
+				throw IdentifierException(idToken.getString(), typeDescription, "Identifier cannot be defined twice!", idToken.lineNumber);
 			}
+
+			data[symbol] = value;
+			defined[symbol] = true;
+			count++;
+			return data[symbol];
+		}
+
+		/// Returns value tied to this identifier, or nullptr if it was not defined.
+		ValueT * find(const Token & idToken) {
+			assert(idToken.type == TokenType::ID);
+			Symbol symbol = idToken.value.symbol;
+			return (symbol < data.size() && defined[symbol]) ? &data[symbol] : nullptr;
 		}
 
 		/// Returns true if such identifier was defined previously.
 		bool contains(const Token & idToken) {
-			assert(idToken.type == TokenType::ID);
-			return (data.find(idToken.value.s) != data.end());
+			return find(idToken) != nullptr;
 		}
 
 		/// Returns value tied to this identifier. If this identifier was not defined, IdentifierException will be thrown.
 		/// \sa IdentifierException
 		ValueT & get(const Token & idToken) {
-			auto it = data.find(idToken.value.s);
-			if (it != data.end())
-				return it->second;
+			ValueT * value = find(idToken);
+			if (value != nullptr)
+				return *value;
 			else
-				throw IdentifierException(idToken.value.s, typeDescription, "Identifier was not defined prior to the use!", idToken.lineNumber);
+				throw IdentifierException(idToken.getString(), typeDescription, "Identifier was not defined prior to the use!", idToken.lineNumber);
 		}
 
 		/// Returns how many identifiers were defined.
 		std::size_t size() {
-			return data.size();
+			return count;
 		}
 
 		friend class LevelLoader;
@@ -97,6 +112,7 @@ namespace ps {
 	/// Class that parses the level file, and reads all the information from it, constructing Level object.
 	class LevelLoader {
 	private:
+		std::string source;		///< Copy of the input stream (empty if the loader reads buffer given by the caller).
 		Lexer lexer;
 
 		Floor defaultFloor;
@@ -117,8 +133,15 @@ namespace ps {
 		NamedValues<SegmentWithId>					namedSegments;
 		ObjectInScene initialPlayer;
 
+		struct LoadedTexture {
+			LevelTexture texture;
+			int lineNumber;		///< Line of the path, failure of the loading is reported there.
+		};
+
+		std::vector<LoadedTexture> loadedTextures;	///< Textures requested from the texture cache (they are handed over to the level).
+
 		SegmentWithId & getSegment(const Token & idToken);
-		/// Loads vertex map. This procedure bypasses the lexer, and reads the input directly.
+		/// Loads vertex map. This procedure bypasses the lexer, and reads the buffer of the lexer directly.
 		void loadMap();
 
 		/// texture : "path_to_texture" | id
@@ -151,7 +174,7 @@ namespace ps {
 			std::size_t targetSegment;
 
 			LoadedPortal();
-			std::shared_ptr<Portal> makePortal(sf::Vector2f from0, sf::Vector2f from1);
+			Portal makePortal(sf::Vector2f from0, sf::Vector2f from1);
 		};
 
 		/// portal : ("[" id "]") | ("[" id "-" vertex "-" vertex "]") 
@@ -166,13 +189,22 @@ namespace ps {
 		void segments();
 		/// player : vertex "-" vertex "-" id
 		void player();
+		/// Loads the level. If previous version of the level is given, the level is created as its replacement.
+		Level load(const Level * previous);
 
 	public:
 		/// Creates new parser, that will read the level from given input stream.
 		/// \param input Stream containing the level description.
 		LevelLoader(std::istream & input);
-		/// Loads the level from the stream, and returns it.
+		/// Creates new parser, that will read the level from given characters (e.g. memory mapped level file). Nothing is copied, so the
+		/// characters have to stay valid until the level is loaded.
+		LevelLoader(const char * data, std::size_t size);
+		/// Loads the level from the stream, and returns it. Textures of the level are requested from TextureCache, they are empty until
+		/// TextureCache::uploadTextures() is called.
 		Level loadLevel();
+		/// Loads the level from the stream as new version of previous level (e.g. after the level file was edited). Potentially visible set
+		/// of the segments is computed only where the changes can affect it, the textures shared with previous level are reused.
+		Level reloadLevel(const Level & previous);
 	};
 }
 
@@ -0,0 +1,124 @@
+#include "LevelStreamer.hpp"
+#include <chrono>
+#include "Math.hpp"
+#include "TextureCache.hpp"
+#include "Profiler.hpp"
+
+namespace ps {
+
+	LevelStreamer::PreparedLevel::PreparedLevel(std::string filePath_) : filePath(std::move(filePath_)), level(), error(), done(false)
+	{
+	}
+
+	LevelStreamer::LevelStreamer(LoadFunction load_, std::size_t levelsAhead_) : load(std::move(load_)), levelsAhead(getMax<std::size_t>(levelsAhead_, 1)),
+		filePaths(), nextFile(0), preparing(), currentFile(), lastSwapMs(0.0), loaders()
+	{
+		// the pool does not load on the calling thread, so all the threads of the pool are workers (one per level prepared ahead)
+		loaders = std::make_unique<ThreadPool>(levelsAhead + 1);
+	}
+
+	LevelStreamer::~LevelStreamer()
+	{
+		// loading tasks lock the mutex of the streamer, so they have to finish before the members are destroyed
+		loaders.reset();
+	}
+
+	void LevelStreamer::start(std::vector<std::string> filePaths_)
+	{
+		// levels of the previous files are still referenced by their tasks
+		loaders->wait();
+
+		filePaths = std::move(filePaths_);
+		nextFile = 0;
+		preparing.clear();
+		for (std::size_t i = 0; i < levelsAhead; ++i)
+			startPreparing();
+	}
+
+	void LevelStreamer::startPreparing()
+	{
+		if (nextFile >= filePaths.size())
+			return;
+
+		auto prepared = std::make_shared<PreparedLevel>(filePaths[nextFile++]);
+		preparing.push_back(prepared);
+		loaders->submit([this, prepared]() {
+			PS_PROFILE_SCOPE("prepareLevel");
+			std::unique_ptr<Level> level;
+			std::exception_ptr error;
+			try {
+				level = load(prepared->filePath);
+			}
+			catch (...) {
+				error = std::current_exception();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				prepared->level = std::move(level);
+				prepared->error = error;
+				prepared->done = true;
+			}
+			levelPrepared.notify_all();
+		});
+	}
+
+	bool LevelStreamer::isReady() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		// levels that could not be loaded are skipped by takeNext(), so it waits for the first level that is loaded (or failed by exception)
+		for (auto & prepared : preparing) {
+			if (!prepared->done)
+				return false;
+			if (prepared->level || prepared->error)
+				return true;
+		}
+		return nextFile >= filePaths.size();
+	}
+
+	std::unique_ptr<Level> LevelStreamer::takeNext()
+	{
+		PS_PROFILE_SCOPE("swapLevel");
+		auto swapStart = std::chrono::steady_clock::now();
+
+		std::unique_ptr<Level> level;
+		std::exception_ptr error;
+		std::string levelFile;
+		while (!level && !error && !preparing.empty()) {
+			std::shared_ptr<PreparedLevel> prepared = preparing.front();
+			preparing.pop_front();
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				levelPrepared.wait(lock, [&prepared]() { return prepared->done; });
+				level = std::move(prepared->level);
+				error = prepared->error;
+				levelFile = prepared->filePath;
+			}
+
+			// the taken file is replaced by the next one, so the same number of levels is prepared while this one is played
+			startPreparing();
+		}
+
+		if (error)
+			std::rethrow_exception(error);
+
+		currentFile = (level) ? levelFile : std::string();
+		if (level) {
+			// images of the level were decoded before it was prepared, images of the levels still being prepared are not waited for
+			TextureCache::getInstance().uploadDecodedTextures();
+		}
+
+		lastSwapMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - swapStart).count();
+		return level;
+	}
+
+	const std::string & LevelStreamer::getCurrentFile() const
+	{
+		return currentFile;
+	}
+
+	double LevelStreamer::getLastSwapMs() const
+	{
+		return lastSwapMs;
+	}
+}
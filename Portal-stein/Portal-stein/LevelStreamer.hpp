@@ -0,0 +1,78 @@
+#pragma once
+#ifndef PS_LEVEL_STREAMER_INCLUDED
+#define PS_LEVEL_STREAMER_INCLUDED
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include "Level.hpp"
+#include "ThreadPool.hpp"
+
+namespace ps {
+
+	//**************************************************************************
+	// LEVEL STREAMER
+	//**************************************************************************
+
+	/// Loads the levels of the game several levels ahead of the player. While one level is played, the next ones are prepared (parsed,
+	/// their geometry built and the images of their textures decoded) in parallel by the threads of a pool. Switching to a prepared level
+	/// only uploads its textures, so it takes no longer than one frame.
+	class LevelStreamer {
+	public:
+		/// Loads level from the file. Returns nullptr if the level cannot be loaded (the level is skipped then).
+		using LoadFunction = std::function<std::unique_ptr<Level>(const std::string & filePath)>;
+
+	private:
+		/// Level prepared by a thread of the pool. Members are written by the thread, they can be read once done is set.
+		struct PreparedLevel {
+			std::string filePath;
+			std::unique_ptr<Level> level;	///< Prepared level (nullptr if it could not be loaded).
+			std::exception_ptr error;		///< Exception thrown by the load function, it is rethrown by takeNext().
+			bool done;						///< Guarded by mutex.
+
+			explicit PreparedLevel(std::string filePath_);
+		};
+
+		LoadFunction load;
+		std::size_t levelsAhead;
+		std::vector<std::string> filePaths;
+		std::size_t nextFile;				///< First file, whose preparing was not started yet.
+		std::deque<std::shared_ptr<PreparedLevel>> preparing;	///< Levels being prepared (or already prepared), in the order of the files.
+		std::string currentFile;			///< File of the level returned by the last takeNext().
+		double lastSwapMs;
+		mutable std::mutex mutex;
+		std::condition_variable levelPrepared;
+		std::unique_ptr<ThreadPool> loaders;
+
+		/// Starts preparing the next file on the pool (if there are more files).
+		void startPreparing();
+
+	public:
+		/// Creates streamer, that loads levels by given function. The function is called by the threads of the pool, for up to levelsAhead_
+		/// files at once.
+		explicit LevelStreamer(LoadFunction load_, std::size_t levelsAhead_ = 3);
+		~LevelStreamer();
+
+		LevelStreamer(const LevelStreamer &) = delete;
+		LevelStreamer & operator=(const LevelStreamer &) = delete;
+
+		/// Starts preparing the first levels of the files. Levels are played in the order of the files.
+		void start(std::vector<std::string> filePaths_);
+		/// Returns true if the next level is prepared (or if it is known there are no more levels), so takeNext() will not wait.
+		bool isReady() const;
+		/// Takes the next prepared level and starts preparing the files after it, so levelsAhead files are prepared again. Textures of the
+		/// level are uploaded, so this must be called from the thread owning OpenGL context. Waits if the level is not prepared yet. Returns
+		/// nullptr if there are no more levels.
+		std::unique_ptr<Level> takeNext();
+		/// Gets the file the level returned by the last takeNext() was loaded from (empty if no level was returned).
+		const std::string & getCurrentFile() const;
+		/// Gets the time the last takeNext() took (in milliseconds), that is the time the switch of the levels stalled the calling thread.
+		double getLastSwapMs() const;
+	};
+}
+
+#endif // !PS_LEVEL_STREAMER_INCLUDED
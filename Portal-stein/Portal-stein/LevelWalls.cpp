@@ -0,0 +1,112 @@
+#include "LevelWalls.hpp"
+#include "Math.hpp"
+
+namespace ps {
+
+	//**************************************************************************
+	// LEVEL WALLS
+	//**************************************************************************
+
+	constexpr std::uint32_t LevelWalls::noPortal;
+
+	LevelWalls::LevelWalls() : fromX(), fromY(), directionX(), directionY(), normalX(), normalY(), planeOffset(), length(), material(), portal(),
+		segments(), materials(), portals() {
+	}
+
+	void LevelWalls::addSegment(const std::vector<PortalWall> & walls)
+	{
+		SegmentWalls range;
+		range.first = (std::uint32_t)fromX.size();
+		range.count = (std::uint32_t)walls.size();
+		segments.push_back(range);
+
+		// segment is padded by degenerate walls (zero direction makes det == 0, so the padding is never hit)
+		std::size_t padding = WallArrays::padding;
+		std::size_t paddedSize = range.first + (walls.size() + padding - 1) / padding * padding;
+		fromX.resize(paddedSize, 0.0f);
+		fromY.resize(paddedSize, 0.0f);
+		directionX.resize(paddedSize, 0.0f);
+		directionY.resize(paddedSize, 0.0f);
+		normalX.resize(paddedSize, 0.0f);
+		normalY.resize(paddedSize, 0.0f);
+		planeOffset.resize(paddedSize, 0.0f);
+		length.resize(paddedSize, 0.0f);
+		material.resize(paddedSize, 0);
+		portal.resize(paddedSize, noPortal);
+
+		for (std::size_t i = 0; i < walls.size(); ++i) {
+			const PortalWall & wall = walls[i];
+			const WallGeometry & geometry = wall.getGeometry();
+			std::size_t id = range.first + i;
+
+			fromX[id] = wall.getFrom().x;
+			fromY[id] = wall.getFrom().y;
+			directionX[id] = geometry.direction.x;
+			directionY[id] = geometry.direction.y;
+			normalX[id] = geometry.normal.x;
+			normalY[id] = geometry.normal.y;
+			planeOffset[id] = geometry.planeOffset;
+			length[id] = geometry.length;
+
+			// levels use a few colors and textures, so the materials are searched linearly
+			WallMaterial wallMaterial = wall.getMaterial();
+			std::size_t m = 0;
+			while (m < materials.size() && (materials[m].color != wallMaterial.color || materials[m].texture != wallMaterial.texture))
+				++m;
+			if (m == materials.size())
+				materials.push_back(wallMaterial);
+			material[id] = (std::uint32_t)m;
+
+			if (wall.isPortal()) {
+				portal[id] = (std::uint32_t)portals.size();
+				portals.push_back(wall.getPortal());
+			}
+		}
+	}
+
+	std::size_t LevelWalls::getSegmentCount() const
+	{
+		return segments.size();
+	}
+
+	WallRange LevelWalls::getWallRange(std::size_t segmentId) const
+	{
+		const SegmentWalls & range = segments[segmentId];
+		std::size_t padding = WallArrays::padding;
+		std::size_t paddedCount = (range.count + padding - 1) / padding * padding;
+
+		return WallRange(fromX.data() + range.first, fromY.data() + range.first, directionX.data() + range.first, directionY.data() + range.first,
+			range.count, paddedCount);
+	}
+
+	float LevelWalls::distanceFromWall(std::uint32_t wall, const sf::Vector2f & point) const
+	{
+		sf::Vector2f r(directionX[wall], directionY[wall]);
+
+		// "from" is put into coordinate system center
+		sf::Vector2f x = point - sf::Vector2f(fromX[wall], fromY[wall]);
+		float rDot = dot(r, x);
+		if (rDot < 0) {
+			// returns distance from "from"
+			return norm(x);
+		}
+		else if (rDot > length[wall] * length[wall]) {
+			// returns distance from "to"
+			return norm(x - r);
+		}
+		else {
+			// return distance of point from line going through "from" and "to"
+			return dot(sf::Vector2f(normalX[wall], normalY[wall]), point) - planeOffset[wall];
+		}
+	}
+
+	std::size_t LevelWalls::getMaterialCount() const
+	{
+		return materials.size();
+	}
+
+	std::size_t LevelWalls::getPortalCount() const
+	{
+		return portals.size();
+	}
+}
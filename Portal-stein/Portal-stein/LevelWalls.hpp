@@ -0,0 +1,86 @@
+#pragma once
+#ifndef PS_LEVEL_WALLS_INCLUDED
+#define PS_LEVEL_WALLS_INCLUDED
+#include <vector>
+#include <cstdint>
+#include <SFML\Graphics.hpp>
+#include "Wall.hpp"
+#include "Portal.hpp"
+#include "Intersect.hpp"
+
+namespace ps {
+
+	//**************************************************************************
+	// LEVEL WALLS
+	//**************************************************************************
+
+	/// Walls of one segment in LevelWalls: they have ids [first, first + count).
+	struct SegmentWalls {
+		std::uint32_t first;	///< Id of the first wall of the segment (multiple of WallArrays::padding).
+		std::uint32_t count;	///< Number of walls of the segment (without the padding).
+	};
+
+	/// Walls of all the segments of a level, stored in structure-of-arrays layout. Renderer and collisions read only the arrays they need:
+	/// wall geometry lies in contiguous float arrays, look and portal of the wall are 32-bit indices into the tables of distinct materials
+	/// and portals. Walls of each segment start at a multiple of WallArrays::padding and they are padded by degenerate walls, so the walls of
+	/// a segment with up to 8 walls take one 32-byte block in each array.
+	class LevelWalls {
+	public:
+		/// Portal index of the walls without portal.
+		static constexpr std::uint32_t noPortal = 0xffffffff;
+
+	private:
+		std::vector<float> fromX;
+		std::vector<float> fromY;
+		std::vector<float> directionX;		///< x coordinate of (to - from)
+		std::vector<float> directionY;		///< y coordinate of (to - from)
+		std::vector<float> normalX;			///< x coordinate of the unit normal, that points to the inside of the segment.
+		std::vector<float> normalY;			///< y coordinate of the unit normal, that points to the inside of the segment.
+		std::vector<float> planeOffset;		///< Signed distance of point p from the wall line is (dot(normal, p) - planeOffset).
+		std::vector<float> length;			///< Length of the wall.
+		std::vector<std::uint32_t> material;	///< Index into materials.
+		std::vector<std::uint32_t> portal;		///< Index into portals (noPortal for solid walls).
+
+		std::vector<SegmentWalls> segments;
+		std::vector<WallMaterial> materials;
+		std::vector<Portal> portals;
+
+	public:
+		/// Creates walls of a level with no segments.
+		LevelWalls();
+
+		/// Appends the walls of the next segment (segments get ids in the order they are added). Materials of the walls point to their
+		/// textures, so the walls must be kept alive while the level is used.
+		void addSegment(const std::vector<PortalWall> & walls);
+
+		/// Gets number of segments.
+		std::size_t getSegmentCount() const;
+		/// Gets the ids of the walls of the segment.
+		const SegmentWalls & getSegmentWalls(std::size_t segmentId) const { return segments[segmentId]; }
+		/// Gets the walls of the segment in the layout read by intersection kernels. Indices of the hits are relative to the first wall
+		/// of the segment.
+		WallRange getWallRange(std::size_t segmentId) const;
+
+		/// Gets the starting point of the wall.
+		sf::Vector2f getFrom(std::uint32_t wall) const { return sf::Vector2f(fromX[wall], fromY[wall]); }
+		/// Gets the ending point of the wall.
+		sf::Vector2f getTo(std::uint32_t wall) const { return sf::Vector2f(fromX[wall] + directionX[wall], fromY[wall] + directionY[wall]); }
+		/// Gets length of the wall.
+		float getLength(std::uint32_t wall) const { return length[wall]; }
+		/// Returns true if the wall has portal on it.
+		bool isPortal(std::uint32_t wall) const { return portal[wall] != noPortal; }
+		/// Gets the portal of the wall. Wall must have portal on it.
+		const Portal & getPortal(std::uint32_t wall) const { return portals[portal[wall]]; }
+		/// Gets the material of the wall.
+		const WallMaterial & getMaterial(std::uint32_t wall) const { return materials[material[wall]]; }
+		/// Returns signed distance (positive on the inside of segment) of the point from the wall. Works the same as Wall::distanceFromWall().
+		float distanceFromWall(std::uint32_t wall, const sf::Vector2f & point) const;
+
+		/// Gets number of distinct materials of the walls.
+		std::size_t getMaterialCount() const;
+		/// Gets number of portals.
+		std::size_t getPortalCount() const;
+	};
+}
+
+#endif // !PS_LEVEL_WALLS_INCLUDED
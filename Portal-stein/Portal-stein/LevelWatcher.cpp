@@ -0,0 +1,58 @@
+#include "LevelWatcher.hpp"
+#include "Profiler.hpp"
+
+namespace ps {
+
+	LevelWatcher::LevelWatcher(ReloadFunction reload_, std::chrono::steady_clock::duration pollInterval_) : reload(std::move(reload_)),
+		pollInterval(pollInterval_), filePath(), lastWriteTime(), lastPoll(), lastReloadMs(0.0)
+	{
+	}
+
+	std::experimental::filesystem::file_time_type LevelWatcher::getWriteTime() const
+	{
+		// file can be missing for a while, when it is saved by replacing it
+		std::error_code error;
+		auto writeTime = std::experimental::filesystem::last_write_time(filePath, error);
+		return (error) ? lastWriteTime : writeTime;
+	}
+
+	void LevelWatcher::watch(const std::string & filePath_)
+	{
+		filePath = filePath_;
+		lastWriteTime = std::experimental::filesystem::file_time_type();	// file that is missing now is loaded, when it appears
+		lastWriteTime = getWriteTime();
+		lastPoll = std::chrono::steady_clock::now();
+	}
+
+	void LevelWatcher::stop()
+	{
+		filePath.clear();
+	}
+
+	std::unique_ptr<Level> LevelWatcher::poll(const Level & current)
+	{
+		using namespace std::chrono;
+
+		steady_clock::time_point now = steady_clock::now();
+		if (filePath.empty() || now - lastPoll < pollInterval)
+			return nullptr;
+		lastPoll = now;
+
+		auto writeTime = getWriteTime();
+		if (writeTime == lastWriteTime)
+			return nullptr;
+
+		// file that cannot be loaded (e.g. it is saved in the middle of an edit) is not loaded again until it is changed
+		lastWriteTime = writeTime;
+
+		PS_PROFILE_SCOPE("reloadLevelFile");
+		std::unique_ptr<Level> level = reload(filePath, current);
+		lastReloadMs = duration<double, std::milli>(steady_clock::now() - now).count();
+		return level;
+	}
+
+	double LevelWatcher::getLastReloadMs() const
+	{
+		return lastReloadMs;
+	}
+}
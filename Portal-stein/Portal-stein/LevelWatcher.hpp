@@ -0,0 +1,53 @@
+#pragma once
+#ifndef PS_LEVEL_WATCHER_INCLUDED
+#define PS_LEVEL_WATCHER_INCLUDED
+#include <string>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <filesystem>
+#include "Level.hpp"
+
+namespace ps {
+
+	//**************************************************************************
+	// LEVEL WATCHER
+	//**************************************************************************
+
+	/// Watches the file of the level that is played, and reloads the level when the file is changed (so the authors of the levels see their
+	/// changes without restarting the game). The file is found changed by polling its modification time.
+	class LevelWatcher {
+	public:
+		/// Loads edited level file as new version of the previous level. Returns nullptr if the level cannot be loaded (previous level is
+		/// kept then).
+		using ReloadFunction = std::function<std::unique_ptr<Level>(const std::string & filePath, const Level & previous)>;
+
+	private:
+		ReloadFunction reload;
+		std::chrono::steady_clock::duration pollInterval;
+		std::string filePath;		///< Watched file (empty if no file is watched).
+		std::experimental::filesystem::file_time_type lastWriteTime;	///< Modification time of the file, when it was loaded last time.
+		std::chrono::steady_clock::time_point lastPoll;
+		double lastReloadMs;
+
+		/// Gets modification time of the watched file (or the last known time if it cannot be read).
+		std::experimental::filesystem::file_time_type getWriteTime() const;
+
+	public:
+		/// Creates watcher, that reloads levels by given function. Modification time of the file is checked once per pollInterval.
+		explicit LevelWatcher(ReloadFunction reload_, std::chrono::steady_clock::duration pollInterval_ = std::chrono::milliseconds(500));
+
+		/// Starts watching the file of the level, that was just loaded from it.
+		void watch(const std::string & filePath_);
+		/// Stops watching the file.
+		void stop();
+		/// Checks whether the watched file was changed (at most once per poll interval). If it was, the level is reloaded from it. Returns the
+		/// reloaded level, or nullptr if the file was not changed (or it could not be loaded).
+		/// \param current Level loaded from the watched file, that is played now.
+		std::unique_ptr<Level> poll(const Level & current);
+		/// Gets the time the last reload took (in milliseconds).
+		double getLastReloadMs() const;
+	};
+}
+
+#endif // !PS_LEVEL_WATCHER_INCLUDED
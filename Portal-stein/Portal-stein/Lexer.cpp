@@ -1,4 +1,8 @@
 #include "Lexer.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
 
 namespace ps {
 
@@ -69,7 +73,24 @@ namespace ps {
 		return "Unnamed type";
 	}
 
-	Token::Token(TokenType type_, int lineNumber_) : type(type_), lineNumber(lineNumber_) {
+	std::string StringRef::str() const
+	{
+		return std::string(data, size);
+	}
+
+	bool StringRef::operator==(const char * other) const
+	{
+		return std::strlen(other) == size && (size == 0 || std::memcmp(data, other, size) == 0);
+	}
+
+	bool StringRef::operator!=(const char * other) const
+	{
+		return !(*this == other);
+	}
+
+	Token::Token(TokenType type_, int lineNumber_) : type(type_), offset(0), lineNumber(lineNumber_) {
+		value.s = StringRef{ nullptr, 0 };
+		value.symbol = 0;
 	}
 
 	Token::Token(float value_, int lineNumber_) : Token(TokenType::FLOAT, lineNumber_) {
@@ -80,8 +101,94 @@ namespace ps {
 		value.i = value_;
 	}
 
-	Token::Token(std::string value_, int lineNumber_) : Token(TokenType::STRING, lineNumber_) {
-		value.s = value_;
+	Token::Token(TokenType type_, StringRef text_, int lineNumber_) : Token(type_, lineNumber_) {
+		value.s = text_;
+	}
+
+	std::string Token::getString() const
+	{
+		if (type != TokenType::STRING)
+			return value.s.str();
+
+		std::string result;
+		result.reserve(value.s.size);
+		bool escape = false;
+		for (std::size_t i = 0; i < value.s.size; ++i) {
+			char c = value.s.data[i];
+			if (escape == false && c == '\\') {
+				escape = true;
+			}
+			else {
+				result.push_back(c);
+				escape = false;
+			}
+		}
+		return result;
+	}
+
+
+	//**********************************
+	// SYMBOL TABLE
+	//**********************************
+
+	SymbolTable::SymbolTable() : names(), slots(16, 0)
+	{
+	}
+
+	std::size_t SymbolTable::hash(StringRef name)
+	{
+		// FNV-1a
+		std::uint32_t result = 2166136261u;
+		for (std::size_t i = 0; i < name.size; ++i) {
+			result ^= (unsigned char)name.data[i];
+			result *= 16777619u;
+		}
+		return result;
+	}
+
+	std::size_t SymbolTable::findSlot(StringRef name) const
+	{
+		std::size_t mask = slots.size() - 1;
+		std::size_t slot = hash(name) & mask;
+		while (slots[slot] != 0) {
+			StringRef slotName = names[slots[slot] - 1];
+			if (slotName.size == name.size && std::memcmp(slotName.data, name.data, name.size) == 0)
+				break;
+
+			slot = (slot + 1) & mask;	// linear probing
+		}
+		return slot;
+	}
+
+	Symbol SymbolTable::intern(StringRef name)
+	{
+		std::size_t slot = findSlot(name);
+		if (slots[slot] != 0)
+			return slots[slot] - 1;
+
+		Symbol symbol = (Symbol)names.size();
+		names.push_back(name);
+
+		if (names.size() * 2 > slots.size()) {
+			// table is kept at most half full, so the probing sequences stay short
+			slots.assign(slots.size() * 2, 0);
+			for (Symbol s = 0; s < (Symbol)names.size(); ++s)
+				slots[findSlot(names[s])] = s + 1;
+		}
+		else {
+			slots[slot] = symbol + 1;
+		}
+		return symbol;
+	}
+
+	StringRef SymbolTable::getName(Symbol symbol) const
+	{
+		return names[symbol];
+	}
+
+	std::size_t SymbolTable::size() const
+	{
+		return names.size();
 	}
 
 
@@ -89,94 +196,123 @@ namespace ps {
 	// LEXER
 	//**********************************
 
-	std::string Lexer::readString()
+	StringRef Lexer::readString()
 	{
-		std::string result;
+		// escape characters are resolved by Token::getString(), here only the end of the string is found
+		const char * start = position;
 		bool escape = false;
-		char c;
-		while (input.get(c)) {
+		while (position != end) {
+			char c = *position++;
 			if (c == '\n')
 				lineNumber++;
 
-			if (escape) {
-				result.push_back(c);
+			if (escape)
 				escape = false;
-			}
-			else {
-				if (c == '\\') {
-					escape = true;
-				}
-				else if (c == '"') {
-					return result;
-				}
-				else {
-					result.push_back(c);
-				}
-			}
+			else if (c == '\\')
+				escape = true;
+			else if (c == '"')
+				return StringRef{ start, (std::size_t)(position - 1 - start) };
 		}
 
-		// This case happens when end-of-file (or some error) is encountered while searching for right "
+		// This case happens when end of the input is encountered while searching for right "
 		throw OpenStringLiteralException(lineNumber);
 	}
 
-	std::string Lexer::readIdentifier()
+	StringRef Lexer::readIdentifier()
 	{
-		std::string result;
+		const char * start = position;
+		while (position != end && isIDLetter(*position))
+			++position;
 
-		char c;
-		while (input.get(c)) {
-			if (isIDLetter(c)) {
-				result.push_back(c);
+		return StringRef{ start, (std::size_t)(position - start) };
+	}
+
+	Token Lexer::readNumber(bool negative)
+	{
+		const char * start = position;
+		bool floatNum = false;
+		while (position != end && (isNum(*position) || *position == '.')) {
+			if (*position == '.')
+				floatNum = true;
+			++position;
+		}
+
+		std::size_t length = (std::size_t)(position - start);
+		if (floatNum) {
+			// strtof needs terminated string, short numbers are terminated on stack so the conversion does not allocate
+			char number[32];
+			float value;
+			if (length < sizeof(number)) {
+				std::memcpy(number, start, length);
+				number[length] = '\0';
+				value = std::strtof(number, nullptr);
 			}
 			else {
-				input.putback(c);
-				return result;
+				value = std::stof(std::string(start, length));
 			}
+			return Token((negative ? -1.0f : 1.0f) * value, lineNumber);
 		}
 
-		return result;
+		int value = 0;
+		for (const char * digit = start; digit != position; ++digit) {
+			if (value > (std::numeric_limits<int>::max() - (*digit - '0')) / 10)
+				throw std::out_of_range("Integer in the input is too large!");
+			value = value * 10 + (*digit - '0');
+		}
+		return Token((negative ? -1 : 1) * value, lineNumber);
 	}
 
-	Lexer::Lexer(std::istream & input_) : input(input_), lineNumber(1), lookahead(-1, -1)
+	Lexer::Lexer(const char * data, std::size_t size) : begin(data), end(data + size), position(data), lineNumber(1), symbols(), lookahead(-1, -1)
 	{
 		lookahead = getNextToken();
 	}
 
-	const Token & Lexer::getLookahead()
+	const SymbolTable & Lexer::getSymbols() const
 	{
-		return lookahead;
+		return symbols;
 	}
 
-	void discardThisLine(std::istream & input) {
-		char c;
-		do {
-			c = input.get();
-		} while (c != '\n' && input.good());
+	Symbol Lexer::intern(StringRef name)
+	{
+		return symbols.intern(name);
+	}
+
+	const Token & Lexer::getLookahead()
+	{
+		return lookahead;
 	}
 
 	Token Lexer::getNextToken()
 	{
-		char c = input.get();
-		while (isWhite(c) || c == '#') {
-			// skips white characters
-			while (isWhite(c)) {
-				if (c == '\n')
+		while (position != end && (isWhite(*position) || *position == '#')) {
+			if (*position == '#') {
+				// '#' means start of the comment => discard the rest of the line
+				const char * lineEnd = static_cast<const char *>(std::memchr(position, '\n', (std::size_t)(end - position)));
+				position = (lineEnd != nullptr) ? lineEnd : end;
+			}
+			else {
+				// skips white characters
+				if (*position == '\n')
 					lineNumber++;
-
-				c = input.get();
+				++position;
 			}
+		}
 
-			if (c == '#') {
-				// '#' means start of the comment => discard the rest of the line
-				discardThisLine(input);
-				lineNumber++;
-				c = input.get();
-			}
+		if (position == end) {
+			Token result(TokenType::END_OF_STREAM, lineNumber);
+			result.offset = (std::size_t)(position - begin);
+			return result;
 		}
 
-		if (input.good() == false)
-			return Token(TokenType::END_OF_STREAM, lineNumber);
+		std::size_t offset = (std::size_t)(position - begin);
+		Token result = readToken();
+		result.offset = offset;
+		return result;
+	}
 
+	Token Lexer::readToken()
+	{
+		char c = *position++;
 		switch (c) {
 		case '*': return Token(TokenType::ASTERISK, lineNumber);
 		case ':': return Token(TokenType::COLON, lineNumber);
@@ -190,51 +326,30 @@ namespace ps {
 		}
 
 		int oldLineNumber = lineNumber;	// this is necessary beacause string can span multiple lines
-		if (c == '"')	// reading string
-			return Token(readString(), oldLineNumber);
+		if (c == '"') {	// reading string
+			StringRef text = readString();
+			return Token(TokenType::STRING, text, oldLineNumber);
+		}
 
 		if (isAlpha(c)) { // reading identifier
-			input.putback(c);
-			Token result(TokenType::ID, lineNumber);
-			result.value.s = readIdentifier();
+			--position;
+			Token result(TokenType::ID, readIdentifier(), lineNumber);
+			result.value.symbol = symbols.intern(result.value.s);
 			return result;
 		}
 
-		bool negativeNumber = false;
 		if (c == '-') {
-			c = input.get();
-			if (isNum(c) == false) {
+			if (position == end || isNum(*position) == false)
 				// this was just ordinary minus with not-number char afterwards, e.g. "-hello"
-				input.putback(c);
 				return Token(TokenType::MINUS, lineNumber);
-			}
 			else
 				// this is minus in front of number, e.g. "-234"
-				negativeNumber = true;
+				return readNumber(true);
 		}
 
 		if (isNum(c)) { // reading number
-			std::string number;
-			number.push_back(c);
-			bool floatNum = false;
-
-			while (input.get(c)) {
-				if (isNum(c)) {
-					number.push_back(c);
-				}
-				else if (c == '.') {
-					number.push_back(c);
-					floatNum = true;
-				}
-				else {
-					input.putback(c);
-
-					if (floatNum)
-						return Token((negativeNumber ? -1.0f : 1.0f) * std::stof(number), lineNumber);
-					else
-						return Token((negativeNumber ? -1 : 1) * std::stoi(number), lineNumber);
-				}
-			}
+			--position;
+			return readNumber(false);
 		}
 
 		return Token(TokenType::ERROR, lineNumber);
@@ -254,13 +369,13 @@ namespace ps {
 	std::string Lexer::eatIdentifier()
 	{
 		Token token = eat(TokenType::ID);
-		return token.value.s;
+		return token.getString();
 	}
 
 	std::string Lexer::eatString()
 	{
 		Token token = eat(TokenType::STRING);
-		return token.value.s;
+		return token.getString();
 	}
 
 	int Lexer::eatInt()
@@ -3,6 +3,9 @@
 #define PS_LEXER_INCLUDED
 #include <exception>
 #include <string>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace ps {
 
@@ -44,18 +47,57 @@ namespace ps {
 
 	/// For each token there is a string that describes it, e.g. TokenType::LCBRA --> "Left curly brace".
 	std::string getTokenString(TokenType type);
-	/// Structure containing the value of token (string, int, or float).
+
+	/// Characters of the input of the lexer. The characters are not copied, so the reference is valid only while the input is.
+	struct StringRef {
+		const char * data;
+		std::size_t size;
+
+		/// Copies the characters into string.
+		std::string str() const;
+		bool operator==(const char * other) const;
+		bool operator!=(const char * other) const;
+	};
+
+	/// Identifier interned by SymbolTable. Symbols are dense (0, 1, 2, ... in the order the identifiers first appear), so they can index arrays.
+	using Symbol = std::uint32_t;
+
+	/// Table assigning a symbol to each distinct identifier. Identifiers are kept in open-addressing hash table, so interning takes constant
+	/// time, and the names are not copied (they refer to the input of the lexer).
+	class SymbolTable {
+	private:
+		std::vector<StringRef> names;	///< Name of each symbol.
+		std::vector<Symbol> slots;		///< Hash table of the symbols (symbol + 1, 0 is empty slot). Size is power of two.
+
+		static std::size_t hash(StringRef name);
+		/// Finds the slot of the name (slot with the name, or empty slot where the name belongs).
+		std::size_t findSlot(StringRef name) const;
+
+	public:
+		SymbolTable();
+
+		/// Gets the symbol of the name. Name that was not interned yet gets new symbol.
+		Symbol intern(StringRef name);
+		/// Gets the name of the symbol.
+		StringRef getName(Symbol symbol) const;
+		/// Returns how many distinct names were interned.
+		std::size_t size() const;
+	};
+
+	/// Structure containing the value of token (characters, int, or float).
 	struct TokenValue {		// This could be a union, but I had problem with default constructor
-		std::string	s;
+		StringRef s;	///< Characters of identifier, or characters between the quotes of string (with the escape characters still in).
 		int i;
 		float f;
+		Symbol symbol;	///< Interned identifier (ID tokens only).
 	};
 
 	/// Class representing lexical element.
 	class Token {
 	public:
 		TokenType type;		///< Type of token.
-		TokenValue value;	///< Value of token (string/int/float).
+		TokenValue value;	///< Value of token (characters/int/float).
+		std::size_t offset;	///< Offset of the first character of the token in the input.
 		int lineNumber;		///< Number of line the token was found on.
 
 		/// Creates token of specidied type.
@@ -66,8 +108,11 @@ namespace ps {
 		Token(float floatValue, int lineNumber);
 		/// Creates token of INT type.
 		Token(int intValue, int lineNumber);
-		/// Creates token of STRING type.
-		Token(std::string stringValue, int lineNumber);
+		/// Creates token of given type, that consists of given characters (ID or STRING).
+		Token(TokenType type, StringRef text, int lineNumber);
+
+		/// Gets the identifier, or the string with the escape characters resolved.
+		std::string getString() const;
 	};
 
 
@@ -76,18 +121,31 @@ namespace ps {
 	// LEXER
 	//***********************************************
 
-	/// Lexical analyzer class.
+	/// Lexical analyzer class. The lexer works on the whole input in one buffer (slurped or memory mapped file), so the tokens only refer
+	/// to the characters of the buffer, and nothing is copied while the input is read.
 	class Lexer {
 	private:
-		std::istream & input;	///< Input for the lexer.
+		const char * begin;		///< Start of the input.
+		const char * end;		///< End of the input.
+		const char * position;	///< Character that is read next.
 		int lineNumber;			///< Line the lexer is on.
+		SymbolTable symbols;	///< Identifiers of the input.
 		Token lookahead;		///< Token that comes next (it will be returned in next getNextToken()).
 
-		std::string readString();
-		std::string readIdentifier();
+		StringRef readString();
+		StringRef readIdentifier();
+		Token readNumber(bool negative);
+		/// Reads token starting at current position (white characters and comments were skipped already).
+		Token readToken();
 
 	public:
-		Lexer(std::istream & input_);
+		/// Creates lexer reading given characters. The characters have to stay valid while the lexer and its tokens are used.
+		Lexer(const char * data, std::size_t size);
+
+		/// Gets the table of the identifiers read so far.
+		const SymbolTable & getSymbols() const;
+		/// Gets symbol of given identifier (the identifier does not have to be in the input).
+		Symbol intern(StringRef name);
 
 		/// Gets the token that will be read next.
 		const Token & getLookahead();
@@ -0,0 +1,135 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ps {
+
+	//**************************************************************************
+	// MAPPED FILE
+	//**************************************************************************
+
+#ifdef _WIN32
+	MappedFile::MappedFile() : data(nullptr), size(0), file(INVALID_HANDLE_VALUE), mapping(nullptr) {
+	}
+#else
+	MappedFile::MappedFile() : data(nullptr), size(0), file(-1) {
+	}
+#endif
+
+	MappedFile::MappedFile(const std::string & path) : MappedFile() {
+		open(path);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::open(const std::string & path)
+	{
+		close();
+
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+			close();
+			return false;
+		}
+
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr) {
+			close();
+			return false;
+		}
+
+		data = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (data == nullptr) {
+			close();
+			return false;
+		}
+
+		size = (std::size_t)fileSize.QuadPart;
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (data != nullptr)
+			UnmapViewOfFile(data);
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+
+		data = nullptr;
+		size = 0;
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+	}
+#else
+	bool MappedFile::open(const std::string & path)
+	{
+		close();
+
+		file = ::open(path.c_str(), O_RDONLY);
+		if (file < 0)
+			return false;
+
+		struct stat status;
+		if (fstat(file, &status) != 0 || status.st_size == 0) {
+			close();
+			return false;
+		}
+
+		void * view = mmap(nullptr, (std::size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (view == MAP_FAILED) {
+			close();
+			return false;
+		}
+
+		data = static_cast<const char *>(view);
+		size = (std::size_t)status.st_size;
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (data != nullptr)
+			munmap(const_cast<char *>(data), size);
+		if (file >= 0)
+			::close(file);
+
+		data = nullptr;
+		size = 0;
+		file = -1;
+	}
+#endif
+
+	bool MappedFile::isOpen() const
+	{
+		return data != nullptr;
+	}
+
+	const char * MappedFile::getData() const
+	{
+		return data;
+	}
+
+	std::size_t MappedFile::getSize() const
+	{
+		return size;
+	}
+}
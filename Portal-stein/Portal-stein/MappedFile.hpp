@@ -0,0 +1,49 @@
+#pragma once
+#ifndef PS_MAPPED_FILE_INCLUDED
+#define PS_MAPPED_FILE_INCLUDED
+#include <string>
+#include <cstddef>
+
+namespace ps {
+
+	//**************************************************************************
+	// MAPPED FILE
+	//**************************************************************************
+
+	/// Whole file mapped into memory for reading. Opening the file does not read it: pages of the file are read by the operating system
+	/// when they are accessed for the first time, and they are shared with the file cache.
+	class MappedFile {
+	private:
+		const char * data;
+		std::size_t size;
+#ifdef _WIN32
+		void * file;		///< Handle of the file.
+		void * mapping;		///< Handle of the file mapping.
+#else
+		int file;			///< Descriptor of the file.
+#endif
+
+	public:
+		/// Creates mapped file, that is not open.
+		MappedFile();
+		/// Maps the file at given path. Use isOpen() to find out whether it succeeded.
+		explicit MappedFile(const std::string & path);
+		~MappedFile();
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile & operator=(const MappedFile &) = delete;
+
+		/// Maps the file at given path (the file mapped before is closed). Returns false if the file cannot be mapped (empty files cannot).
+		bool open(const std::string & path);
+		/// Unmaps the file. Data of the file cannot be used after this call.
+		void close();
+		/// Returns true if a file is mapped.
+		bool isOpen() const;
+		/// Gets contents of the file (nullptr if no file is mapped).
+		const char * getData() const;
+		/// Gets size of the file in bytes.
+		std::size_t getSize() const;
+	};
+}
+
+#endif // !PS_MAPPED_FILE_INCLUDED
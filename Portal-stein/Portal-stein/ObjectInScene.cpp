@@ -38,7 +38,11 @@ namespace ps {
 	}
 
 	void ObjectInScene::rotate(float angle) {
-		ps::rotate(direction, angle);
+		rotate(cos(angle), sin(angle));
+	}
+
+	void ObjectInScene::rotate(float cosAngle, float sinAngle) {
+		ps::rotate(direction, cosAngle, sinAngle);
 		normalize(direction);
 	}
 
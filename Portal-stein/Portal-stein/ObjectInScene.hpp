@@ -5,7 +5,7 @@
 
 namespace ps {
 
-	class LineSegment;
+	class AffineTransform;
 
 	/// Base class for object inside the scene.
 	class ObjectInScene {
@@ -40,10 +40,12 @@ namespace ps {
 		void ascend(float distance);
 
 		/// Rotates the object around the z-axis, which changes its direction. The position of object is not changed.
-		virtual void rotate(float angle);
+		void rotate(float angle);
+		/// Rotates the object around the z-axis by angle given by its cosine and sine. Derived objects, that rotate more than direction, override this.
+		virtual void rotate(float cosAngle, float sinAngle);
 
-		/// LineSegment::mapLineSegments(const LineSegment & a, const LineSegment & b, ObjectInScene & obj) will need to acess the position of the object directly.
-		friend class LineSegment;
+		/// AffineTransform::apply(ObjectInScene & obj) will need to acess the position of the object directly.
+		friend class AffineTransform;
 	};
 
 	using Ray = ObjectInScene;
@@ -3,21 +3,66 @@
 
 namespace ps {
 
-	Door::Door(std::size_t targetSegment_) : targetSegment(targetSegment_) {	
+	Portal::Portal() : type(Type::NONE), targetSegment(0), transform() {
 	}
 
-	void Door::stepThrough(ObjectInScene & obj)
+	Portal::Portal(Type type_, std::size_t targetSegment_, const AffineTransform & transform_) : type(type_), targetSegment(targetSegment_), transform(transform_) {
+	}
+
+	Portal::Type Portal::getType() const
+	{
+		return type;
+	}
+
+	bool Portal::isPortal() const
 	{
-		obj.moveIntoSegment(targetSegment);
+		return type != Type::NONE;
 	}
 
-	WallPortal::WallPortal(const LineSegment & from_, const LineSegment & to_, std::size_t targetSegment_) : fromWall(from_), toWall(to_), targetSegment(targetSegment_) { 
+	std::size_t Portal::getTargetSegment() const
+	{
+		return targetSegment;
+	}
+
+	const AffineTransform & Portal::getTransform() const
+	{
+		return transform;
+	}
+
+	void Portal::stepThrough(ObjectInScene & obj) const
+	{
+		switch (type) {
+		case Type::NONE:
+			break;
+		case Type::DOOR:
+			obj.moveIntoSegment(targetSegment);
+			break;
+		case Type::WALL_PORTAL:
+			obj.moveIntoSegment(targetSegment);
+			transform.apply(obj);
+			break;
+		}
+	}
+
+	Portal Portal::then(const Portal & next) const
+	{
+		if (!isPortal())
+			return next;
+		if (!next.isPortal())
+			return *this;
+
+		Type composedType = (type == Type::DOOR && next.type == Type::DOOR) ? Type::DOOR : Type::WALL_PORTAL;
+		return Portal(composedType, next.targetSegment, transform.then(next.transform));
+	}
+
+	Portal makeDoor(std::size_t targetSegment_)
+	{
+		return Portal(Portal::Type::DOOR, targetSegment_, AffineTransform());
 	}
 
-	void WallPortal::stepThrough(ObjectInScene & obj)
+	Portal makeWallPortal(const LineSegment & from_, const LineSegment & to_, std::size_t targetSegment_)
 	{
-		obj.moveIntoSegment(targetSegment);
-		LineSegment::mapLineSegments(fromWall, toWall, obj);
+		return Portal(Portal::Type::WALL_PORTAL, targetSegment_, AffineTransform::mapLineSegments(from_, to_));
 	}
 	
 }
\ No newline at end of file
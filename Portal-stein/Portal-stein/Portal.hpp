@@ -1,7 +1,6 @@
 #pragma once
 #ifndef PS_PORTAL_INCLUDED
 #define PS_PORTAL_INCLUDED
-#include <memory>
 #include "SFML\Graphics.hpp"
 #include "ObjectInScene.hpp"
 #include "Geometry.hpp"
@@ -12,47 +11,48 @@ namespace ps {
 	// PORTAL CLASSES
 	//******************************************************************
 
-	/// Abstract class for portals, which are things that can transport ObjectInScene.
+	/// Portal transports ObjectInScene into another segment. Door only changes the segment the object is in, wall portal also maps the
+	/// object from the wall the portal is in to the wall it leads to. The mapping is precomputed as affine transform when the portal is
+	/// created, so stepping through the portal costs one matrix multiply.
 	class Portal {
 	public:
-		/// Object steps through portal.
-		virtual void stepThrough(ObjectInScene & obj) = 0;
-	};
-
-
-	/// Portal that only changes the segment the object is in. No change of position, or direction is applied.
-	class Door : public Portal {
-	private:
-		std::size_t targetSegment;	///< Id of the segment the portal points to.
-
-	public:
-		/// Creates door to segment specified by its ID.
-		Door(std::size_t targetSegment_);
-
-		/// Object steps through door.
-		void stepThrough(ObjectInScene & obj);
-	};
-
+		enum class Type {
+			NONE, DOOR, WALL_PORTAL
+		};
 
-	/// Portal that connects two 2D line segments. 
-	class WallPortal : public Portal {
 	private:
+		Type type;
 		std::size_t targetSegment;	///< Id of the segment the portal points to.
-		LineSegment fromWall;		///< Wall the portal is in.
-		LineSegment toWall;			///< Wall the portal leads to.
+		AffineTransform transform;	///< Maps objects from the wall the portal is in to the wall it leads to.
 
 	public:
-		/// Creates portal between two walls into segment specified by its ID.
-		/// \param from_ Portal starts here.
-		/// \param to_ Portal leads here.
-		/// \param targetSegment_ Id of the segment portal leads to.
-		WallPortal(const LineSegment & from_, const LineSegment & to_, std::size_t targetSegment_);
+		/// Creates no portal (nothing steps through it).
+		Portal();
+		/// Creates portal of given type, that leads to segment specified by its ID.
+		Portal(Type type_, std::size_t targetSegment_, const AffineTransform & transform_);
+
+		/// Gets type of the portal.
+		Type getType() const;
+		/// Returns false for Type::NONE.
+		bool isPortal() const;
+		/// Gets ID of the segment the portal leads to.
+		std::size_t getTargetSegment() const;
+		/// Gets transformation, that maps objects stepping through the portal.
+		const AffineTransform & getTransform() const;
 
 		/// Object steps through portal.
-		void stepThrough(ObjectInScene & obj);
+		void stepThrough(ObjectInScene & obj) const;
+		/// Makes the portal, that leads through this portal and then through the next one (it is a door, if both of them are doors).
+		Portal then(const Portal & next) const;
 	};
 
+	/// Makes portal that only changes the segment the object is in. No change of position, or direction is applied.
+	Portal makeDoor(std::size_t targetSegment_);
 
-	using portalPtr = std::shared_ptr<Portal>;
+	/// Makes portal that connects two 2D line segments.
+	/// \param from_ Portal starts here.
+	/// \param to_ Portal leads here.
+	/// \param targetSegment_ Id of the segment portal leads to.
+	Portal makeWallPortal(const LineSegment & from_, const LineSegment & to_, std::size_t targetSegment_);
 }
 #endif // !PS_PORTAL_INCLUDED
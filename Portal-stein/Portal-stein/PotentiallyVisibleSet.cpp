@@ -0,0 +1,292 @@
+#include "PotentiallyVisibleSet.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include "Math.hpp"
+
+namespace ps {
+
+	//******************************************************************
+	// HELPERS
+	//******************************************************************
+
+	// Distances smaller than this are treated as zero (levels are measured in units of wall height).
+	const float VISIBILITY_EPSILON = 0.0001f;
+
+	// Chain of portals followed from the source segment. Both line segments are in the coordinates of the segment the chain leads into.
+	struct PortalChain {
+		std::size_t segment;	// segment the chain leads into
+		int depth;				// number of portals in the chain
+		sf::Vector2f source[2];	// first portal of the chain (every line seen through the chain goes through it)
+		sf::Vector2f last[2];	// part of the last portal, that can be seen through the previous portals
+	};
+
+	// Clips line segment a - b to the half-plane of points p with side * cross(lineDirection, p - linePoint) >= margin. Returns false
+	// if nothing is left.
+	bool clipToHalfPlane(sf::Vector2f & a, sf::Vector2f & b, sf::Vector2f linePoint, sf::Vector2f lineDirection, float side, float margin) {
+		float fa = side * cross(lineDirection, a - linePoint) - margin;
+		float fb = side * cross(lineDirection, b - linePoint) - margin;
+
+		if (fa < 0.0f && fb < 0.0f)
+			return false;
+
+		if (fa < 0.0f)
+			a = a + (b - a) * (fa / (fa - fb));
+		else if (fb < 0.0f)
+			b = b + (a - b) * (fb / (fb - fa));
+
+		return true;
+	}
+
+	// Clips the wall (in the segment the chain leads into) to the part, that can be seen through all the portals of the chain. Lines
+	// going through source and last portal are bounded by the separating lines (they go through an end point of each portal, and have
+	// the portals on their opposite sides), the visible part of the wall lies beyond the last portal between them. Returns false if no
+	// part of the wall can be seen.
+	bool clipToChain(const PortalChain & chain, sf::Vector2f & a, sf::Vector2f & b) {
+		const sf::Vector2f * source = chain.source;
+		const sf::Vector2f * last = chain.last;
+
+		// wall has to lie beyond the last portal (rays left its segment through it)
+		float lastNorm = norm(last[1] - last[0]);
+		if (!clipToHalfPlane(a, b, last[0], last[1] - last[0], 1.0f, VISIBILITY_EPSILON * lastNorm))
+			return false;
+
+		for (int i = 0; i < 2; ++i) {
+			for (int j = 0; j < 2; ++j) {
+				sf::Vector2f direction = last[j] - source[i];
+				float directionNorm = norm(direction);
+				if (directionNorm < VISIBILITY_EPSILON)
+					continue;
+
+				float sourceSide = cross(direction, source[1 - i] - source[i]);
+				float lastSide = cross(direction, last[1 - j] - source[i]);
+				float margin = VISIBILITY_EPSILON * directionNorm;
+				if ((sourceSide < -margin && lastSide > margin) || (sourceSide > margin && lastSide < -margin)) {
+					// visible lines are on the side of the other end point of the last portal (boundary is included)
+					if (!clipToHalfPlane(a, b, source[i], direction, (lastSide > 0.0f) ? 1.0f : -1.0f, -margin))
+						return false;
+				}
+			}
+		}
+
+		return norm(b - a) >= VISIBILITY_EPSILON;
+	}
+
+	// Returns true if both transforms are exactly the same (the transforms of the portals read from the same text are).
+	bool isSameTransform(const AffineTransform & a, const AffineTransform & b) {
+		for (int row = 0; row < 2; ++row) {
+			for (int column = 0; column < 2; ++column) {
+				if (a.getLinear().getElement(row, column) != b.getLinear().getElement(row, column))
+					return false;
+			}
+		}
+
+		return a.getTranslation() == b.getTranslation() && a.getCosRotation() == b.getCosRotation() && a.getSinRotation() == b.getSinRotation();
+	}
+
+	// Returns true if the portal walls of the segment are the same in both graphs (in the same order).
+	bool isSamePortalWalls(const std::vector<PortalEdge> & a, const std::vector<PortalEdge> & b) {
+		if (a.size() != b.size())
+			return false;
+
+		for (std::size_t i = 0; i < a.size(); ++i) {
+			if (a[i].wall.getFrom() != b[i].wall.getFrom() || a[i].wall.getTo() != b[i].wall.getTo())
+				return false;
+			if (a[i].portal.getType() != b[i].portal.getType() || a[i].portal.getTargetSegment() != b[i].portal.getTargetSegment())
+				return false;
+			if (!isSameTransform(a[i].portal.getTransform(), b[i].portal.getTransform()))
+				return false;
+		}
+
+		return true;
+	}
+
+
+
+	//******************************************************************
+	// PORTAL GRAPH
+	//******************************************************************
+
+	std::vector<bool> findAffectedSegments(const PortalGraph & graph, const PortalGraph & previousGraph, int maxDepth)
+	{
+		// segments pointing to each segment
+		std::vector<std::vector<std::size_t>> sources(graph.size());
+		for (std::size_t i = 0; i < graph.size(); ++i) {
+			for (auto & edge : graph[i]) {
+				if (edge.portal.getTargetSegment() < graph.size())
+					sources[edge.portal.getTargetSegment()].push_back(i);
+			}
+		}
+
+		std::vector<int> depth(graph.size(), -1);	// number of portals from the segment to the nearest changed segment
+		std::vector<std::size_t> queue;
+		for (std::size_t i = 0; i < graph.size(); ++i) {
+			if (i >= previousGraph.size() || !isSamePortalWalls(graph[i], previousGraph[i])) {
+				depth[i] = 0;
+				queue.push_back(i);
+			}
+		}
+
+		// chains followed from a segment have at most maxDepth portals, the segments farther from all the changes keep their sets
+		for (std::size_t i = 0; i < queue.size(); ++i) {
+			std::size_t segment = queue[i];
+			if (depth[segment] >= maxDepth)
+				continue;
+
+			for (std::size_t source : sources[segment]) {
+				if (depth[source] < 0) {
+					depth[source] = depth[segment] + 1;
+					queue.push_back(source);
+				}
+			}
+		}
+
+		std::vector<bool> affected(graph.size());
+		for (std::size_t i = 0; i < graph.size(); ++i)
+			affected[i] = (depth[i] >= 0);
+		return affected;
+	}
+
+
+
+	//******************************************************************
+	// POTENTIALLY VISIBLE SET
+	//******************************************************************
+
+	constexpr std::size_t PotentiallyVisibleSet::chainBudget;
+
+	PotentiallyVisibleSet::PotentiallyVisibleSet() : visible() {
+	}
+
+	PotentiallyVisibleSet::PotentiallyVisibleSet(const PortalGraph & graph, int maxDepth) : visible() {
+		visible.reserve(graph.size());
+		for (std::size_t i = 0; i < graph.size(); ++i)
+			visible.push_back(computeFrom(graph, i, maxDepth));
+	}
+
+	PotentiallyVisibleSet::PotentiallyVisibleSet(const PortalGraph & graph, int maxDepth, const PortalGraph & previousGraph,
+		const PotentiallyVisibleSet & previous) : visible()
+	{
+		std::vector<bool> affected = findAffectedSegments(graph, previousGraph, maxDepth);
+
+		visible.reserve(graph.size());
+		for (std::size_t i = 0; i < graph.size(); ++i) {
+			if (affected[i] || i >= previous.visible.size())
+				visible.push_back(computeFrom(graph, i, maxDepth));
+			else
+				visible.push_back(previous.visible[i]);
+		}
+	}
+
+	PotentiallyVisibleSet::PotentiallyVisibleSet(std::vector<std::vector<std::size_t>> && visible_) : visible(std::move(visible_)) {
+	}
+
+	std::vector<std::size_t> PotentiallyVisibleSet::computeFrom(const PortalGraph & graph, std::size_t segmentId, int maxDepth) const
+	{
+		std::vector<bool> isSeen(graph.size(), false);
+		isSeen[segmentId] = true;
+
+		// chains leaving the source segment are followed depth first, every wall of their segment narrows them
+		std::vector<PortalChain> chains;
+		std::vector<PortalChain> unfinished;	// chains that were not followed, because the budget ran out
+		std::size_t followed = 0;
+
+		for (auto & edge : graph[segmentId]) {
+			if (maxDepth < 1 || edge.portal.getTargetSegment() >= graph.size())
+				continue;
+
+			// camera can be anywhere in its segment, so whole portal can be seen
+			auto & transform = edge.portal.getTransform();
+			PortalChain chain;
+			chain.segment = edge.portal.getTargetSegment();
+			chain.depth = 1;
+			chain.source[0] = chain.last[0] = transform.transformPoint(edge.wall.getFrom());
+			chain.source[1] = chain.last[1] = transform.transformPoint(edge.wall.getTo());
+
+			isSeen[chain.segment] = true;
+			chains.push_back(chain);
+		}
+
+		while (!chains.empty()) {
+			PortalChain chain = chains.back();
+			chains.pop_back();
+
+			if (chain.depth >= maxDepth)
+				continue;
+			if (followed++ >= chainBudget) {
+				unfinished.push_back(chain);
+				continue;
+			}
+
+			for (auto & edge : graph[chain.segment]) {
+				sf::Vector2f a = edge.wall.getFrom();
+				sf::Vector2f b = edge.wall.getTo();
+				if (edge.portal.getTargetSegment() >= graph.size() || !clipToChain(chain, a, b))
+					continue;
+
+				auto & transform = edge.portal.getTransform();
+				PortalChain next;
+				next.segment = edge.portal.getTargetSegment();
+				next.depth = chain.depth + 1;
+				next.source[0] = transform.transformPoint(chain.source[0]);
+				next.source[1] = transform.transformPoint(chain.source[1]);
+				next.last[0] = transform.transformPoint(a);
+				next.last[1] = transform.transformPoint(b);
+
+				isSeen[next.segment] = true;
+				chains.push_back(next);
+			}
+		}
+
+		// segments behind the chains over budget are reached through the portal graph only (every portal is taken as visible)
+		std::vector<int> reachedDepth(graph.size(), maxDepth + 1);
+		std::vector<std::size_t> queue;
+		for (auto & chain : unfinished) {
+			if (chain.depth < reachedDepth[chain.segment]) {
+				reachedDepth[chain.segment] = chain.depth;
+				queue.push_back(chain.segment);
+			}
+		}
+
+		for (std::size_t i = 0; i < queue.size(); ++i) {
+			std::size_t segment = queue[i];
+			if (reachedDepth[segment] >= maxDepth)
+				continue;
+
+			for (auto & edge : graph[segment]) {
+				std::size_t target = edge.portal.getTargetSegment();
+				if (target < graph.size() && reachedDepth[segment] + 1 < reachedDepth[target]) {
+					reachedDepth[target] = reachedDepth[segment] + 1;
+					isSeen[target] = true;
+					queue.push_back(target);
+				}
+			}
+		}
+
+		std::vector<std::size_t> result;
+		for (std::size_t i = 0; i < isSeen.size(); ++i) {
+			if (isSeen[i])
+				result.push_back(i);
+		}
+
+		return result;
+	}
+
+	std::size_t PotentiallyVisibleSet::getSegmentCount() const
+	{
+		return visible.size();
+	}
+
+	const std::vector<std::size_t> & PotentiallyVisibleSet::getVisibleSegments(std::size_t segmentId) const
+	{
+		if (segmentId >= visible.size())
+			throw std::out_of_range("Segment " + std::to_string(segmentId) + " is not in the potentially visible set.");
+
+		return visible[segmentId];
+	}
+
+	bool PotentiallyVisibleSet::isVisible(std::size_t from, std::size_t to) const
+	{
+		auto & segments = getVisibleSegments(from);
+		return std::binary_search(segments.begin(), segments.end(), to);
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#ifndef PS_POTENTIALLY_VISIBLE_SET_INCLUDED
+#define PS_POTENTIALLY_VISIBLE_SET_INCLUDED
+#include <vector>
+#include "Geometry.hpp"
+#include "Portal.hpp"
+
+namespace ps {
+
+	//******************************************************************
+	// PORTAL GRAPH
+	//******************************************************************
+
+	/// Portal wall of a segment, as seen by the visibility analysis.
+	struct PortalEdge {
+		LineSegment wall;	///< Wall the portal is in (rays leave the segment through it).
+		Portal portal;		///< Portal leading to the next segment.
+	};
+
+	/// Portal walls of each segment (indexed by segment id).
+	using PortalGraph = std::vector<std::vector<PortalEdge>>;
+
+	/// Finds the segments of the graph, whose visible segments can differ from those in previous version of the graph. These are the
+	/// segments, that reach a segment with changed portal walls by a chain of at most maxDepth portals (new segments are changed too).
+	std::vector<bool> findAffectedSegments(const PortalGraph & graph, const PortalGraph & previousGraph, int maxDepth);
+
+
+
+	//******************************************************************
+	// POTENTIALLY VISIBLE SET
+	//******************************************************************
+
+	/// Segments, that can be seen from each segment through chains of portals (doors and wall portals). Camera can be anywhere in its
+	/// segment and look anywhere, so the sets are conservative: segment that is not in the set of the camera segment is never rendered,
+	/// segment in the set might be. A chain of portals is followed only while some line can go through all of its portals, so segments
+	/// hidden behind corners are left out. Portals that transform space are followed in the coordinates of the segment they lead to.
+	class PotentiallyVisibleSet {
+	private:
+		/// Number of portal chains followed from one segment. Segments beyond the budget are reached by the portal graph only.
+		static constexpr std::size_t chainBudget = 100000;
+
+		std::vector<std::vector<std::size_t>> visible;	///< Sorted ids of the segments visible from each segment (it includes the segment).
+
+		/// Finds the segments visible from given segment.
+		std::vector<std::size_t> computeFrom(const PortalGraph & graph, std::size_t segmentId, int maxDepth) const;
+
+	public:
+		/// Creates empty set (no segments).
+		PotentiallyVisibleSet();
+		/// Computes the sets for all the segments of the graph. Chains of at most maxDepth portals are followed.
+		PotentiallyVisibleSet(const PortalGraph & graph, int maxDepth);
+		/// Computes the sets for the graph, that is an edited version of previousGraph, whose sets are previous. Only the sets of the
+		/// segments found by findAffectedSegments() are computed, the other sets are taken from previous.
+		PotentiallyVisibleSet(const PortalGraph & graph, int maxDepth, const PortalGraph & previousGraph, const PotentiallyVisibleSet & previous);
+		/// Creates the sets computed before (e.g. stored in a compiled level). Ids of each set must be sorted.
+		explicit PotentiallyVisibleSet(std::vector<std::vector<std::size_t>> && visible_);
+
+		/// Gets the number of segments.
+		std::size_t getSegmentCount() const;
+		/// Gets sorted ids of the segments, that can be seen from given segment. If no such segment exists std::out_of_range is thrown.
+		const std::vector<std::size_t> & getVisibleSegments(std::size_t segmentId) const;
+		/// Returns true if segment to can be seen from segment from.
+		bool isVisible(std::size_t from, std::size_t to) const;
+	};
+}
+
+#endif // !PS_POTENTIALLY_VISIBLE_SET_INCLUDED
@@ -0,0 +1,142 @@
+#include "Profiler.hpp"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <iomanip>
+
+namespace ps {
+
+	//*********************************************************************************
+	// THREAD BUFFERS
+	//*********************************************************************************
+
+	// Scope recorded by one thread (times are in microseconds from the start of the program).
+	struct TraceEvent {
+		const char * name;
+		double start;
+		double duration;
+	};
+
+	// Scopes recorded by one thread. Only the thread itself appends to it.
+	struct ThreadTrace {
+		std::size_t threadIndex;
+		std::vector<TraceEvent> events;
+	};
+
+	// Buffers of all the threads that recorded something. Buffers outlive their threads, so the trace has the scopes of finished threads too.
+	struct TraceRegistry {
+		std::mutex mutex;
+		std::vector<std::unique_ptr<ThreadTrace>> threads;
+		Profiler::Clock::time_point epoch;
+
+		TraceRegistry() : mutex(), threads(), epoch(Profiler::Clock::now()) {}
+	};
+
+	static TraceRegistry & getRegistry() {
+		static TraceRegistry registry;
+		return registry;
+	}
+
+	// Gets the buffer of calling thread (it is registered on the first call).
+	static ThreadTrace & getThreadTrace() {
+		thread_local ThreadTrace * trace = nullptr;
+
+		if (trace == nullptr) {
+			TraceRegistry & registry = getRegistry();
+			std::lock_guard<std::mutex> lock{ registry.mutex };
+
+			registry.threads.push_back(std::make_unique<ThreadTrace>());
+			trace = registry.threads.back().get();
+			trace->threadIndex = registry.threads.size() - 1;
+			trace->events.reserve(4096);
+		}
+
+		return *trace;
+	}
+
+
+
+	//*********************************************************************************
+	// PROFILER
+	//*********************************************************************************
+
+	void Profiler::record(const char * name, Clock::time_point start, Clock::time_point end)
+	{
+		using Microseconds = std::chrono::duration<double, std::micro>;
+		Clock::time_point epoch = getRegistry().epoch;
+
+		TraceEvent event;
+		event.name = name;
+		event.start = Microseconds(start - epoch).count();
+		event.duration = Microseconds(end - start).count();
+		getThreadTrace().events.push_back(event);
+	}
+
+	std::size_t Profiler::getEventCount()
+	{
+		TraceRegistry & registry = getRegistry();
+		std::lock_guard<std::mutex> lock{ registry.mutex };
+
+		std::size_t count = 0;
+		for (auto & thread : registry.threads)
+			count += thread->events.size();
+
+		return count;
+	}
+
+	void Profiler::writeChromeTrace(std::ostream & output)
+	{
+		TraceRegistry & registry = getRegistry();
+		std::lock_guard<std::mutex> lock{ registry.mutex };
+
+		// complete events ("ph": "X") carry both the start and the duration of the scope
+		output << std::fixed << std::setprecision(3);
+		output << "{ \"traceEvents\": [";
+
+		bool first = true;
+		for (auto & thread : registry.threads) {
+			for (auto & event : thread->events) {
+				output << ((first) ? "\n" : ",\n");
+				output << "\t{ \"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << thread->threadIndex <<
+					", \"ts\": " << event.start << ", \"dur\": " << event.duration << " }";
+				first = false;
+			}
+		}
+
+		output << "\n], \"displayTimeUnit\": \"ms\" }\n";
+	}
+
+	bool Profiler::writeChromeTrace(const std::string & filePath)
+	{
+		std::ofstream output{ filePath };
+		if (!output)
+			return false;
+
+		writeChromeTrace(output);
+		return (bool)output;
+	}
+
+	void Profiler::clear()
+	{
+		TraceRegistry & registry = getRegistry();
+		std::lock_guard<std::mutex> lock{ registry.mutex };
+
+		for (auto & thread : registry.threads)
+			thread->events.clear();
+	}
+
+
+
+	//*********************************************************************************
+	// PROFILE SCOPE
+	//*********************************************************************************
+
+	ProfileScope::ProfileScope(const char * name_) : name(name_), start(Profiler::Clock::now()) {
+	}
+
+	ProfileScope::~ProfileScope()
+	{
+		Profiler::record(name, start, Profiler::Clock::now());
+	}
+}
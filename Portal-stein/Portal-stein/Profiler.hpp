@@ -0,0 +1,59 @@
+#pragma once
+#ifndef PS_PROFILER_INCLUDED
+#define PS_PROFILER_INCLUDED
+#include <chrono>
+#include <ostream>
+#include <string>
+
+/// PS_PROFILE_SCOPE(name) measures the time from the macro to the end of the enclosing scope. Builds without PS_PROFILING defined
+/// compile the macro out, so it costs nothing there. Name has to be a string literal (only the pointer is stored).
+#ifdef PS_PROFILING
+#define PS_PROFILE_CONCAT_IMPL(a, b) a##b
+#define PS_PROFILE_CONCAT(a, b) PS_PROFILE_CONCAT_IMPL(a, b)
+#define PS_PROFILE_SCOPE(name) ::ps::ProfileScope PS_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PS_PROFILE_SCOPE(name)
+#endif
+
+namespace ps {
+
+	//*********************************************************************************
+	// PROFILER
+	//*********************************************************************************
+
+	/// Collects the timed scopes of all the threads. Every thread appends to its own buffer, so recording takes no lock (the lock is
+	/// taken only when a thread records its first scope, to register its buffer). Buffers are kept until clear() is called.
+	class Profiler {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		/// Records scope that ran from start to end on the calling thread.
+		static void record(const char * name, Clock::time_point start, Clock::time_point end);
+		/// Gets the number of scopes recorded by all the threads.
+		static std::size_t getEventCount();
+		/// Writes all the recorded scopes in Chrome trace-event format (it can be opened by chrome://tracing, or other trace viewers).
+		/// Other threads must not record while the trace is written.
+		static void writeChromeTrace(std::ostream & output);
+		/// Writes the trace into file. Returns false if the file could not be written.
+		static bool writeChromeTrace(const std::string & filePath);
+		/// Discards all the recorded scopes. Other threads must not record while the buffers are cleared.
+		static void clear();
+	};
+
+	/// Measures the time from its construction to its destruction, and records it into Profiler.
+	class ProfileScope {
+	private:
+		const char * name;
+		Profiler::Clock::time_point start;
+
+	public:
+		/// Starts the measurement. Name has to live until the trace is written (string literals are expected).
+		explicit ProfileScope(const char * name_);
+		~ProfileScope();
+
+		ProfileScope(const ProfileScope &) = delete;
+		ProfileScope & operator=(const ProfileScope &) = delete;
+	};
+}
+
+#endif // !PS_PROFILER_INCLUDED
@@ -1,9 +1,50 @@
 #include "RayCaster.hpp"
 #include "Math.hpp"
+#include "Profiler.hpp"
+#include <cmath>
+#include <limits>
+#include <chrono>
 
 namespace ps {
 
-	RayCaster::RayCaster() : correctFishbowl(true) {
+	//*********************************************************************************
+	// SPAN WINDOW
+	//*********************************************************************************
+
+	struct RayCaster::SpanFrame {
+		unsigned int spanFrom;		///< First column of the span.
+		unsigned int spanTo;		///< End of the span (one past its last column).
+		unsigned int runFrom;		///< First column, whose run was not finished yet.
+		unsigned int portalRunTo;	///< End of the portal run [runFrom, portalRunTo), whose span is on the stack above (runFrom if there is none).
+		std::size_t segmentId;		///< Segment all the rays of the span are in.
+		sf::Vector2f origin;		///< Point all the rays of the span start from.
+		sf::Vector2f direction;		///< Camera direction transformed by the portals the rays went through.
+		sf::Vector2f viewPlane;		///< Camera view plane transformed by the portals the rays went through.
+	};
+
+	struct RayCaster::SpanWindow {
+		unsigned int columnFrom;						///< Column of the first ray of the window.
+		std::vector<RenderRay> rays;					///< Ray of each column. Rays of a span step through the portal when the span is entered.
+		std::vector<WallHit> hits;						///< Nearest wall hit by each ray in its current segment.
+		std::vector<std::vector<RenderRay>> parentRays;	///< Rays of the portal span before they stepped through (for each recursion depth).
+		std::vector<std::vector<WallStrip>> parentStrips;	///< Portal strips of the parent span (for each recursion depth).
+		std::vector<SpanFrame> stack;					///< Spans, that are being rendered (the span behind a portal is above its parent).
+
+		SpanWindow() : columnFrom(0), rays(), hits(), parentRays(recursionLimit + 2), parentStrips(recursionLimit + 2), stack() {
+			stack.reserve(recursionLimit + 1);
+		}
+
+		RenderRay & ray(unsigned int column) { return rays[column - columnFrom]; }
+		WallHit & hit(unsigned int column) { return hits[column - columnFrom]; }
+	};
+
+
+
+	//*********************************************************************************
+	// RAY CASTER 
+	//*********************************************************************************
+
+	RayCaster::RayCaster() : correctFishbowl(true), spanTraversal(false), rayStepBudget(0), rayStepCount(0), fogColor(128, 128, 128) {
 	}
 
 	void RayCaster::setFishbowlCorrection(bool value)
@@ -11,32 +52,423 @@ namespace ps {
 		correctFishbowl = value;
 	}
 
+	void RayCaster::setThreadCount(unsigned int threadCount)
+	{
+		if (threadCount == getThreadCount())
+			return;
+
+		if (threadCount <= 1)
+			pool = nullptr;
+		else
+			pool = std::make_unique<ThreadPool>(threadCount);
+	}
+
+	unsigned int RayCaster::getThreadCount() const
+	{
+		return (pool) ? (unsigned int)pool->getThreadCount() : 1;
+	}
+
+	void RayCaster::setSpanTraversal(bool value)
+	{
+		spanTraversal = value;
+	}
+
+	bool RayCaster::getSpanTraversal() const
+	{
+		return spanTraversal;
+	}
+
+	void RayCaster::setRayStepBudget(std::size_t steps)
+	{
+		rayStepBudget = steps;
+	}
+
+	std::size_t RayCaster::getRayStepBudget() const
+	{
+		return rayStepBudget;
+	}
+
+	std::size_t RayCaster::getRayStepCount() const
+	{
+		return rayStepCount;
+	}
+
+	void RayCaster::setFogColor(sf::Color color)
+	{
+		fogColor = color;
+	}
+
+	const RenderStats & RayCaster::getStats() const
+	{
+		return stats;
+	}
+
+#ifdef PS_RENDER_STATS
+	// Milliseconds elapsed from given time point.
+	static double elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+#endif
+
 	void RayCaster::render(sf::RenderTarget & rt, const Scene & scene_)
+	{
+		render(rt, rt.getSize().x, rt.getSize().y, scene_);
+	}
+
+	void RayCaster::render(sf::RenderTarget & rt, unsigned int width, unsigned int height, const Scene & scene_)
+	{
+		PS_COUNT(auto phaseStart = std::chrono::steady_clock::now());
+		castFrame(width, height, scene_);
+		PS_COUNT(stats.castMs = elapsedMilliseconds(phaseStart));
+		PS_COUNT(phaseStart = std::chrono::steady_clock::now());
+
+		if (pool) {
+			// tiles are merged in the order of columns, so the batch is the same as if it was rendered by single thread
+			batch.clear();
+			batch.setViewPlane(scene->camera.viewPlaneHeight, renderHeight);
+			for (auto & tile : tiles)
+				batch.append(tile);
+		}
+
+		PS_COUNT(stats.mergeMs = elapsedMilliseconds(phaseStart));
+		PS_COUNT(phaseStart = std::chrono::steady_clock::now());
+
+		// whole frame is submitted at once
+		std::size_t drawCalls = batch.draw(rt);
+		PS_COUNT(stats.drawCalls = drawCalls);
+		static_cast<void>(drawCalls);	// draw calls are counted only with PS_RENDER_STATS
+		PS_COUNT(stats.drawMs = elapsedMilliseconds(phaseStart));
+	}
+
+	void RayCaster::render(FrameBuffer & fb, const Scene & scene_)
+	{
+		PS_COUNT(auto phaseStart = std::chrono::steady_clock::now());
+		castFrame(fb.getWidth(), fb.getHeight(), scene_);
+		PS_COUNT(stats.castMs = elapsedMilliseconds(phaseStart));
+		PS_COUNT(phaseStart = std::chrono::steady_clock::now());
+		PS_COUNT(stats.drawCalls = 0);
+
+		if (pool) {
+			// tiles cover distinct columns of the frame buffer, so they can be rasterized in parallel
+			for (auto & tile : tiles)
+				fb.prepareTextures(tile);
+
+			PS_COUNT(stats.mergeMs = elapsedMilliseconds(phaseStart));
+			PS_COUNT(phaseStart = std::chrono::steady_clock::now());
+
+			for (std::size_t i = 0; i < tiles.size(); ++i)
+				pool->submit(i, [this, &fb, i]() {
+					PS_PROFILE_SCOPE("rasterizeTile");
+					fb.rasterizeLines(tiles[i]);
+				});
+
+			pool->wait();
+		}
+		else {
+			PS_COUNT(stats.mergeMs = 0.0);
+			fb.rasterize(batch);
+		}
+
+		PS_COUNT(stats.drawMs = elapsedMilliseconds(phaseStart));
+	}
+
+	void RayCaster::castFrame(unsigned int width, unsigned int height, const Scene & scene_)
 	{
 		// store render dimensions
-		renderWidth = rt.getSize().x;
-		renderHeight = rt.getSize().y;
+		renderWidth = width;
+		renderHeight = height;
 
-		// store pointer to this render target
-		renderTarget = &rt;
 		// store pointer to the scene
 		scene = &scene_;
 
-		for (unsigned int i = 0; i < renderWidth; ++i) {
-			auto ray = generateRay(i);
+		std::size_t tileCount = (renderWidth + tileWidth - 1) / tileWidth;
+		rayStepCount = 0;
+		stats.counters = RenderCounters();
 
-			RenderStripArea area;
-			area.column = (float)i;				// currently rendered column of screen
-			area.top = 0.0f;					// this initial ray starts at top of the screen ...
-			area.bottom = (float)renderHeight;	// ... and ends on the bottom of the screen.
+		if (pool == nullptr) {
+			// lines from the previous frame are discarded
+			batch.clear();
+			batch.setViewPlane(scene->camera.viewPlaneHeight, renderHeight);
 
-			int initialRecursionDepth = 0;
+			// tiles are rendered one by one, so each of them has the same ray step budget as when rendering by multiple threads
+			for (std::size_t i = 0; i < tileCount; ++i) {
+				unsigned int columnFrom = (unsigned int)i * tileWidth;
+				unsigned int columnTo = getMin(columnFrom + tileWidth, renderWidth);
+				rayStepCount += (spanTraversal) ? castSpans(columnFrom, columnTo, batch, stats.counters) : castColumns(columnFrom, columnTo, batch, stats.counters);
+			}
+			return;
+		}
 
-			renderStip(area, ray, initialRecursionDepth);
+		tiles.resize(tileCount);
+		tileSteps.resize(tileCount);
+		tileCounters.resize(tileCount);
+
+		// each thread starts with a contiguous run of tiles, threads that finish early steal the tiles of the others
+		std::size_t threadCount = pool->getThreadCount();
+		for (std::size_t i = 0; i < tileCount; ++i) {
+			pool->submit(i * threadCount / tileCount, [this, i]() {
+				PS_PROFILE_SCOPE("castTile");
+				RenderBatch & tile = tiles[i];
+				tile.clear();
+				tile.setViewPlane(scene->camera.viewPlaneHeight, renderHeight);
+
+				unsigned int columnFrom = (unsigned int)i * tileWidth;
+				unsigned int columnTo = getMin(columnFrom + tileWidth, renderWidth);
+				RenderCounters & counters = tileCounters[i];
+				counters = RenderCounters();
+				tileSteps[i] = (spanTraversal) ? castSpans(columnFrom, columnTo, tile, counters) : castColumns(columnFrom, columnTo, tile, counters);
+			});
+		}
+
+		pool->wait();
+
+		for (std::size_t i = 0; i < tileCount; ++i) {
+			rayStepCount += tileSteps[i];
+			PS_COUNT(stats.counters.add(tileCounters[i]));
 		}
 	}
 
-	RenderRay RayCaster::generateRay(int i)
+	RayStepBudget RayCaster::makeTileBudget(unsigned int columnFrom, unsigned int columnTo) const
+	{
+		RayStepBudget budget;
+		budget.used = 0;
+		budget.limit = std::numeric_limits<std::size_t>::max();
+
+		std::size_t columns = columnTo - columnFrom;
+		if (rayStepBudget > 0)
+			budget.limit = getMax(rayStepBudget * columns / renderWidth, columns);
+
+		return budget;
+	}
+
+	std::size_t RayCaster::castColumns(unsigned int columnFrom, unsigned int columnTo, RenderBatch & output, RenderCounters & counters) const
+	{
+		WallRange cameraWalls = scene->getGeometry().getWalls().getWallRange(scene->camera.getSegmentId());
+		RayStepBudget budget = makeTileBudget(columnFrom, columnTo);
+		budget.used += columnTo - columnFrom;	// the first step of every column is done by the packets
+
+		std::vector<RenderRay> rays;
+		rays.reserve(RayPacket::size);
+		std::vector<PortalCrossing> crossings;
+		crossings.reserve(recursionLimit + 1);
+
+		// rays of neighbouring columns start in the camera segment, so their first walls are found for the whole packet at once
+		for (unsigned int first = columnFrom; first < columnTo; first += RayPacket::size) {
+			unsigned int count = getMin(columnTo - first, (unsigned int)RayPacket::size);
+
+			RayPacket packet;
+			rays.clear();
+			for (unsigned int k = 0; k < RayPacket::size; ++k) {
+				if (k < count)
+					rays.push_back(generateRay(first + k));
+
+				// unused lanes of the last packet repeat the last ray
+				packet.set(k, toVector2(rays.back().getPosition()), rays.back().getDirection());
+			}
+
+			PacketHits hits;
+			intersectWalls(packet, cameraWalls, hits);
+			PS_COUNT(counters.raysGenerated += count);
+			PS_COUNT(counters.wallTests += count * cameraWalls.size());
+			PS_COUNT(for (unsigned int k = 0; k < count; ++k) counters.backFacingWalls += countBackFacingWalls(cameraWalls, rays[k].getDirection()));
+
+			for (unsigned int k = 0; k < count; ++k)
+				renderColumn((float)(first + k), rays[k], hits[k], crossings, budget, output, counters);
+		}
+
+		return budget.used;
+	}
+
+	std::size_t RayCaster::castSpans(unsigned int columnFrom, unsigned int columnTo, RenderBatch & output, RenderCounters & counters) const
+	{
+		// window is reused by the frames rendered by this thread
+		static thread_local SpanWindow window;
+
+		window.columnFrom = columnFrom;
+		window.rays.clear();
+		window.hits.assign(columnTo - columnFrom, WallHit());
+		for (unsigned int column = columnFrom; column < columnTo; ++column)
+			window.rays.push_back(generateRay(column));
+
+		RayStepBudget budget = makeTileBudget(columnFrom, columnTo);
+		budget.used += columnTo - columnFrom;
+		PS_COUNT(counters.raysGenerated += columnTo - columnFrom);
+
+		const Camera & camera = scene->camera;
+		renderSpan(window, columnFrom, columnTo, camera.getDirection(), camera.viewPlaneDirection, budget, output, counters);
+		return budget.used;
+	}
+
+	void RayCaster::intersectSpan(SpanWindow & window, SpanFrame & frame, RenderCounters & counters) const
+	{
+		static_cast<void>(counters);	// counters are updated only with PS_RENDER_STATS
+
+		// all the rays of the span start in the same segment from the same point
+		frame.segmentId = window.ray(frame.spanFrom).getSegmentId();
+		frame.origin = toVector2(window.ray(frame.spanFrom).getPosition());
+
+		auto & walls = scene->getGeometry().getWalls();
+		std::uint32_t firstWall = walls.getSegmentWalls(frame.segmentId).first;
+		WallRange wallRange = walls.getWallRange(frame.segmentId);
+
+		// each wall is tested only by the rays of the columns it is projected to, nearer walls with lower index win as in intersectWalls()
+		for (unsigned int column = frame.spanFrom; column < frame.spanTo; ++column)
+			window.hit(column) = WallHit();
+
+		for (std::size_t i = 0; i < wallRange.size(); ++i) {
+			unsigned int wallFrom, wallTo;
+			std::uint32_t wall = firstWall + (std::uint32_t)i;
+			projectWall(frame.origin, walls.getFrom(wall), walls.getTo(wall), frame.direction, frame.viewPlane, frame.spanFrom, frame.spanTo, wallFrom, wallTo);
+
+			for (unsigned int column = wallFrom; column < wallTo; ++column)
+				intersectWall(wallRange, i, frame.origin, window.ray(column).getDirection(), window.hit(column));
+			PS_COUNT(counters.wallTests += wallTo - wallFrom);
+		}
+
+		// rays the projection missed (e.g. going exactly through the corner of walls) test all the walls
+		for (unsigned int column = frame.spanFrom; column < frame.spanTo; ++column) {
+			if (window.hit(column).wall < 0) {
+				window.hit(column) = intersectWalls(wallRange, frame.origin, window.ray(column).getDirection());
+				PS_COUNT(counters.wallTests += wallRange.size());
+			}
+			PS_COUNT(counters.backFacingWalls += countBackFacingWalls(wallRange, window.ray(column).getDirection()));
+		}
+	}
+
+	void RayCaster::renderSpan(SpanWindow & window, unsigned int spanFrom, unsigned int spanTo, sf::Vector2f direction, sf::Vector2f viewPlane,
+		RayStepBudget & budget, RenderBatch & output, RenderCounters & counters) const
+	{
+		auto & walls = scene->getGeometry().getWalls();
+
+		// spans are rendered depth first: span behind a portal is pushed on the stack and it is rendered before the rest of its parent span
+		// (depth of the span on the stack is the number of portals its rays went through)
+		auto & stack = window.stack;
+		stack.clear();
+		stack.push_back(SpanFrame{ spanFrom, spanTo, spanFrom, spanFrom, 0, sf::Vector2f(), direction, viewPlane });
+		intersectSpan(window, stack.back(), counters);
+
+		while (!stack.empty()) {
+			SpanFrame & frame = stack.back();
+			int depth = (int)stack.size() - 1;
+			auto & segment = scene->getSegment(frame.segmentId);
+			std::uint32_t firstWall = walls.getSegmentWalls(frame.segmentId).first;
+
+			// span behind the portal run was rendered, floor and ceiling in front of the portal are drawn after it (as renderColumn() does)
+			if (frame.portalRunTo > frame.runFrom) {
+				for (unsigned int column = frame.runFrom; column < frame.portalRunTo; ++column)
+					drawFloorCeiling((float)column, window.parentRays[depth][column - frame.runFrom], segment, window.parentStrips[depth][column - frame.runFrom],
+						output, counters);
+				frame.runFrom = frame.portalRunTo;
+			}
+
+			// neighbouring columns that hit the same wall form a run, portal runs are entered at once
+			bool enteredPortal = false;
+			while (frame.runFrom < frame.spanTo) {
+				unsigned int runFrom = frame.runFrom;
+				int wallIndex = window.hit(runFrom).wall;
+				unsigned int runTo = runFrom + 1;
+				while (runTo < frame.spanTo && window.hit(runTo).wall == wallIndex)
+					++runTo;
+
+				if (wallIndex < 0) {
+					PS_COUNT(for (unsigned int column = runFrom; column < runTo; ++column) counters.addColumn(depth));
+					frame.runFrom = runTo;
+					continue;
+				}
+
+				std::uint32_t wall = firstWall + (std::uint32_t)wallIndex;
+				if (walls.isPortal(wall)) {
+					// rays of the parent are kept, their floor and ceiling are drawn after the segment behind the portal
+					auto & parentRays = window.parentRays[depth];
+					auto & parentStrips = window.parentStrips[depth];
+					parentRays.clear();
+					parentStrips.clear();
+
+					for (unsigned int column = runFrom; column < runTo; ++column) {
+						RenderRay & ray = window.ray(column);
+						WallStrip strip = projectHit(ray, segment, window.hit(column));
+						parentRays.push_back(ray);
+						parentStrips.push_back(strip);
+
+						walls.getPortal(wall).stepThrough(ray);
+						ray.renderFromDistance = getMax(strip.distance, ray.renderFromDistance);
+					}
+
+					// each column of the run does one ray step in the segment behind the portal, runs the budget does not reach are covered by
+					// fog (portals beyond the recursion limit are left empty)
+					if (depth < recursionLimit && budget.allows(runTo - runFrom)) {
+						budget.used += runTo - runFrom;
+						PS_COUNT(counters.portalTraversals += runTo - runFrom);
+						auto & transform = walls.getPortal(wall).getTransform();
+						SpanFrame child{ runFrom, runTo, runFrom, runFrom, 0, sf::Vector2f(), transform.transformDirection(frame.direction),
+							transform.transformDirection(frame.viewPlane) };
+
+						// the run is finished when the span behind it is popped (frame is not valid after the push)
+						frame.portalRunTo = runTo;
+						stack.push_back(child);
+						intersectSpan(window, stack.back(), counters);
+						enteredPortal = true;
+						break;
+					}
+
+					if (depth < recursionLimit) {
+						for (unsigned int column = runFrom; column < runTo; ++column)
+							drawFog((float)column, parentStrips[column - runFrom], output);
+					}
+
+					for (unsigned int column = runFrom; column < runTo; ++column) {
+						drawFloorCeiling((float)column, parentRays[column - runFrom], segment, parentStrips[column - runFrom], output, counters);
+						PS_COUNT(counters.addColumn(depth));
+					}
+				}
+				else {
+					for (unsigned int column = runFrom; column < runTo; ++column) {
+						const WallHit & hit = window.hit(column);
+						WallStrip strip = projectHit(window.ray(column), segment, hit);
+						drawWall((float)column, wall, hit, strip, output);
+						drawFloorCeiling((float)column, window.ray(column), segment, strip, output, counters);
+						PS_COUNT(counters.addColumn(depth));
+					}
+				}
+
+				frame.runFrom = runTo;
+			}
+
+			if (!enteredPortal)
+				stack.pop_back();
+		}
+	}
+
+	void RayCaster::projectWall(sf::Vector2f origin, sf::Vector2f from, sf::Vector2f to, sf::Vector2f direction, sf::Vector2f viewPlane,
+		unsigned int spanFrom, unsigned int spanTo, unsigned int & wallFrom, unsigned int & wallTo) const
+	{
+		sf::Vector2f a = from - origin;
+		sf::Vector2f b = to - origin;
+
+		// point is seen by the ray (direction + k * viewPlane), where k goes from -1 to 1 over the columns of the screen
+		float kA = -cross(direction, a) / cross(viewPlane, a);
+		float kB = -cross(direction, b) / cross(viewPlane, b);
+		float columnA = mapIntervals(-1.0f, 1.0f, 0.0f, (float)renderWidth - 1.0f, kA);
+		float columnB = mapIntervals(-1.0f, 1.0f, 0.0f, (float)renderWidth - 1.0f, kB);
+
+		// wall reaching behind the view plane can be seen in any column
+		float minDepth = 0.001f * norm(direction);
+		if (dot(a, direction) <= minDepth * norm(a) || dot(b, direction) <= minDepth * norm(b) || !std::isfinite(columnA) || !std::isfinite(columnB)) {
+			wallFrom = spanFrom;
+			wallTo = spanTo;
+			return;
+		}
+
+		// range is widened by a column on both sides to cover rounding errors
+		float first = std::floor(getMin(columnA, columnB)) - 1.0f;
+		float last = std::ceil(getMax(columnA, columnB)) + 1.0f;
+		wallFrom = (first <= (float)spanFrom) ? spanFrom : (first >= (float)spanTo) ? spanTo : (unsigned int)first;
+		wallTo = (last < (float)spanFrom) ? spanFrom : (last >= (float)spanTo) ? spanTo : (unsigned int)last + 1;
+		if (wallTo < wallFrom)
+			wallTo = wallFrom;
+	}
+
+	RenderRay RayCaster::generateRay(int i) const
 	{
 		float k = mapIntervals(0.0f, (float)renderWidth - 1.0f, -1.0f, 1.0f, (float)i);
 		const Camera & camera = scene->camera;
@@ -56,117 +488,153 @@ namespace ps {
 		// return objectDistance * tan(viewAngle);		// This version needs less mul/div, and for angles close to 0 approximates result well.
 	}
 
-	void RayCaster::renderStip(const RenderStripArea & renderStrip, const RenderRay & ray, int recursionDepth)
+	void RayCaster::renderColumn(float column, RenderRay ray, WallHit hit, std::vector<PortalCrossing> & crossings, RayStepBudget & budget, RenderBatch & output,
+		RenderCounters & counters) const
 	{
-		// to prevent from cycling when portals create a loop
-		if (recursionDepth > recursionLimit)
-			return;
+		crossings.clear();
+		const LevelWalls & walls = scene->getGeometry().getWalls();
+		const Segment * segment = &scene->getSegment(ray.getSegmentId());
+		PS_COUNT(std::size_t depth = 0);
+
+		// portals are followed until the ray hits a solid wall
+		while (hit.wall >= 0) {
+			std::uint32_t wall = walls.getSegmentWalls(ray.getSegmentId()).first + (std::uint32_t)hit.wall;
+			WallStrip strip = projectHit(ray, *segment, hit);
+			crossings.push_back(PortalCrossing{ ray, segment, strip });
+
+			if (!walls.isPortal(wall)) {
+				drawWall(column, wall, hit, strip, output);
+				break;
+			}
 
-		// tries to find the edge in ray segment that ray intersects
-		auto & segment = scene->getSegment(ray.getSegmentId());
-		for (auto & wall : segment.getWalls()) {
+			// to prevent from cycling when portals create a loop
+			if ((int)crossings.size() > recursionLimit)
+				break;
 
-			if (wall.facesRay(ray) == false) {
-				// edge is definitely not seen from this ray => skip it
-				continue;
+			// portals the budget does not reach are covered by fog
+			if (!budget.allows(1)) {
+				drawFog(column, strip, output);
+				break;
 			}
 
-			WallIntersection intersection;
-			if (wall.intersect(ray, intersection)) {
-				//                                    ------x
-				//                     |                    |
-				//                     x vpWallTop          |
-				// ray                 |                    | wall that was hit
-				//	x---->	- -	- - - -|                    |
-				//                     x vpWallBottom       |
-				//                     |              ------x
-				//                     |
-				//                    view plane
-				// |<-  1/correction ->|
-				//
-
-				float distance = intersection.rayIntersectionDistance;
-				float correctedDistance = distance * ray.correctionFactor;
-
-				float wallTopHeight = segment.segmentFloorHeight + segment.segmentWallHeight;
-				float wallBottomHeight = segment.segmentFloorHeight;
-
-				float vpWallTop = distanceToViewPlane(correctedDistance, wallTopHeight);
-				float vpWallBottom = distanceToViewPlane(correctedDistance, wallBottomHeight);
-
-				float scrWallTop = viewPlaneToScreen(vpWallTop);
-				float scrWallBottom = viewPlaneToScreen(vpWallBottom);
-				float scrWallHeight = scrWallBottom - scrWallTop;
-
-				RenderStripArea wallStrip;
-				wallStrip.column = renderStrip.column;
-				wallStrip.top = scrWallTop;
-				wallStrip.bottom = scrWallBottom;
-
-				if (wall.isPortal()) {
-					RenderRay rayCopy = ray;												// get a copy of the viewing ray
-					wall.stepThrough(rayCopy);												// copy of ray steps through portal
-					rayCopy.renderFromDistance = getMax(distance, ray.renderFromDistance);	// this new ray render from the hit wall onwards
-					renderStip(wallStrip, rayCopy, recursionDepth + 1);						// edge (segment behind it) is drawn
-				}
-				else {
-					WallDrawParameters drawParams;
-					drawParams.scrWallTop = sf::Vector2f(renderStrip.column, scrWallTop );
-					drawParams.scrWallBottom = sf::Vector2f(renderStrip.column, scrWallBottom);
+			walls.getPortal(wall).stepThrough(ray);										// ray steps through portal
+			ray.renderFromDistance = getMax(strip.distance, ray.renderFromDistance);	// and renders from the hit wall onwards
+			segment = &scene->getSegment(ray.getSegmentId());
+
+			// finds the edge in ray segment that ray intersects (all the edges are tested at once)
+			WallRange segmentWalls = walls.getWallRange(ray.getSegmentId());
+			hit = intersectWalls(segmentWalls, toVector2(ray.getPosition()), ray.getDirection());
+			budget.used++;
+			PS_COUNT(counters.portalTraversals++);
+			PS_COUNT(depth++);
+			PS_COUNT(counters.wallTests += segmentWalls.size());
+			PS_COUNT(counters.backFacingWalls += countBackFacingWalls(segmentWalls, ray.getDirection()));
+		}
 
-					float uvX = intersection.distanceToWallEdge * wall.getWidth();
-					drawParams.uvWallTop = sf::Vector2f(uvX, 1 - wallTopHeight);
-					drawParams.uvWallBottom = sf::Vector2f(uvX, 1 - wallBottomHeight);
+		// floor and ceiling in front of each portal are drawn after the segment behind it
+		for (auto it = crossings.rbegin(); it != crossings.rend(); ++it)
+			drawFloorCeiling(column, it->ray, *it->segment, it->strip, output, counters);
 
-					wall.draw(*renderTarget, drawParams);
-				}
+		PS_COUNT(counters.addColumn(depth));
+	}
 
-				// too close wall => do not render floor and ceiling
-				// distance close to zero introduce numerical unstability when dividing by distance, this leads to problems
-				// however when ray is so close to the wall, he probably can't even see the floor or ceiling
-				if (distance < ray.renderFromDistance)
-					continue;
+	WallStrip RayCaster::projectHit(const RenderRay & ray, const Segment & segment, const WallHit & hit) const
+	{
+		//                                    ------x
+		//                     |                    |
+		//                     x vpWallTop          |
+		// ray                 |                    | wall that was hit
+		//	x---->	- -	- - - -|                    |
+		//                     x vpWallBottom       |
+		//                     |              ------x
+		//                     |
+		//                    view plane
+		// |<-  1/correction ->|
+		//
+
+		WallStrip strip;
+		strip.distance = hit.rayParameter;
+		float correctedDistance = strip.distance * ray.correctionFactor;
+
+		strip.wallTopHeight = segment.segmentFloorHeight + segment.segmentWallHeight;
+		strip.wallBottomHeight = segment.segmentFloorHeight;
+
+		strip.vpWallTop = distanceToViewPlane(correctedDistance, strip.wallTopHeight);
+		strip.vpWallBottom = distanceToViewPlane(correctedDistance, strip.wallBottomHeight);
+
+		strip.scrWallTop = viewPlaneToScreen(strip.vpWallTop);
+		strip.scrWallBottom = viewPlaneToScreen(strip.vpWallBottom);
+		return strip;
+	}
 
-				float ceilDH = wallTopHeight - ray.getPosition().z;
-				float vpCeilingTop = ceilDH / (ray.renderFromDistance * ray.correctionFactor);
-				float scrCeilingTop = viewPlaneToScreen(vpCeilingTop);
+	void RayCaster::drawWall(float column, std::uint32_t wall, const WallHit & hit, const WallStrip & strip, RenderBatch & output) const
+	{
+		const LevelWalls & walls = scene->getGeometry().getWalls();
 
-				FloorCeilingDrawParameters drawParams;
-				drawParams.viewPlaneDistance = 1.0f / ray.correctionFactor;
-				drawParams.uvCamera = toVector2(ray.getPosition());
-				drawParams.uvDirection = ray.getDirection();
+		WallDrawParameters drawParams;
+		drawParams.scrWallTop = sf::Vector2f(column, strip.scrWallTop);
+		drawParams.scrWallBottom = sf::Vector2f(column, strip.scrWallBottom);
 
-				drawParams.deltaH = ceilDH;
-				drawParams.scrTop = sf::Vector2f(renderStrip.column, scrCeilingTop);
-				drawParams.scrBottom = sf::Vector2f( renderStrip.column, scrWallTop);
-				drawParams.vpTop = vpCeilingTop;
-				drawParams.vpBottom = vpWallTop;
+		float uvX = hit.wallParameter * walls.getLength(wall);
+		drawParams.uvWallTop = sf::Vector2f(uvX, 1 - strip.wallTopHeight);
+		drawParams.uvWallBottom = sf::Vector2f(uvX, 1 - strip.wallBottomHeight);
 
-				segment.ceiling.draw(*renderTarget, drawParams);
+		walls.getMaterial(wall).draw(output, drawParams);
+	}
 
-				float floorDH = wallBottomHeight - ray.getPosition().z;
-				float vpFloorBottom = floorDH / (ray.renderFromDistance * ray.correctionFactor);
-				float scrFloorBottom = viewPlaneToScreen(vpFloorBottom);
+	void RayCaster::drawFloorCeiling(float column, const RenderRay & ray, const Segment & segment, const WallStrip & strip, RenderBatch & output,
+		RenderCounters & counters) const
+	{
+		static_cast<void>(counters);	// counters are updated only with PS_RENDER_STATS
 
-				drawParams.scrTop = sf::Vector2f(renderStrip.column, scrWallBottom);
-				drawParams.scrBottom = sf::Vector2f(renderStrip.column, scrFloorBottom);
-				drawParams.deltaH = floorDH;
-				drawParams.vpTop = vpWallBottom;
-				drawParams.vpBottom = vpFloorBottom;
+		// too close wall => do not render floor and ceiling
+		// distance close to zero introduce numerical unstability when dividing by distance, this leads to problems
+		// however when ray is so close to the wall, he probably can't even see the floor or ceiling
+		if (strip.distance < ray.renderFromDistance)
+			return;
 
-				segment.floor.draw(*renderTarget, drawParams);
+		float ceilDH = strip.wallTopHeight - ray.getPosition().z;
+		float vpCeilingTop = ceilDH / (ray.renderFromDistance * ray.correctionFactor);
+		float scrCeilingTop = viewPlaneToScreen(vpCeilingTop);
 
-				return;
-			}
-		}
+		FloorCeilingDrawParameters drawParams;
+		drawParams.viewPlaneDistance = 1.0f / ray.correctionFactor;
+		drawParams.uvCamera = toVector2(ray.getPosition());
+		drawParams.uvDirection = ray.getDirection();
+
+		drawParams.deltaH = ceilDH;
+		drawParams.scrTop = sf::Vector2f(column, scrCeilingTop);
+		drawParams.scrBottom = sf::Vector2f(column, strip.scrWallTop);
+		drawParams.vpTop = vpCeilingTop;
+		drawParams.vpBottom = strip.vpWallTop;
+
+		segment.ceiling.draw(output, drawParams);
+
+		float floorDH = strip.wallBottomHeight - ray.getPosition().z;
+		float vpFloorBottom = floorDH / (ray.renderFromDistance * ray.correctionFactor);
+		float scrFloorBottom = viewPlaneToScreen(vpFloorBottom);
+
+		drawParams.scrTop = sf::Vector2f(column, strip.scrWallBottom);
+		drawParams.scrBottom = sf::Vector2f(column, scrFloorBottom);
+		drawParams.deltaH = floorDH;
+		drawParams.vpTop = strip.vpWallBottom;
+		drawParams.vpBottom = vpFloorBottom;
+
+		segment.floor.draw(output, drawParams);
+		PS_COUNT(counters.floorCeilingStrips += 2);
+	}
+
+	void RayCaster::drawFog(float column, const WallStrip & strip, RenderBatch & output) const
+	{
+		output.addLine(sf::Vertex(sf::Vector2f(column, strip.scrWallTop), fogColor), sf::Vertex(sf::Vector2f(column, strip.scrWallBottom), fogColor));
 	}
 
-	float RayCaster::distanceToViewPlane(float distance, float height)
+	float RayCaster::distanceToViewPlane(float distance, float height) const
 	{
 		return (height - scene->camera.position.z) / distance;
 	}
 
-	float RayCaster::viewPlaneToScreen(float x)
+	float RayCaster::viewPlaneToScreen(float x) const
 	{
 		return mapIntervals(scene->camera.viewPlaneHeight, -1.0f * scene->camera.viewPlaneHeight, 0.0f, (float)renderHeight, x);
 	}
@@ -0,0 +1,115 @@
+#include "RenderBatch.hpp"
+#include "FloorCeiling.hpp"
+
+namespace ps {
+
+	RenderBatch::RenderBatch() : untextured(sf::Lines), textured(), floorCeilings(), viewPlaneTop(1.0f), viewPlaneStep(0.0f) {
+	}
+
+	void RenderBatch::clear()
+	{
+		// vertex arrays are only emptied (not erased), so they keep their capacity for the next frame
+		untextured.clear();
+
+		for (auto & pair : textured)
+			pair.second.clear();
+
+		for (auto & pair : floorCeilings)
+			pair.second.clear();
+	}
+
+	void RenderBatch::setViewPlane(float viewPlaneHeight, unsigned int renderHeight)
+	{
+		viewPlaneTop = viewPlaneHeight;
+		viewPlaneStep = -2.0f * viewPlaneHeight / (float)renderHeight;
+	}
+
+	void RenderBatch::addLine(const sf::Vertex & top, const sf::Vertex & bottom)
+	{
+		untextured.append(top);
+		untextured.append(bottom);
+	}
+
+	void RenderBatch::addLine(const sf::Vertex & top, const sf::Vertex & bottom, const sf::Texture * texture)
+	{
+		sf::VertexArray & arr = textured[texture];
+		arr.setPrimitiveType(sf::Lines);
+		arr.append(top);
+		arr.append(bottom);
+	}
+
+	void RenderBatch::addFloorCeilingLine(const sf::Vertex & top, const sf::Vertex & bottom, const sf::Texture * texture)
+	{
+		sf::VertexArray & arr = floorCeilings[texture];
+		arr.setPrimitiveType(sf::Lines);
+		arr.append(top);
+		arr.append(bottom);
+	}
+
+	// Appends vertices of one vertex array to the end of another.
+	void appendVertices(sf::VertexArray & target, const sf::VertexArray & source) {
+		for (std::size_t i = 0; i < source.getVertexCount(); ++i)
+			target.append(source[i]);
+	}
+
+	void RenderBatch::append(const RenderBatch & other)
+	{
+		appendVertices(untextured, other.untextured);
+
+		for (auto & pair : other.textured) {
+			if (pair.second.getVertexCount() == 0)
+				continue;
+
+			sf::VertexArray & arr = textured[pair.first];
+			arr.setPrimitiveType(sf::Lines);
+			appendVertices(arr, pair.second);
+		}
+
+		for (auto & pair : other.floorCeilings) {
+			if (pair.second.getVertexCount() == 0)
+				continue;
+
+			sf::VertexArray & arr = floorCeilings[pair.first];
+			arr.setPrimitiveType(sf::Lines);
+			appendVertices(arr, pair.second);
+		}
+	}
+
+	std::size_t RenderBatch::draw(sf::RenderTarget & rt) const
+	{
+		std::size_t drawCalls = 0;
+
+		if (untextured.getVertexCount() != 0) {
+			rt.draw(untextured);
+			drawCalls++;
+		}
+
+		for (auto & pair : textured) {
+			if (pair.second.getVertexCount() != 0) {
+				rt.draw(pair.second, pair.first);
+				drawCalls++;
+			}
+		}
+
+		// Fragment shader gets gl_FragCoord, which has its origin in the bottom-left corner of render target.
+		float rtHeight = (float)rt.getSize().y;
+		sf::RenderStates states;
+		states.shader = FloorCeiling::prepareShader(viewPlaneTop + viewPlaneStep * rtHeight, -1.0f * viewPlaneStep);
+
+		for (auto & pair : floorCeilings) {
+			if (pair.second.getVertexCount() != 0) {
+				states.texture = pair.first;
+				rt.draw(pair.second, states);
+				drawCalls++;
+			}
+		}
+
+		return drawCalls;
+	}
+
+	float RenderBatch::screenToViewPlane(float y) const
+	{
+		return viewPlaneTop + viewPlaneStep * y;
+	}
+
+}
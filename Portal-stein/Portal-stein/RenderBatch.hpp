@@ -0,0 +1,55 @@
+#pragma once
+#ifndef PS_RENDER_BATCH_INCLUDED
+#define PS_RENDER_BATCH_INCLUDED
+#include <map>
+#include <SFML\Graphics.hpp>
+
+namespace ps {
+
+	//**************************************************************************
+	// RENDER BATCH
+	//**************************************************************************
+
+	/// Collects vertices of all the strips that were rendered in one frame. The strips are sorted into vertex arrays by their material
+	/// (plain color, texture, or floor/ceiling texture), so the whole frame can be submitted to render target by a few draw calls.
+	/// Vertex arrays keep their memory between frames.
+	class RenderBatch {
+	private:
+		sf::VertexArray untextured;										///< Strips that have only color.
+		std::map<const sf::Texture *, sf::VertexArray> textured;		///< Textured wall strips, one vertex array per texture.
+		std::map<const sf::Texture *, sf::VertexArray> floorCeilings;	///< Textured floor/ceiling strips, drawn with floor/ceiling shader.
+
+		float viewPlaneTop;		///< View plane coordinate of the top of the screen.
+		float viewPlaneStep;	///< Change of view plane coordinate per one pixel of the screen (downwards).
+
+	public:
+		RenderBatch();
+
+		/// Removes all the vertices from the batch. Allocated memory is kept for the next frame.
+		void clear();
+		/// Sets mapping of screen rows to view plane coordinates. Floor/ceiling strips need it to reconstruct depth of each pixel.
+		/// \param viewPlaneHeight Half of the view plane height (view plane coordinate of the top row).
+		/// \param renderHeight Height of the rendered image (in pixels).
+		void setViewPlane(float viewPlaneHeight, unsigned int renderHeight);
+
+		/// Adds line with no texture.
+		void addLine(const sf::Vertex & top, const sf::Vertex & bottom);
+		/// Adds textured line. Texture coordinates of vertices are in pixels.
+		void addLine(const sf::Vertex & top, const sf::Vertex & bottom, const sf::Texture * texture);
+		/// Appends all lines of other batch to this batch. Lines keep their order.
+		void append(const RenderBatch & other);
+		/// Adds floor/ceiling line. Texture coordinates of vertices are (texture point * view plane coordinate) in pixels.
+		void addFloorCeilingLine(const sf::Vertex & top, const sf::Vertex & bottom, const sf::Texture * texture);
+
+		/// Draws all collected lines on render target. Returns number of issued draw calls.
+		std::size_t draw(sf::RenderTarget & rt) const;
+
+		/// Returns the view plane coordinate of given vertical screen coordinate.
+		float screenToViewPlane(float y) const;
+
+		/// FrameBuffer rasterizes the collected lines directly.
+		friend class FrameBuffer;
+	};
+}
+
+#endif // !PS_RENDER_BATCH_INCLUDED
@@ -0,0 +1,53 @@
+#include "RenderStats.hpp"
+#include "Math.hpp"
+
+namespace ps {
+
+	//*********************************************************************************
+	// RENDER STATISTICS
+	//*********************************************************************************
+
+	RenderCounters::RenderCounters() : raysGenerated(0), wallTests(0), backFacingWalls(0), portalTraversals(0), columns(0), depthSum(0), maxDepth(0),
+		floorCeilingStrips(0) {
+	}
+
+	void RenderCounters::addColumn(std::size_t depth)
+	{
+		columns++;
+		depthSum += depth;
+		maxDepth = getMax(maxDepth, depth);
+	}
+
+	void RenderCounters::add(const RenderCounters & other)
+	{
+		raysGenerated += other.raysGenerated;
+		wallTests += other.wallTests;
+		backFacingWalls += other.backFacingWalls;
+		portalTraversals += other.portalTraversals;
+		columns += other.columns;
+		depthSum += other.depthSum;
+		maxDepth = getMax(maxDepth, other.maxDepth);
+		floorCeilingStrips += other.floorCeilingStrips;
+	}
+
+	double RenderCounters::getMeanDepth() const
+	{
+		return (columns > 0) ? (double)depthSum / columns : 0.0;
+	}
+
+	RenderStats::RenderStats() : counters(), drawCalls(0), castMs(0.0), mergeMs(0.0), drawMs(0.0) {
+	}
+
+	void writeStatsCsvHeader(std::ostream & output)
+	{
+		output << "frame,raysGenerated,wallTests,backFacingWalls,portalTraversals,maxDepth,meanDepth,drawCalls,floorCeilingStrips,castMs,mergeMs,drawMs\n";
+	}
+
+	void writeStatsCsvRow(std::ostream & output, std::size_t frame, const RenderStats & stats)
+	{
+		const RenderCounters & c = stats.counters;
+		output << frame << "," << c.raysGenerated << "," << c.wallTests << "," << c.backFacingWalls << "," << c.portalTraversals << "," <<
+			c.maxDepth << "," << c.getMeanDepth() << "," << stats.drawCalls << "," << c.floorCeilingStrips << "," <<
+			stats.castMs << "," << stats.mergeMs << "," << stats.drawMs << "\n";
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef PS_RENDER_STATS_INCLUDED
+#define PS_RENDER_STATS_INCLUDED
+#include <cstddef>
+#include <ostream>
+
+/// Counters are updated by the statements wrapped in PS_COUNT. Builds without PS_RENDER_STATS defined compile them out, so the
+/// statistics cost nothing there (they stay zero).
+#ifdef PS_RENDER_STATS
+#define PS_COUNT(statement) statement
+#else
+#define PS_COUNT(statement)
+#endif
+
+namespace ps {
+
+	//*********************************************************************************
+	// RENDER STATISTICS
+	//*********************************************************************************
+
+	/// Counters of the work done while casting one frame (or one tile of it). Each tile has its own counters, that are written only by
+	/// the thread rendering the tile, and they are summed when the frame is finished.
+	struct RenderCounters {
+		std::size_t raysGenerated;		///< Rays cast from the camera (one per column).
+		std::size_t wallTests;			///< Intersection tests of a ray and a wall.
+		std::size_t backFacingWalls;	///< Wall tests rejected, because the wall does not face the ray (Wall::facesRay is false).
+		std::size_t portalTraversals;	///< Steps of rays through portals.
+		std::size_t columns;			///< Columns, whose rays finished.
+		std::size_t depthSum;			///< Sum of the recursion depths (portals passed) the rays of the columns finished in.
+		std::size_t maxDepth;			///< Maximum recursion depth.
+		std::size_t floorCeilingStrips;	///< Floor and ceiling lines drawn.
+
+		/// Creates zero counters.
+		RenderCounters();
+
+		/// Counts the column, whose ray finished in given recursion depth.
+		void addColumn(std::size_t depth);
+		/// Adds the counters of other tile.
+		void add(const RenderCounters & other);
+		/// Gets the mean recursion depth of the columns.
+		double getMeanDepth() const;
+	};
+
+	/// Statistics of one rendered frame.
+	struct RenderStats {
+		RenderCounters counters;
+		std::size_t drawCalls;		///< Draw calls issued (zero when rasterizing into FrameBuffer).
+		double castMs;				///< Time spent by casting rays and collecting the lines.
+		double mergeMs;				///< Time spent by merging the tiles (or preparing textures for the software rasterizer).
+		double drawMs;				///< Time spent by submitting the lines to the render target (or by rasterizing them).
+
+		/// Creates zero statistics.
+		RenderStats();
+	};
+
+	/// Writes the header line of CSV file with the statistics of the frames.
+	void writeStatsCsvHeader(std::ostream & output);
+	/// Writes statistics of one frame as a line of CSV file.
+	void writeStatsCsvRow(std::ostream & output, std::size_t frame, const RenderStats & stats);
+}
+
+#endif // !PS_RENDER_STATS_INCLUDED
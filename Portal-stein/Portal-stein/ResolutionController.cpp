@@ -0,0 +1,97 @@
+#include "ResolutionController.hpp"
+#include <cmath>
+#include "Math.hpp"
+
+namespace ps {
+
+	//**************************************************************************
+	// RESOLUTION CONTROLLER
+	//**************************************************************************
+
+	constexpr double ResolutionController::smoothing;
+	constexpr double ResolutionController::tolerance;
+	constexpr float ResolutionController::maxDecrease;
+	constexpr float ResolutionController::maxIncrease;
+
+	ResolutionController::ResolutionController(double targetMs_) : targetMs(targetMs_), smoothedMs(-1.0), horizontalScale(1.0f), verticalScale(1.0f),
+		minHorizontalScale(0.25f), maxHorizontalScale(1.0f), minVerticalScale(0.5f), maxVerticalScale(1.0f) {
+	}
+
+	void ResolutionController::setTarget(double targetMs_)
+	{
+		targetMs = targetMs_;
+	}
+
+	double ResolutionController::getTarget() const
+	{
+		return targetMs;
+	}
+
+	void ResolutionController::setHorizontalRange(float minScale, float maxScale)
+	{
+		minHorizontalScale = minScale;
+		maxHorizontalScale = maxScale;
+		horizontalScale = getMin(getMax(horizontalScale, minScale), maxScale);
+	}
+
+	void ResolutionController::setVerticalRange(float minScale, float maxScale)
+	{
+		minVerticalScale = minScale;
+		maxVerticalScale = maxScale;
+		verticalScale = getMin(getMax(verticalScale, minScale), maxScale);
+	}
+
+	float ResolutionController::getHorizontalScale() const
+	{
+		return horizontalScale;
+	}
+
+	float ResolutionController::getVerticalScale() const
+	{
+		return verticalScale;
+	}
+
+	void ResolutionController::reset()
+	{
+		smoothedMs = -1.0;
+		horizontalScale = maxHorizontalScale;
+		verticalScale = maxVerticalScale;
+	}
+
+	float ResolutionController::applyFactor(float & scale, float factor, float minScale, float maxScale)
+	{
+		float oldScale = scale;
+		scale = getMin(getMax(scale * factor, minScale), maxScale);
+		return factor * oldScale / scale;
+	}
+
+	void ResolutionController::update(double frameMs)
+	{
+		smoothedMs = (smoothedMs < 0.0) ? frameMs : smoothedMs + smoothing * (frameMs - smoothedMs);
+		if (smoothedMs <= 0.0)
+			return;
+
+		float oldScale = horizontalScale * verticalScale;
+		if (smoothedMs > (1.0 + tolerance) * targetMs) {
+			// render time is roughly proportional to the number of pixels, so the scale is changed by the ratio of the times
+			float factor = (float)getMax(targetMs / smoothedMs, 1.0 - maxDecrease);
+			factor = applyFactor(horizontalScale, factor, minHorizontalScale, maxHorizontalScale);
+			applyFactor(verticalScale, factor, minVerticalScale, maxVerticalScale);
+		}
+		else if (smoothedMs < (1.0 - tolerance) * targetMs) {
+			float factor = (float)getMin(targetMs / smoothedMs, 1.0 + maxIncrease);
+			factor = applyFactor(verticalScale, factor, minVerticalScale, maxVerticalScale);
+			applyFactor(horizontalScale, factor, minHorizontalScale, maxHorizontalScale);
+		}
+
+		// average is moved by the expected change of the render time, otherwise the old times would keep changing the scale
+		smoothedMs *= horizontalScale * verticalScale / oldScale;
+	}
+
+	sf::Vector2u ResolutionController::getRenderSize(sf::Vector2u windowSize) const
+	{
+		unsigned int width = (unsigned int)std::lround(windowSize.x * horizontalScale);
+		unsigned int height = (unsigned int)std::lround(windowSize.y * verticalScale);
+		return sf::Vector2u{ getMax(width, 1u), getMax(height, 1u) };
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#ifndef PS_RESOLUTION_CONTROLLER_INCLUDED
+#define PS_RESOLUTION_CONTROLLER_INCLUDED
+#include <SFML\Graphics.hpp>
+
+namespace ps {
+
+	//**************************************************************************
+	// RESOLUTION CONTROLLER
+	//**************************************************************************
+
+	/// Chooses the resolution the frames are rendered in, so that the render time stays at the target. Horizontal and vertical scale of
+	/// the window resolution are controlled separately: rays are cast per column, so the horizontal scale affects the render time most.
+	/// It is lowered first when the frames are too slow, and it is raised last when they are fast again.
+	class ResolutionController {
+	private:
+		double targetMs;			///< Render time the controller aims for.
+		double smoothedMs;			///< Exponential moving average of the measured render times (negative before the first measurement).
+		float horizontalScale;
+		float verticalScale;
+		float minHorizontalScale;
+		float maxHorizontalScale;
+		float minVerticalScale;
+		float maxVerticalScale;
+
+		/// Multiplies the scale by factor, the scale is clamped to [minScale, maxScale]. Returns the part of the factor, that could not
+		/// be applied because of the clamping.
+		static float applyFactor(float & scale, float factor, float minScale, float maxScale);
+
+	public:
+		/// Weight of the newest render time in the moving average.
+		static constexpr double smoothing = 0.1;
+		/// Render times within this fraction around the target do not change the resolution (so the resolution does not oscillate).
+		static constexpr double tolerance = 0.1;
+		/// Maximum relative change of the scale per frame, when the frames are too slow.
+		static constexpr float maxDecrease = 0.1f;
+		/// Maximum relative change of the scale per frame, when the frames are fast (raising is slower, so it does not overshoot).
+		static constexpr float maxIncrease = 0.02f;
+
+		/// Creates controller, that aims for given render time (in milliseconds). Frames start in full resolution.
+		explicit ResolutionController(double targetMs_);
+
+		/// Sets the render time the controller aims for (in milliseconds).
+		void setTarget(double targetMs_);
+		/// Gets the render time the controller aims for (in milliseconds).
+		double getTarget() const;
+		/// Sets the range of the horizontal scale (0 < minScale <= maxScale). Equal bounds fix the scale.
+		void setHorizontalRange(float minScale, float maxScale);
+		/// Sets the range of the vertical scale (0 < minScale <= maxScale). Equal bounds fix the scale.
+		void setVerticalRange(float minScale, float maxScale);
+		/// Gets the scale of the window width.
+		float getHorizontalScale() const;
+		/// Gets the scale of the window height.
+		float getVerticalScale() const;
+		/// Returns the scales to full resolution and forgets the measured render times.
+		void reset();
+
+		/// Adjusts the scales by render time of the last frame (in milliseconds).
+		void update(double frameMs);
+		/// Gets the resolution, the next frame should be rendered in (at least 1 x 1 pixel).
+		sf::Vector2u getRenderSize(sf::Vector2u windowSize) const;
+	};
+}
+
+#endif // !PS_RESOLUTION_CONTROLLER_INCLUDED
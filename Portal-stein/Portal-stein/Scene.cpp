@@ -32,10 +32,10 @@ namespace ps {
 		setFOV(defaultHFOV, defaultAspectRatio);
 	}
 
-	void Camera::rotate(float angle)
+	void Camera::rotate(float cosAngle, float sinAngle)
 	{
-		FloatingObjInScene::rotate(angle);
-		ps::rotate(viewPlaneDirection, angle);
+		FloatingObjInScene::rotate(cosAngle, sinAngle);
+		ps::rotate(viewPlaneDirection, cosAngle, sinAngle);
 	}
 
 	void Camera::setFOV(float horizontalFOV, float aspectRatio)
@@ -53,27 +53,26 @@ namespace ps {
 		}
 	}
 
-	Scene::Scene(const ObjectInScene & camera_) : 
-		segments(), camera(FloatingObjInScene(camera_, 50.0f, *this)) {
-	}
-
-	Scene::Scene(const Scene & rhs) : camera(rhs.camera), segments(rhs.segments) {
-		camera.scene = this; // repoint the camera to this scene
-	}
-
-	Scene & Scene::operator=(const Scene & rhs) {
-		segments = rhs.segments;
-		camera = rhs.camera;
-		camera.scene = this;
-		return *this;
+	void Camera::setPose(const ObjectInScene & pose)
+	{
+		position = pose.getPosition();
+		direction = pose.getDirection();
+		segmentId = pose.getSegmentId();
+
+		// view plane stays perpendicular to the direction, its length (horizontal FOV) is kept
+		float viewPlaneNorm = norm(viewPlaneDirection);
+		viewPlaneDirection.x = direction.y;
+		viewPlaneDirection.y = -1.0f * direction.x;
+		viewPlaneDirection *= viewPlaneNorm;
 	}
 
-	std::size_t Scene::addSegment(Segment && segment_) {
-		segments.push_back(std::move(segment_));
-		return segments.size() - 1;
+	LevelGeometry::LevelGeometry(std::vector<Segment> && segments_) : segments(std::move(segments_)), walls(), index() {
+		for (auto & segment : segments)
+			walls.addSegment(segment.getWalls());
+		index = SegmentIndex(walls);
 	}
 
-	Segment& Scene::getSegment(std::size_t segmentId) {
+	const Segment & LevelGeometry::getSegment(std::size_t segmentId) const {
 		if (0 <= segmentId && segmentId < segments.size()) {
 			return segments[segmentId];
 		}
@@ -83,27 +82,73 @@ namespace ps {
 		}
 	}
 
-	const Segment & Scene::getSegment(std::size_t segmentId) const {
-		if (0 <= segmentId && segmentId < segments.size()) {
-			return segments[segmentId];
-		}
-		else {
-			// this id corresponds to no segment => throw expection
-			throw SegmentNotFound(segmentId);
+	std::size_t LevelGeometry::getSegmentCount() const
+	{
+		return segments.size();
+	}
+
+	const LevelWalls & LevelGeometry::getWalls() const
+	{
+		return walls;
+	}
+
+	bool LevelGeometry::isInSegment(std::size_t segmentId, sf::Vector2f point) const
+	{
+		return segmentId < segments.size() && isPointInSegment(walls, segmentId, point);
+	}
+
+	std::vector<std::size_t> LevelGeometry::findSegments(sf::Vector2f point) const
+	{
+		std::vector<std::size_t> result;
+		index.findSegments(walls, point, result);
+		return result;
+	}
+
+	const Portal * LevelGeometry::findNeighbourPortal(sf::Vector2f point, std::size_t segmentId) const
+	{
+		if (segmentId >= segments.size() || isInSegment(segmentId, point))
+			return nullptr;
+
+		// only the neighbours continue the space the point is in (other segments containing the point can be anywhere in the level), doors
+		// have identity transformation, so the point is tested as it is behind them
+		for (auto & wall : segments[segmentId].getWalls()) {
+			const Portal & portal = wall.getPortal();
+			if (portal.isPortal() && isInSegment(portal.getTargetSegment(), portal.getTransform().transformPoint(point)))
+				return &portal;
 		}
+
+		return nullptr;
+	}
+
+	Scene::Scene(std::shared_ptr<const LevelGeometry> geometry_, const ObjectInScene & camera_) :
+		geometry(std::move(geometry_)), camera(FloatingObjInScene(camera_, 50.0f, *geometry)) {
 	}
 
-	void FloatingObjInScene::rotate(float angle)
+	const LevelGeometry & Scene::getGeometry() const
 	{
-		ObjectInScene::rotate(angle);
+		return *geometry;
+	}
+
+	const Segment & Scene::getSegment(std::size_t segmentId) const {
+		return geometry->getSegment(segmentId);
+	}
+
+	std::size_t Scene::getSegmentCount() const
+	{
+		return geometry->getSegmentCount();
+	}
+
+	void FloatingObjInScene::rotate(float cosAngle, float sinAngle)
+	{
+		ObjectInScene::rotate(cosAngle, sinAngle);
 
 		sf::Vector2f newForce = toVector2(force);
-		ps::rotate(newForce, angle);
+		ps::rotate(newForce, cosAngle, sinAngle);
 		force.x = newForce.x;
 		force.y = newForce.y;
 
 		sf::Vector2f newSpeed = toVector2(speed);
-		ps::rotate(newSpeed, angle);
+		ps::rotate(newSpeed, cosAngle, sinAngle);
 		speed.x = newSpeed.x;
 		speed.y = newSpeed.y;
 	}
@@ -116,9 +161,7 @@ namespace ps {
 
 		position = to;
 
-		LineSegment cameraLS{ toVector2(from), toVector2(to) };
-
-		auto & segment = scene->getSegment(segmentId);
+		auto & segment = geometry->getSegment(segmentId);
 
 		bool cameraUnderFloor = (to.z <= (segment.segmentFloorHeight + 0.1f));
 		bool cameraAboveCeiling = (to.z >= (segment.segmentFloorHeight + segment.segmentWallHeight - 0.1f));
@@ -129,11 +172,13 @@ namespace ps {
 		}
 
 		// check whether the camera didn't get too close to solid wall
-		for (auto & wall : segment.getWalls()) {
-			if (wall.isPortal() == false) {
+		const LevelWalls & walls = geometry->getWalls();
+		const SegmentWalls & segmentWalls = walls.getSegmentWalls(segmentId);
+		for (std::uint32_t wall = segmentWalls.first; wall < segmentWalls.first + segmentWalls.count; ++wall) {
+			if (walls.isPortal(wall) == false) {
 				// solid wall
 				float minimalDistanceToWall = 0.1f;
-				float distanceToWall = wall.distanceFromWall(toVector2(to));
+				float distanceToWall = walls.distanceFromWall(wall, toVector2(to));
 
 				if (distanceToWall < minimalDistanceToWall) {
 					// camera too close to solid wall => put it back
@@ -143,13 +188,21 @@ namespace ps {
 			}
 		}
 
-		// now check for possible step through portal
-		for (auto & wall : segment.getWalls()) {
-			if (wall.isPortal() && wall.intersect(cameraLS)) {
-				// camera steps through the portal
-				wall.stepThrough(*this);
+		// now check for possible step through portal (camera leaves the convex segment through the nearest wall it crosses)
+		WallHit hit = intersectWalls(walls.getWallRange(segmentId), toVector2(from), toVector2(offset), 1.0f);
+		if (hit.wall >= 0) {
+			std::uint32_t wall = segmentWalls.first + (std::uint32_t)hit.wall;
+			if (walls.isPortal(wall) == false) {
+				// long step would tunnel through the solid wall => put it back
+				position = from;
 				return;
 			}
+
+			// camera steps through the portal
+			crossedPortal = walls.getPortal(wall);
+			crossingFraction = hit.rayParameter;
+			crossedPortal.stepThrough(*this);
+			return;
 		}
 	}
 
@@ -165,6 +218,9 @@ namespace ps {
 
 	void FloatingObjInScene::simulate(float deltaTime)
 	{
+		crossedPortal = Portal();
+		crossingFraction = 1.0f;
+
 		sf::Vector3f acceleration = force * (1.0f / mass);
 		float angularAcceleration = torque / mass;
 
@@ -189,9 +245,76 @@ namespace ps {
 		return angularSpeed;
 	}
 
-	FloatingObjInScene::FloatingObjInScene(const ObjectInScene & obj, float mass_, Scene & scene_) :
-		ObjectInScene(obj), scene(&scene_), mass(mass_), force(0.0f, 0.0f, 0.0f), torque(0.0f),
-		speed(0.0f, 0.0f, 0.0f), angularSpeed(0.0f)
+	const Portal & FloatingObjInScene::getCrossedPortal() const
+	{
+		return crossedPortal;
+	}
+
+	float FloatingObjInScene::getCrossingFraction() const
+	{
+		return crossingFraction;
+	}
+
+	bool FloatingObjInScene::recoverSegment()
+	{
+		const Portal * portal = geometry->findNeighbourPortal(toVector2(position), segmentId);
+		if (!portal)
+			return false;
+
+		// the object is moved into the space of the neighbour, the snapshots interpolate it as if it stepped through this portal at the end
+		// of the step, or together with the portal it stepped through during the step (it was only moved by rounding errors since then)
+		portal->stepThrough(*this);
+		if (!crossedPortal.isPortal())
+			crossingFraction = 1.0f;
+		crossedPortal = crossedPortal.then(*portal);
+		return true;
+	}
+
+	FloatingObjInScene::FloatingObjInScene(const ObjectInScene & obj, float mass_, const LevelGeometry & geometry_) :
+		ObjectInScene(obj), geometry(&geometry_), mass(mass_), force(0.0f, 0.0f, 0.0f), torque(0.0f),
+		speed(0.0f, 0.0f, 0.0f), angularSpeed(0.0f), crossedPortal(), crossingFraction(1.0f)
 	{
 	}
+
+	// Interpolates position and direction of two poses, the segment of the first one is kept.
+	static ObjectInScene interpolatePoses(const ObjectInScene & a, const ObjectInScene & b, float alpha)
+	{
+		sf::Vector3f position = a.getPosition() + alpha * (b.getPosition() - a.getPosition());
+		sf::Vector2f direction = a.getDirection() + alpha * (b.getDirection() - a.getDirection());
+
+		// directions are almost the same (simulation step is short), so the interpolated direction is never close to zero
+		if (norm(direction) < 0.001f)
+			direction = b.getDirection();
+
+		return ObjectInScene(position, direction, a.getSegmentId());
+	}
+
+	CameraSnapshot::CameraSnapshot(const ObjectInScene & pose, std::chrono::steady_clock::time_point time_) :
+		previous(pose), current(pose), crossedPortal(), crossingFraction(1.0f), time(time_)
+	{
+	}
+
+	CameraSnapshot::CameraSnapshot(const ObjectInScene & previous_, const FloatingObjInScene & current_, std::chrono::steady_clock::time_point time_) :
+		previous(previous_), current(current_), crossedPortal(current_.getCrossedPortal()), crossingFraction(current_.getCrossingFraction()), time(time_)
+	{
+	}
+
+	ObjectInScene CameraSnapshot::interpolate(float alpha) const
+	{
+		if (crossedPortal.isPortal() == false)
+			return interpolatePoses(previous, current, alpha);
+
+		if (alpha < crossingFraction) {
+			// pose is still before the portal => current pose is mapped back into the previous segment
+			ObjectInScene end = current;
+			crossedPortal.getTransform().inverse().apply(end);
+			end.moveIntoSegment(previous.getSegmentId());
+			return interpolatePoses(previous, end, alpha);
+		}
+
+		// pose is behind the portal => previous pose is mapped into the current segment
+		ObjectInScene start = previous;
+		crossedPortal.stepThrough(start);
+		return interpolatePoses(start, current, alpha);
+	}
 }
\ No newline at end of file
@@ -33,7 +33,7 @@ namespace ps {
 		else {
 			PortalWall & lastWall = *segment.walls.rbegin();
 
-			if (lastWall.to != wall.from) {
+			if (lastWall.getTo() != wall.getFrom()) {
 				throw WallsAreNotConnected();
 			}
 			else {
@@ -58,7 +58,7 @@ namespace ps {
 
 		PortalWall & firstWall = *segment.walls.begin();
 		PortalWall & lastWall = *segment.walls.rbegin();
-		if (lastWall.to != firstWall.from) {
+		if (lastWall.getTo() != firstWall.getFrom()) {
 			throw WallsAreNotConnected();
 		}
 
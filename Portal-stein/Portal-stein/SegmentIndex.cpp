@@ -0,0 +1,118 @@
+#include "SegmentIndex.hpp"
+#include <cmath>
+#include <algorithm>
+#include "Math.hpp"
+
+namespace ps {
+
+	bool isPointInSegment(const LevelWalls & walls, std::size_t segmentId, sf::Vector2f point)
+	{
+		// segments are convex, so the point lies in the segment, if it lies on the same side of all its walls (walls of the segment are
+		// ordered clockwise, or counter-clockwise, so the side is not fixed)
+		const SegmentWalls & segmentWalls = walls.getSegmentWalls(segmentId);
+		bool left = true;
+		bool right = true;
+		for (std::uint32_t wall = segmentWalls.first; wall < segmentWalls.first + segmentWalls.count; ++wall) {
+			sf::Vector2f from = walls.getFrom(wall);
+			float side = cross(walls.getTo(wall) - from, point - from);
+			float maxSide = SegmentIndex::tolerance * walls.getLength(wall);
+			left = left && side >= -maxSide;
+			right = right && side <= maxSide;
+		}
+
+		return segmentWalls.count > 0 && (left || right);
+	}
+
+	SegmentIndex::SegmentIndex() : origin(), inverseCellSize(1.0f), columns(1), rows(1), cellStart(2, 0), cellSegments() {
+	}
+
+	SegmentIndex::SegmentIndex(const LevelWalls & walls) : SegmentIndex()
+	{
+		std::size_t segmentCount = walls.getSegmentCount();
+
+		// bounding boxes of the segments (extended by the tolerance, so the points on the walls are found)
+		std::vector<sf::FloatRect> boxes(segmentCount);
+		sf::Vector2f levelMin{ INFINITY, INFINITY };
+		sf::Vector2f levelMax{ -INFINITY, -INFINITY };
+		for (std::size_t segmentId = 0; segmentId < segmentCount; ++segmentId) {
+			const SegmentWalls & segmentWalls = walls.getSegmentWalls(segmentId);
+			if (segmentWalls.count == 0)
+				continue;
+
+			sf::Vector2f min = walls.getFrom(segmentWalls.first);
+			sf::Vector2f max = min;
+			for (std::uint32_t wall = segmentWalls.first + 1; wall < segmentWalls.first + segmentWalls.count; ++wall) {
+				sf::Vector2f from = walls.getFrom(wall);
+				min = sf::Vector2f(getMin(min.x, from.x), getMin(min.y, from.y));
+				max = sf::Vector2f(getMax(max.x, from.x), getMax(max.y, from.y));
+			}
+			min -= sf::Vector2f(tolerance, tolerance);
+			max += sf::Vector2f(tolerance, tolerance);
+
+			boxes[segmentId] = sf::FloatRect(min, max - min);
+			levelMin = sf::Vector2f(getMin(levelMin.x, min.x), getMin(levelMin.y, min.y));
+			levelMax = sf::Vector2f(getMax(levelMax.x, max.x), getMax(levelMax.y, max.y));
+		}
+
+		if (levelMin.x > levelMax.x)
+			return;	// no segment has walls
+
+		// about one cell per segment, but no more cells in a row (or column) than segments, so long and thin levels do not get too many cells
+		sf::Vector2f size = levelMax - levelMin;
+		float cellSize = getMax(std::sqrt(size.x * size.y / segmentCount), getMax(size.x, size.y) / segmentCount);
+		origin = levelMin;
+		inverseCellSize = 1.0f / cellSize;
+		columns = (std::size_t)(size.x * inverseCellSize) + 1;
+		rows = (std::size_t)(size.y * inverseCellSize) + 1;
+
+		// segments are counted in the cells first, so the lists of all the cells can be stored in one array
+		auto forEachCell = [this, &boxes](std::size_t segmentId, auto function) {
+			const sf::FloatRect & box = boxes[segmentId];
+			std::size_t firstColumn = getCell(box.left, origin.x, columns);
+			std::size_t lastColumn = getCell(box.left + box.width, origin.x, columns);
+			std::size_t lastRow = getCell(box.top + box.height, origin.y, rows);
+			for (std::size_t row = getCell(box.top, origin.y, rows); row <= lastRow; ++row) {
+				for (std::size_t column = firstColumn; column <= lastColumn; ++column)
+					function(row * columns + column);
+			}
+		};
+
+		cellStart.assign(columns * rows + 1, 0);
+		for (std::size_t segmentId = 0; segmentId < segmentCount; ++segmentId) {
+			if (walls.getSegmentWalls(segmentId).count > 0)
+				forEachCell(segmentId, [this](std::size_t cell) { cellStart[cell + 1]++; });
+		}
+		for (std::size_t cell = 0; cell < columns * rows; ++cell)
+			cellStart[cell + 1] += cellStart[cell];
+
+		cellSegments.resize(cellStart.back());
+		std::vector<std::uint32_t> cellEnd(cellStart.begin(), cellStart.end() - 1);
+		for (std::size_t segmentId = 0; segmentId < segmentCount; ++segmentId) {
+			if (walls.getSegmentWalls(segmentId).count > 0)
+				forEachCell(segmentId, [this, &cellEnd, segmentId](std::size_t cell) { cellSegments[cellEnd[cell]++] = (std::uint32_t)segmentId; });
+		}
+	}
+
+	std::size_t SegmentIndex::getCell(float coordinate, float originCoordinate, std::size_t count) const
+	{
+		float cell = std::floor((coordinate - originCoordinate) * inverseCellSize);
+		if (!(cell >= 0.0f))
+			return 0;
+		return getMin((std::size_t)getMin(cell, (float)count), count - 1);
+	}
+
+	void SegmentIndex::findSegments(const LevelWalls & walls, sf::Vector2f point, std::vector<std::size_t> & result) const
+	{
+		std::size_t cell = getCell(point.y, origin.y, rows) * columns + getCell(point.x, origin.x, columns);
+		for (std::uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+			std::uint32_t segmentId = cellSegments[i];
+			if (isPointInSegment(walls, segmentId, point))
+				result.push_back(segmentId);
+		}
+	}
+
+	std::size_t SegmentIndex::getCellCount() const
+	{
+		return columns * rows;
+	}
+}
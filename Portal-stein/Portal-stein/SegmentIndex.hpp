@@ -0,0 +1,52 @@
+#pragma once
+#ifndef PS_SEGMENT_INDEX_INCLUDED
+#define PS_SEGMENT_INDEX_INCLUDED
+#include <vector>
+#include <cstdint>
+#include <SFML\Graphics.hpp>
+#include "LevelWalls.hpp"
+
+namespace ps {
+
+	//**************************************************************************
+	// SEGMENT INDEX
+	//**************************************************************************
+
+	/// Returns true if the point lies in the segment (points on its walls lie in it, up to SegmentIndex::tolerance).
+	bool isPointInSegment(const LevelWalls & walls, std::size_t segmentId, sf::Vector2f point);
+
+	/// Finds the segments that contain a point. Bounding box of the walls of the level is split into a uniform grid with about as many cells
+	/// as there are segments, and each cell lists the segments whose bounding boxes overlap it. A query tests only the segments listed in the
+	/// cell of the point, so it costs the same in levels with 100 and 100k segments. Portals make the space of the level non-Euclidean, so
+	/// segments can overlap each other and a point can lie in several of them.
+	class SegmentIndex {
+	public:
+		/// Distance from the walls, that points can be out of the segment and still be found in it.
+		static constexpr float tolerance = 1e-4f;
+
+	private:
+		sf::Vector2f origin;		///< Corner of the grid with minimal coordinates.
+		float inverseCellSize;
+		std::size_t columns;
+		std::size_t rows;
+		std::vector<std::uint32_t> cellStart;	///< Segments of cell c are cellSegments[cellStart[c]] .. cellSegments[cellStart[c + 1] - 1].
+		std::vector<std::uint32_t> cellSegments;	///< Ids of the segments listed in the cells (in increasing order in each cell).
+
+		/// Gets the grid column (or row) the coordinate lies in (coordinates out of the grid are clamped to it).
+		std::size_t getCell(float coordinate, float originCoordinate, std::size_t count) const;
+
+	public:
+		/// Creates index with no segments.
+		SegmentIndex();
+		/// Creates index of the segments of the walls.
+		explicit SegmentIndex(const LevelWalls & walls);
+
+		/// Appends ids of the segments, that contain the point, to the result (in increasing order).
+		/// \param walls Walls the index was created from.
+		void findSegments(const LevelWalls & walls, sf::Vector2f point, std::vector<std::size_t> & result) const;
+		/// Gets number of the cells of the grid.
+		std::size_t getCellCount() const;
+	};
+}
+
+#endif // !PS_SEGMENT_INDEX_INCLUDED
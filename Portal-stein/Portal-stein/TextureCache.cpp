@@ -0,0 +1,185 @@
+#include "TextureCache.hpp"
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include "Math.hpp"
+#include "Profiler.hpp"
+
+namespace ps {
+
+	TextureCache::Entry::Entry() : texture(), image(), decoded(false), failed(false), uploaded(false)
+	{
+	}
+
+	TextureCache::TextureCache() : entries(), decoders(), decodeCount(0)
+	{
+	}
+
+	TextureCache::~TextureCache()
+	{
+		// decoding tasks lock the mutex of the cache, so they have to finish before the members are destroyed
+		decoders.reset();
+	}
+
+	TextureCache & TextureCache::getInstance()
+	{
+		static TextureCache instance;
+		return instance;
+	}
+
+	std::string TextureCache::getCanonicalPath(const std::string & path)
+	{
+		std::error_code error;
+		auto canonicalPath = std::experimental::filesystem::canonical(path, error);
+		// files, that do not exist, are kept under the original path (their loading fails anyway)
+		return (error) ? path : canonicalPath.string();
+	}
+
+	std::shared_ptr<TextureCache::Entry> TextureCache::findEntry(const std::string & path)
+	{
+		auto it = entries.find(getCanonicalPath(path));
+		return (it == entries.end()) ? nullptr : it->second;
+	}
+
+	void TextureCache::eraseExpiredEntries()
+	{
+		for (auto it = entries.begin(); it != entries.end(); ) {
+			if (it->second->texture.expired())
+				it = entries.erase(it);
+			else
+				++it;
+		}
+	}
+
+	std::shared_ptr<sf::Texture> TextureCache::request(const std::string & path)
+	{
+		std::string canonicalPath = getCanonicalPath(path);
+		std::lock_guard<std::mutex> lock(mutex);
+
+		// levels stream in and out for the whole session, so the textures of the released levels are forgotten
+		eraseExpiredEntries();
+
+		auto & entry = entries[canonicalPath];
+		if (entry) {
+			auto texture = entry->texture.lock();
+			// texture still used by other level is shared, texture that failed to load is tried again (the file might be fixed now)
+			if (texture && !(entry->decoded && entry->failed))
+				return texture;
+		}
+
+		// walls and floors repeat their textures, it is set only here so that levels loaded in parallel never change the shared texture
+		auto texture = std::make_shared<sf::Texture>();
+		texture->setRepeated(true);
+		entry = std::make_shared<Entry>();
+		entry->texture = texture;
+
+		if (!decoders) {
+			// the pool does not decode on the calling thread, so all the threads of the pool are workers
+			std::size_t cores = getMax<std::size_t>(std::thread::hardware_concurrency(), 1);
+			decoders = std::make_unique<ThreadPool>(cores + 1);
+		}
+
+		std::shared_ptr<Entry> decodedEntry = entry;
+		decoders->submit([this, decodedEntry, path]() {
+			PS_PROFILE_SCOPE("decodeTexture");
+			auto image = std::make_shared<sf::Image>();
+			bool success = image->loadFromFile(path);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (success)
+					decodedEntry->image = std::move(image);
+				decodedEntry->decoded = true;
+				decodedEntry->failed = !success;
+				decodeCount++;
+			}
+			imageDecoded.notify_all();
+		});
+
+		return texture;
+	}
+
+	bool TextureCache::waitForImage(const std::string & path)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		auto entry = findEntry(path);
+		if (!entry)
+			return false;
+
+		imageDecoded.wait(lock, [&entry]() { return entry->decoded; });
+		return !entry->failed;
+	}
+
+	void TextureCache::upload(bool waitForDecoding)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		eraseExpiredEntries();
+
+		// the mutex is released while an image is decoded and other threads can erase entries then, so the entries are collected first
+		std::vector<std::shared_ptr<Entry>> pending;
+		for (auto & pair : entries) {
+			if (!pair.second->uploaded && (waitForDecoding || pair.second->decoded))
+				pending.push_back(pair.second);
+		}
+
+		for (auto & entry : pending) {
+			imageDecoded.wait(lock, [&entry]() { return entry->decoded; });
+			auto texture = entry->texture.lock();
+			if (texture && !entry->failed)
+				texture->loadFromImage(*entry->image);
+			entry->uploaded = true;
+		}
+	}
+
+	void TextureCache::uploadTextures()
+	{
+		PS_PROFILE_SCOPE("uploadTextures");
+		upload(true);
+	}
+
+	void TextureCache::uploadDecodedTextures()
+	{
+		PS_PROFILE_SCOPE("uploadTextures");
+		upload(false);
+	}
+
+	std::shared_ptr<const sf::Image> TextureCache::getImage(const sf::Texture * texture)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		// levels use a few textures and the renderer asks for each of them once, so the entries are searched linearly
+		for (auto & pair : entries) {
+			if (pair.second->texture.lock().get() == texture)
+				return pair.second->image;
+		}
+		return nullptr;
+	}
+
+	std::size_t TextureCache::getTextureCount()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::size_t count = 0;
+		for (auto & pair : entries) {
+			if (!pair.second->texture.expired())
+				count++;
+		}
+		return count;
+	}
+
+	std::size_t TextureCache::getTextureMemory()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::size_t bytes = 0;
+		for (auto & pair : entries) {
+			auto texture = pair.second->texture.lock();
+			if (texture)
+				bytes += (std::size_t)texture->getSize().x * texture->getSize().y * 4;
+		}
+		return bytes;
+	}
+
+	std::size_t TextureCache::getDecodeCount()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return decodeCount;
+	}
+}
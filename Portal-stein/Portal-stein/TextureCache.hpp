@@ -0,0 +1,88 @@
+#pragma once
+#ifndef PS_TEXTURE_CACHE_INCLUDED
+#define PS_TEXTURE_CACHE_INCLUDED
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include "SFML\Graphics.hpp"
+#include "ThreadPool.hpp"
+
+namespace ps {
+
+	//**************************************************************************
+	// TEXTURE CACHE
+	//**************************************************************************
+
+	/// Textures of all the levels, each file is loaded only once. Textures are shared by the levels, that use them, and the cache only
+	/// keeps weak references, so the texture is freed when the last level using it is gone.
+	///
+	/// Loading is split into two steps. Image of the texture is decoded by worker threads of the cache, while the level is still parsed.
+	/// The decoded image is uploaded into the texture later by uploadTextures(), that must be called from the thread owning the OpenGL
+	/// context. Textures are empty until they are uploaded. The decoded image is kept with the texture, so the software renderer samples
+	/// it without reading the texture back from GPU.
+	class TextureCache {
+	private:
+		struct Entry {
+			std::weak_ptr<sf::Texture> texture;
+			std::shared_ptr<const sf::Image> image;		///< Decoded image (nullptr until it is decoded).
+			bool decoded;			///< Decoding finished (successfuly or not).
+			bool failed;			///< Image could not be loaded from the file.
+			bool uploaded;
+
+			Entry();
+		};
+
+		std::map<std::string, std::shared_ptr<Entry>> entries;	///< Canonical path -> entry.
+		std::unique_ptr<ThreadPool> decoders;					///< Created when the first image is decoded.
+		std::size_t decodeCount;
+		std::mutex mutex;
+		std::condition_variable imageDecoded;
+
+		/// Finds entry of the texture. Returns nullptr if the texture was never requested. Mutex must be locked.
+		std::shared_ptr<Entry> findEntry(const std::string & path);
+		/// Erases the entries of the textures, that are not used by any level any more (decoding of their images can still be running, it
+		/// keeps its entry alive). Mutex must be locked.
+		void eraseExpiredEntries();
+		/// Uploads the decoded images into their textures. Images that are being decoded are waited for, if waitForDecoding is set, or
+		/// left for the next upload otherwise.
+		void upload(bool waitForDecoding);
+
+	public:
+		TextureCache();
+		~TextureCache();
+
+		TextureCache(const TextureCache &) = delete;
+		TextureCache & operator=(const TextureCache &) = delete;
+
+		/// Gets the cache shared by the whole game.
+		static TextureCache & getInstance();
+		/// Gets the path, that identifies the file in the cache (the same file can be referenced by different paths).
+		static std::string getCanonicalPath(const std::string & path);
+
+		/// Gets texture loaded from the file. If the texture is not in the cache (or it could not be loaded before), decoding of its image
+		/// is started on the worker threads. Texture is empty until uploadTextures() is called.
+		std::shared_ptr<sf::Texture> request(const std::string & path);
+		/// Waits until the image of requested texture is decoded. Returns false if it could not be loaded from the file.
+		bool waitForImage(const std::string & path);
+		/// Waits for all requested images and uploads them into their textures. Must be called from the thread owning OpenGL context.
+		void uploadTextures();
+		/// Uploads the images decoded so far into their textures, the images that are still being decoded are left for the next upload.
+		/// Must be called from the thread owning OpenGL context.
+		void uploadDecodedTextures();
+
+		/// Gets the decoded image of the texture, that was requested from the cache. Returns nullptr if the texture is not in the cache, or
+		/// its image is not decoded (or it could not be loaded).
+		std::shared_ptr<const sf::Image> getImage(const sf::Texture * texture);
+
+		/// Gets the number of textures, that are used by some level.
+		std::size_t getTextureCount();
+		/// Gets the memory taken by the pixels of the uploaded textures, that are used by some level.
+		std::size_t getTextureMemory();
+		/// Gets the number of images decoded since the cache was created.
+		std::size_t getDecodeCount();
+	};
+}
+
+#endif // !PS_TEXTURE_CACHE_INCLUDED
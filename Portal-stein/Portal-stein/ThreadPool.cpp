@@ -0,0 +1,132 @@
+#include "ThreadPool.hpp"
+#include "Math.hpp"
+
+namespace ps {
+
+	ThreadPool::ThreadPool(std::size_t threadCount) : queues(), workers(), queuedTasks(0), unfinishedTasks(0), nextQueue(0), stopping(false)
+	{
+		threadCount = getMax<std::size_t>(threadCount, 1);
+
+		for (std::size_t i = 0; i < threadCount; ++i)
+			queues.push_back(std::make_unique<TaskQueue>());
+
+		for (std::size_t i = 1; i < threadCount; ++i)
+			workers.emplace_back(&ThreadPool::workerLoop, this, i);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(stateMutex);
+			stopping = true;
+		}
+		taskAdded.notify_all();
+
+		for (auto & worker : workers)
+			worker.join();
+	}
+
+	std::size_t ThreadPool::getThreadCount() const
+	{
+		return queues.size();
+	}
+
+	void ThreadPool::submit(std::size_t queueIndex, std::function<void()> task)
+	{
+		{
+			// counters are changed under the state mutex, so sleeping worker cannot miss the notification, and they are incremented before
+			// the task is queued, so the worker that takes it cannot decrement them first
+			std::lock_guard<std::mutex> lock(stateMutex);
+			queuedTasks++;
+			unfinishedTasks++;
+		}
+
+		TaskQueue & queue = *queues[queueIndex % queues.size()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back(std::move(task));
+		}
+		taskAdded.notify_one();
+	}
+
+	void ThreadPool::submit(std::function<void()> task)
+	{
+		submit(nextQueue++, std::move(task));
+	}
+
+	bool ThreadPool::takeTask(std::size_t queueIndex, std::function<void()> & task)
+	{
+		if (queuedTasks == 0)
+			return false;
+
+		{
+			// own queue is processed from the front ...
+			TaskQueue & own = *queues[queueIndex];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.tasks.empty()) {
+				task = std::move(own.tasks.front());
+				own.tasks.pop_front();
+				queuedTasks--;
+				return true;
+			}
+		}
+
+		// ... and the other queues are robbed from the back
+		for (std::size_t i = 1; i < queues.size(); ++i) {
+			TaskQueue & victim = *queues[(queueIndex + i) % queues.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.tasks.empty()) {
+				task = std::move(victim.tasks.back());
+				victim.tasks.pop_back();
+				queuedTasks--;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void ThreadPool::runTask(std::function<void()> & task)
+	{
+		task();
+
+		std::lock_guard<std::mutex> lock(stateMutex);
+		unfinishedTasks--;
+		if (unfinishedTasks == 0)
+			allDone.notify_all();
+	}
+
+	void ThreadPool::workerLoop(std::size_t queueIndex)
+	{
+		while (true) {
+			std::function<void()> task;
+			if (takeTask(queueIndex, task)) {
+				runTask(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(stateMutex);
+			taskAdded.wait(lock, [this]() { return stopping || queuedTasks != 0; });
+			if (stopping && queuedTasks == 0)
+				return;
+		}
+	}
+
+	void ThreadPool::wait()
+	{
+		while (true) {
+			std::function<void()> task;
+			if (takeTask(0, task)) {
+				runTask(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(stateMutex);
+			if (unfinishedTasks == 0)
+				return;
+
+			allDone.wait(lock, [this]() { return unfinishedTasks == 0 || queuedTasks != 0; });
+		}
+	}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef PS_THREAD_POOL_INCLUDED
+#define PS_THREAD_POOL_INCLUDED
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace ps {
+
+	//**************************************************************************
+	// THREAD POOL
+	//**************************************************************************
+
+	/// Pool of threads executing tasks. Each thread has its own queue of tasks. Thread takes tasks from the front of its own queue,
+	/// and when its queue is empty it steals tasks from the back of the other queues. So the load gets rebalanced automatically, when
+	/// some tasks take much longer than the others. Tasks must not throw exceptions.
+	class ThreadPool {
+	private:
+		struct TaskQueue {
+			std::deque<std::function<void()>> tasks;
+			std::mutex mutex;
+		};
+
+		std::vector<std::unique_ptr<TaskQueue>> queues;	///< Queue 0 belongs to the thread that calls wait(), others to the worker threads.
+		std::vector<std::thread> workers;
+
+		std::mutex stateMutex;
+		std::condition_variable taskAdded;
+		std::condition_variable allDone;
+		std::atomic<std::size_t> queuedTasks;		///< Number of tasks waiting in the queues (or being queued).
+		std::size_t unfinishedTasks;				///< Number of tasks that were submitted, but did not finish yet. Guarded by stateMutex.
+		std::atomic<std::size_t> nextQueue;			///< Queue that gets the next task submitted without specified queue.
+		bool stopping;
+
+		/// Takes task from the front of own queue, or steals it from the back of other queue. Returns false if all queues are empty.
+		bool takeTask(std::size_t queueIndex, std::function<void()> & task);
+		/// Runs the task and marks it finished.
+		void runTask(std::function<void()> & task);
+		void workerLoop(std::size_t queueIndex);
+
+	public:
+		/// Creates pool that executes the tasks by threadCount threads. The thread calling wait() is one of them, so (threadCount - 1)
+		/// worker threads are started.
+		ThreadPool(std::size_t threadCount);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool & operator=(const ThreadPool &) = delete;
+
+		/// Gets number of threads executing tasks (including the thread calling wait()).
+		std::size_t getThreadCount() const;
+		/// Adds task to the queue of specified thread.
+		void submit(std::size_t queueIndex, std::function<void()> task);
+		/// Adds task to the queues in round-robin fashion.
+		void submit(std::function<void()> task);
+		/// Executes tasks until all submitted tasks are finished.
+		void wait();
+	};
+}
+
+#endif // !PS_THREAD_POOL_INCLUDED
@@ -0,0 +1,87 @@
+#pragma once
+#ifndef PS_TRIPLE_BUFFER_INCLUDED
+#define PS_TRIPLE_BUFFER_INCLUDED
+#include <array>
+#include <atomic>
+
+namespace ps {
+
+	// *******************
+	// DECLARATIONS
+	// *******************
+
+	/// Hands over values from one writer thread to one reader thread without locks. Writer fills the back buffer and publishes it,
+	/// reader takes the newest published value. Neither of them ever waits for the other: values published faster than they are read
+	/// are overwritten, and the reader keeps the last value it took until a newer one is published.
+	template< typename T >
+	class TripleBuffer {
+	private:
+		static const unsigned int indexMask = 3;	///< Bits of middle, that hold the index of the buffer.
+		static const unsigned int freshBit = 4;		///< Bit of middle, that is set when the middle buffer was published, but not read.
+
+		std::array<T, 3> buffers;
+		std::atomic<unsigned int> middle;	///< Index of the buffer exchanged between the threads (with freshBit).
+		unsigned int back;					///< Index of the buffer owned by the writer.
+		unsigned int front;					///< Index of the buffer owned by the reader.
+
+	public:
+		/// Creates triple buffer, where all the buffers hold the initial value.
+		explicit TripleBuffer(const T & initial);
+
+		TripleBuffer(const TripleBuffer &) = delete;
+		TripleBuffer & operator=(const TripleBuffer &) = delete;
+
+		/// Gets the buffer the writer fills. Only the writer thread may call this.
+		T & getWriteBuffer();
+		/// Publishes the written buffer, the writer gets another one to fill. Only the writer thread may call this.
+		void publish();
+
+		/// Takes the newest published value, if there is one the reader did not take yet. Returns true if the value changed.
+		/// Only the reader thread may call this.
+		bool update();
+		/// Gets the value taken by the last update(). Only the reader thread may call this.
+		const T & getReadBuffer() const;
+	};
+
+	// *****************
+	// DEFINITIONS
+	// *****************
+
+	template<typename T>
+	inline TripleBuffer<T>::TripleBuffer(const T & initial) : buffers{ { initial, initial, initial } }, middle(1), back(0), front(2)
+	{
+	}
+
+	template<typename T>
+	inline T & TripleBuffer<T>::getWriteBuffer()
+	{
+		return buffers[back];
+	}
+
+	template<typename T>
+	inline void TripleBuffer<T>::publish()
+	{
+		// release makes the written buffer visible to the reader, acquire makes sure the reader is done with the buffer it gave back
+		unsigned int previous = middle.exchange(back | freshBit, std::memory_order_acq_rel);
+		back = previous & indexMask;
+	}
+
+	template<typename T>
+	inline bool TripleBuffer<T>::update()
+	{
+		if ((middle.load(std::memory_order_relaxed) & freshBit) == 0)
+			return false;
+
+		unsigned int previous = middle.exchange(front, std::memory_order_acq_rel);
+		front = previous & indexMask;
+		return true;
+	}
+
+	template<typename T>
+	inline const T & TripleBuffer<T>::getReadBuffer() const
+	{
+		return buffers[front];
+	}
+}
+
+#endif // !PS_TRIPLE_BUFFER_INCLUDED
@@ -3,17 +3,21 @@
 
 namespace ps {
 
-	Wall::Wall(sf::Vector2f from, sf::Vector2f to, sf::Color color) : Wall(from, to, color, nullptr) {
+	WallGeometry::WallGeometry(const sf::Vector2f & from, const sf::Vector2f & to) : direction(to - from)
+	{
+		length = norm(direction);
+		invLength = (length > 0.0f) ? 1.0f / length : 0.0f;
+		normal = invLength * sf::Vector2f(direction.y, -direction.x);	// perpendicular vector to direction
+		planeOffset = dot(normal, from);
 	}
 
-	Wall::Wall(sf::Vector2f from_, sf::Vector2f to_, sf::Color color_, std::shared_ptr<sf::Texture> texture_) : from(from_), to(to_), color(color_), texture(texture_) {
-		if (texture != nullptr)
-			texture->setRepeated(true);
+	Wall::Wall(sf::Vector2f from, sf::Vector2f to, sf::Color color) : Wall(from, to, color, nullptr) {
 	}
 
-	void Wall::draw(sf::RenderTarget & rt, const WallDrawParameters & params) const {
-		sf::VertexArray vertexArr( sf::PrimitiveType::Lines, 2 );
+	Wall::Wall(sf::Vector2f from_, sf::Vector2f to_, sf::Color color_, std::shared_ptr<sf::Texture> texture_) : color(color_), texture(texture_), from(from_), to(to_), geometry(from_, to_) {
+	}
 
+	void WallMaterial::draw(RenderBatch & batch, const WallDrawParameters & params) const {
 		if (texture != nullptr) {
 			float texSizeX = (float)texture->getSize().x;
 			float texSizeY = (float)texture->getSize().y;
@@ -26,58 +30,76 @@ namespace ps {
 			uvWallBottom.x *= texSizeX;
 			uvWallBottom.y *= texSizeY;
 
-			vertexArr[0] = sf::Vertex(params.scrWallTop, color, uvWallTop);
-			vertexArr[1] = sf::Vertex(params.scrWallBottom, color, uvWallBottom);
+			batch.addLine(sf::Vertex(params.scrWallTop, color, uvWallTop), sf::Vertex(params.scrWallBottom, color, uvWallBottom), texture);
 		}
 		else {
-			vertexArr[0] = sf::Vertex(params.scrWallTop, color);
-			vertexArr[1] = sf::Vertex(params.scrWallBottom, color);
+			batch.addLine(sf::Vertex(params.scrWallTop, color), sf::Vertex(params.scrWallBottom, color));
 		}
+	}
+
+	void Wall::draw(RenderBatch & batch, const WallDrawParameters & params) const {
+		getMaterial().draw(batch, params);
+	}
+
+	const sf::Vector2f & Wall::getFrom() const
+	{
+		return from;
+	}
+
+	const sf::Vector2f & Wall::getTo() const
+	{
+		return to;
+	}
+
+	const WallGeometry & Wall::getGeometry() const
+	{
+		return geometry;
+	}
 
-		rt.draw(vertexArr, texture.get());
+	WallMaterial Wall::getMaterial() const
+	{
+		return WallMaterial{ color, texture.get() };
 	}
 
 	float Wall::getWidth() const
 	{
-		return norm(to - from);
+		return geometry.length;
 	}
 
-	void PortalWall::setPortal(const portalPtr & portal_) {
+	void PortalWall::setPortal(const Portal & portal_) {
 		portal = portal_;
 	}
 
 	PortalWall::PortalWall(sf::Vector2f from, sf::Vector2f to, sf::Color color) : PortalWall(from, to, color, nullptr) {
 	}
 
-	PortalWall::PortalWall(sf::Vector2f from, sf::Vector2f to, sf::Color color, std::shared_ptr<sf::Texture> texture) : Wall(from, to, color, texture), portal(nullptr) {
+	PortalWall::PortalWall(sf::Vector2f from, sf::Vector2f to, sf::Color color, std::shared_ptr<sf::Texture> texture) : Wall(from, to, color, texture), portal() {
 	}
 
 	bool PortalWall::isPortal() const
 	{
-		return portal.get() != nullptr;
+		return portal.isPortal();
+	}
+
+	const Portal & PortalWall::getPortal() const
+	{
+		return portal;
 	}
 
 	void PortalWall::stepThrough(ObjectInScene & obj) const
 	{
-		if (portal) {
-			portal->stepThrough(obj);
-		}
+		portal.stepThrough(obj);
 	}
 
 	bool Wall::facesRay(const Ray & ray) const
 	{
-		auto wallDirection = to - from;
-		auto rayDirection = ray.getDirection();
-
-		float crossProduct = cross(wallDirection, rayDirection);
+		float crossProduct = cross(geometry.direction, ray.getDirection());
 		return (0 < crossProduct);
 	}
 
 	float Wall::distanceFromWall(const sf::Vector2f & point) const
 	{
-		sf::Vector2f r = to - from;
-		float rDotR = dot(r, r);
-		sf::Vector2f normal(r.y, -r.x);	// perpendicular vector to r
+		const sf::Vector2f & r = geometry.direction;
 
 		// "from" is put into coordinate system center
 		sf::Vector2f x = point - from;
@@ -86,27 +108,33 @@ namespace ps {
 			// returns distance from "from" (x == point - from)
 			return norm(x);
 		} 
-		else if (rDot > rDotR) {
+		else if (rDot > geometry.length * geometry.length) {
 			// returns distance from "to" (x - r == point - to)
 			return norm(x - r);
 		}
 		else {
-			// return distance of point x from line segment "from"-"to"
-			return (1 / norm(normal)) * dot(normal, x);
+			// return distance of point from line going through "from" and "to"
+			return dot(geometry.normal, point) - geometry.planeOffset;
 		}
 	}
 
 	bool Wall::intersect(const Ray & ray, WallIntersection & intersection) const
 	{
-		auto lineSegmentIntersection = ps::intersect(ray, LineSegment(from, to));
-		if (lineSegmentIntersection.theyIntersect) {
-			intersection.rayIntersectionDistance = lineSegmentIntersection.rayParameter;
-			intersection.distanceToWallEdge = lineSegmentIntersection.lineSegmentParameter;
-			return true;
-		}
-		else {
+		// solves (origin + t * rayDirection == from + s * direction) by Cramer's rule
+		sf::Vector2f rayDirection = ray.getDirection();
+		float det = cross(geometry.direction, rayDirection);
+		if (det == 0.0f)
 			return false;
-		}
+
+		sf::Vector2f b = from - toVector2(ray.getPosition());
+		float t = cross(geometry.direction, b) / det;
+		float s = cross(rayDirection, b) / det;
+		if (t < 0.0f || s < 0.0f || s > 1.0f)
+			return false;
+
+		intersection.rayIntersectionDistance = t;
+		intersection.distanceToWallEdge = s;
+		return true;
 	}
 
 	bool Wall::intersect(const LineSegment & lineSegment_) const
@@ -117,16 +145,14 @@ namespace ps {
 
 	PortalWall makeDoorWall(sf::Vector2f from_, sf::Vector2f to_, std::size_t targetSegment_) {
 		PortalWall result(from_, to_, sf::Color::White);
-		portalPtr portal_ = std::make_unique<Door>(targetSegment_);
-		result.setPortal(std::move(portal_));
+		result.setPortal(makeDoor(targetSegment_));
 		return std::move(result);
 	}
 
 	PortalWall makeWallPortalWall(LineSegment wallFrom, LineSegment wallTo, std::size_t targetSegment_) 
 	{
 		PortalWall result(wallFrom.getFrom(), wallFrom.getTo(), sf::Color::White);
-		portalPtr portal_ = std::make_unique<WallPortal>(wallFrom, wallTo, targetSegment_);
-		result.setPortal(std::move(portal_));
+		result.setPortal(makeWallPortal(wallFrom, wallTo, targetSegment_));
 		return result;
 	}
 
@@ -6,6 +6,7 @@
 #include "Portal.hpp"
 #include "ObjectInScene.hpp"
 #include "Geometry.hpp"
+#include "RenderBatch.hpp"
 
 namespace ps {
 
@@ -21,6 +22,28 @@ namespace ps {
 		float distanceToWallEdge;		///< Distance from Wall edge to hit point.
 	};
 
+	/// Look of the wall: its color and (optional) texture. Walls with the same look share one material in LevelWalls.
+	struct WallMaterial {
+		sf::Color color;
+		const sf::Texture * texture;	///< Texture of the wall (nullptr if the wall has only color). Material does not own it.
+
+		/// Adds the wall strip with this material to the render batch.
+		void draw(RenderBatch & batch, const WallDrawParameters & params) const;
+	};
+
+	/// Geometry of the wall derived from its end points. It is computed once, when the wall is created, so the rendering and collisions
+	/// do not recompute it (walls never move).
+	struct WallGeometry {
+		sf::Vector2f direction;		///< Vector (to - from).
+		sf::Vector2f normal;		///< Unit normal of the wall, pointing to the inside of the segment.
+		float length;				///< Length of the wall.
+		float invLength;			///< Reciprocal of the wall length.
+		float planeOffset;			///< Signed distance of point p from the wall line is (dot(normal, p) - planeOffset).
+
+		/// Computes geometry of the wall going from one point to another.
+		WallGeometry(const sf::Vector2f & from, const sf::Vector2f & to);
+	};
+
 
 
 	//************************************************************************
@@ -32,19 +55,27 @@ namespace ps {
 	private:
 		sf::Color color;
 		std::shared_ptr<sf::Texture> texture;
-
-	public:
 		sf::Vector2f from;
 		sf::Vector2f to;
+		WallGeometry geometry;
 
+	public:
 		/// Creates a colored wall.
 		Wall(sf::Vector2f from, sf::Vector2f to, sf::Color color);
 		/// Creates a wall with color + texture. 
 		Wall(sf::Vector2f from, sf::Vector2f to, sf::Color color, std::shared_ptr<sf::Texture> texture);
 
-		/// Draws the wall on render target, according to draw parameters that were passed.
-		void draw(sf::RenderTarget & rt, const WallDrawParameters & params) const;
-
+		/// Adds the wall strip to the render batch, according to draw parameters that were passed.
+		void draw(RenderBatch & batch, const WallDrawParameters & params) const;
+
+		/// Gets the starting point of the wall.
+		const sf::Vector2f & getFrom() const;
+		/// Gets the ending point of the wall.
+		const sf::Vector2f & getTo() const;
+		/// Gets precomputed geometry of the wall.
+		const WallGeometry & getGeometry() const;
+		/// Gets color and texture of the wall. Texture pointer is valid as long as the wall exists.
+		WallMaterial getMaterial() const;
 		/// Gets width of the wall.
 		float getWidth() const;
 		/// Returns true if the wall faces the ray. Returning false means this wall is not visible by that ray.
@@ -62,7 +93,7 @@ namespace ps {
 	/// Wall that can have portal on itself.
 	class PortalWall : public Wall {
 	private:
-		portalPtr portal;
+		Portal portal;
 
 	public:
 		/// Creates a colored wall.
@@ -77,10 +108,12 @@ namespace ps {
 
 		/// Returns true if this wall has portal on it.
 		bool isPortal() const;
+		/// Gets the portal of this wall.
+		const Portal & getPortal() const;
 		/// Takes object and passes it through portal.
 		void stepThrough(ObjectInScene & obj) const;
 		/// Sets portal for this wall.
-		void setPortal(const portalPtr & portal);
+		void setPortal(const Portal & portal);
 	};
 
 
@@ -33,6 +33,10 @@ namespace ps {
 	template< typename T >
 	inline void rotate(sf::Vector2<T> & vector, T angle);
 
+	/// Rotates 2D vector by angle given by its cosine and sine.
+	template< typename T >
+	inline void rotate(sf::Vector2<T> & vector, T cosAngle, T sinAngle);
+
 	/// Dot product of two 2D vectors.
 	template< typename T>
 	inline T dot(const sf::Vector2<T> & a, const sf::Vector2<T> & b);
@@ -135,11 +139,17 @@ namespace ps {
 
 	template<typename T>
 	void rotate(sf::Vector2<T> & vector, T angle)
+	{
+		rotate(vector, (T)cos(angle), (T)sin(angle));
+	}
+
+	template<typename T>
+	void rotate(sf::Vector2<T> & vector, T cosAngle, T sinAngle)
 	{
 		T x = vector.x;
 		T y = vector.y;
-		vector.x = cos(angle) * x - sin(angle) * y;
-		vector.y = sin(angle) * x + cos(angle) * y;
+		vector.x = cosAngle * x - sinAngle * y;
+		vector.y = sinAngle * x + cosAngle * y;
 	}
 
 	template<typename T>
@@ -2,9 +2,14 @@
 #ifndef PS_RAYCASTER_INCLUDED
 #define PS_RAYCASTER_INCLUDED
 #include <memory>
+#include <vector>
 #include <SFML\Graphics.hpp>
 #include "Scene.hpp"
 #include "ObjectInScene.hpp"
+#include "RenderBatch.hpp"
+#include "FrameBuffer.hpp"
+#include "ThreadPool.hpp"
+#include "RenderStats.hpp"
 
 namespace ps {
 
@@ -27,32 +32,104 @@ namespace ps {
 	// RAY CASTER 
 	//*********************************************************************************
 
-	/// Descries the vertical strip of the screen.
-	struct RenderStripArea {
-		float column;
-		float top;
-		float bottom;
+	/// Projection of the wall hit by a ray onto the screen.
+	struct WallStrip {
+		float distance;				///< Distance of the hit from the ray origin (corrected for fishbowl effect).
+		float wallTopHeight;		///< Height of the wall top relative to the ray origin.
+		float wallBottomHeight;		///< Height of the wall bottom relative to the ray origin.
+		float vpWallTop;			///< Wall top projected onto the view plane.
+		float vpWallBottom;			///< Wall bottom projected onto the view plane.
+		float scrWallTop;			///< Wall top on the screen.
+		float scrWallBottom;		///< Wall bottom on the screen.
+	};
+
+	/// Portal a ray went through while rendering a column. Floor and ceiling in front of the portal are drawn after the segment behind it.
+	struct PortalCrossing {
+		RenderRay ray;				///< Ray before it stepped through the portal.
+		const Segment * segment;	///< Segment the portal is in.
+		WallStrip strip;			///< Projection of the portal.
+	};
+
+	/// Number of ray steps (intersections of a ray with the walls of one segment) that can be done in one tile of a frame.
+	struct RayStepBudget {
+		std::size_t limit;
+		std::size_t used;
+
+		/// Returns true if given number of steps can still be done.
+		bool allows(std::size_t steps) const { return used + steps <= limit; }
 	};
 
 
 	class RayCaster {
-	private:
-		/// limit on recursive renderPart calls
+	public:
+		/// limit on recursive renderPart calls (number of portals a ray can go through)
 		static constexpr int recursionLimit = 20;
 
+	private:
+		/// number of screen columns in one tile, when rendering by multiple threads
+		static constexpr unsigned int tileWidth = 16;
+
 		bool correctFishbowl;				///< Flag indicating if fishbowl effect should be corrected.
-		sf::RenderTarget * renderTarget;	///< Ray-caster stores pointer to RenderTarget, so it doesn't have to be passed so much while rendering.
+		bool spanTraversal;					///< Flag indicating if the segments are traversed by spans of columns instead of by single rays.
+		std::size_t rayStepBudget;			///< Number of ray steps in one frame (0 means no limit).
+		std::size_t rayStepCount;			///< Number of ray steps done in the last frame.
+		sf::Color fogColor;					///< Color of the portals that were not entered, because the ray step budget ran out.
 		const Scene * scene;				///< Ray-caster stores pointer to Scene, so it doesn't have to be passed so much while rendering.
+		RenderBatch batch;					///< Lines of the rendered frame. They are submitted to the render target at the end of render().
+
+		std::unique_ptr<ThreadPool> pool;	///< Threads rendering the tiles (nullptr when rendering by single thread).
+		std::vector<RenderBatch> tiles;		///< Lines of each tile of the frame. Each tile is written only by the thread rendering it.
+		std::vector<std::size_t> tileSteps;	///< Ray steps done in each tile of the frame.
+		std::vector<RenderCounters> tileCounters;	///< Statistics counters of each tile of the frame.
+		RenderStats stats;					///< Statistics of the last frame (only collected with PS_RENDER_STATS defined).
 
 		// render dimensions
 		unsigned int renderWidth;
 		unsigned int renderHeight;
 
-		RenderRay generateRay(int i);
-		void renderStip(const RenderStripArea & renderStrip, const RenderRay & ray, int recursionDepth);
-
-		float distanceToViewPlane(float distance, float height);
-		float viewPlaneToScreen(float x);
+		/// Casts rays for all the columns of the image. Lines are collected into the batch (single thread), or into the tiles (multiple threads).
+		void castFrame(unsigned int width, unsigned int height, const Scene & scene_);
+		/// Makes the ray step budget of the tile of columns [columnFrom, columnTo). Budget of the frame is split among the tiles by their
+		/// width, so the frame looks the same for any number of threads. Every column can do at least one step.
+		RayStepBudget makeTileBudget(unsigned int columnFrom, unsigned int columnTo) const;
+		/// Casts rays for the columns [columnFrom, columnTo) collecting the lines into output batch. Returns the number of ray steps done.
+		std::size_t castColumns(unsigned int columnFrom, unsigned int columnTo, RenderBatch & output, RenderCounters & counters) const;
+		RenderRay generateRay(int i) const;
+		/// Renders one column of the screen. Ray that hit the wall of its segment follows the portals (up to recursionLimit of them) until
+		/// it hits a solid wall, then the floors and ceilings are drawn back towards the camera. Crossings is the stack of passed portals.
+		void renderColumn(float column, RenderRay ray, WallHit hit, std::vector<PortalCrossing> & crossings, RayStepBudget & budget, RenderBatch & output,
+			RenderCounters & counters) const;
+		/// Projects the wall the ray hit onto the screen.
+		WallStrip projectHit(const RenderRay & ray, const Segment & segment, const WallHit & hit) const;
+		/// Draws the line of the (non-portal) wall in given column. Wall is given by its id in LevelWalls of the scene.
+		void drawWall(float column, std::uint32_t wall, const WallHit & hit, const WallStrip & strip, RenderBatch & output) const;
+		/// Draws the lines of the floor and ceiling between the ray's render distance and the wall it hit.
+		void drawFloorCeiling(float column, const RenderRay & ray, const Segment & segment, const WallStrip & strip, RenderBatch & output,
+			RenderCounters & counters) const;
+		/// Fills the portal strip with fog color (the portal is not entered).
+		void drawFog(float column, const WallStrip & strip, RenderBatch & output) const;
+
+		/// Span of columns on the stack of renderSpan() (defined in RayCaster.cpp).
+		struct SpanFrame;
+		/// Rays and hits of the columns rendered by castSpans() (defined in RayCaster.cpp).
+		struct SpanWindow;
+		/// Renders the columns [columnFrom, columnTo) by visiting the segments front to back. Each segment is entered once per span of
+		/// neighbouring columns that see it through the same portal, instead of once per column. Returns the number of ray steps done.
+		std::size_t castSpans(unsigned int columnFrom, unsigned int columnTo, RenderBatch & output, RenderCounters & counters) const;
+		/// Renders the span of columns [spanFrom, spanTo), whose rays are all in the same segment. Direction and viewPlane are the camera frame,
+		/// they are used to find the columns each wall can be seen in. Spans behind the portals (up to recursionLimit of them) are kept on
+		/// explicit stack of the window.
+		void renderSpan(SpanWindow & window, unsigned int spanFrom, unsigned int spanTo, sf::Vector2f direction, sf::Vector2f viewPlane,
+			RayStepBudget & budget, RenderBatch & output, RenderCounters & counters) const;
+		/// Finds the segment and the origin of the rays of the span, and the walls the rays hit in the segment.
+		void intersectSpan(SpanWindow & window, SpanFrame & frame, RenderCounters & counters) const;
+		/// Finds the columns [wallFrom, wallTo) of the span [spanFrom, spanTo) the line segment from - to can be seen in from the origin. The range
+		/// is conservative, columns on its edges are expected to be tested by rays.
+		void projectWall(sf::Vector2f origin, sf::Vector2f from, sf::Vector2f to, sf::Vector2f direction, sf::Vector2f viewPlane,
+			unsigned int spanFrom, unsigned int spanTo, unsigned int & wallFrom, unsigned int & wallTo) const;
+
+		float distanceToViewPlane(float distance, float height) const;
+		float viewPlaneToScreen(float x) const;
 
 	public:
 		/// Constructs a ray-caster.
@@ -60,8 +137,35 @@ namespace ps {
 
 		/// Turns fishbowl correction on/off.
 		void setFishbowlCorrection(bool value);
-		/// Renders the scene from the camera's point of view.
+		/// Sets number of threads used for rendering. Screen is split into tiles of columns, which are rendered in parallel. The result
+		/// is the same as when rendering by single thread.
+		void setThreadCount(unsigned int threadCount);
+		/// Gets number of threads used for rendering.
+		unsigned int getThreadCount() const;
+		/// Turns span traversal on/off. Spans of columns are rendered by visiting each segment once per portal they see it through. The
+		/// picture is the same as when casting ray per column.
+		void setSpanTraversal(bool value);
+		/// Returns true if span traversal is on.
+		bool getSpanTraversal() const;
+		/// Sets the number of ray steps (intersections of a ray with the walls of one segment) in one frame, 0 means no limit. Portals
+		/// that would exceed the budget are not entered, they are filled with fog color instead. This bounds the frame time, when the rays
+		/// go through many portals (e.g. portal loops).
+		void setRayStepBudget(std::size_t steps);
+		/// Gets the number of ray steps in one frame (0 means no limit).
+		std::size_t getRayStepBudget() const;
+		/// Gets the number of ray steps done in the last rendered frame.
+		std::size_t getRayStepCount() const;
+		/// Sets the color of the portals, that were not entered because the ray step budget ran out.
+		void setFogColor(sf::Color color);
+		/// Gets the statistics of the last rendered frame. They are collected only when PS_RENDER_STATS is defined, otherwise they are zero.
+		const RenderStats & getStats() const;
+		/// Renders the scene from the camera's point of view. All the strips of the frame are collected first, and then drawn by a few draw calls.
 		void render(sf::RenderTarget & rt, const Scene & scene);
+		/// Renders the scene into the top-left width x height pixels of the render target (the render target keeps its default view).
+		/// This lets the frame be rendered in lower resolution into a render texture, that is not recreated when the resolution changes.
+		void render(sf::RenderTarget & rt, unsigned int width, unsigned int height, const Scene & scene);
+		/// Renders the scene from the camera's point of view into CPU-side frame buffer. No draw calls are issued.
+		void render(FrameBuffer & fb, const Scene & scene);
 
 		friend class Game;
 	};
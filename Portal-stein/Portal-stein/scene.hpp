@@ -5,9 +5,13 @@
 #include <memory>
 #include <string>
 #include <exception>
+#include <chrono>
 #include <SFML\Graphics.hpp>
 #include "FloorCeiling.hpp"
 #include "Wall.hpp"
+#include "Intersect.hpp"
+#include "LevelWalls.hpp"
+#include "SegmentIndex.hpp"
 #include "ObjectInScene.hpp"
 
 namespace ps {
@@ -65,12 +69,50 @@ namespace ps {
 
 
 
+	//********************************************************************
+	// LEVEL GEOMETRY CLASS
+	//********************************************************************
+
+	/// Segments of a level. The geometry does not change while the level is played, so all the scenes of the level share one instance of it
+	/// (starting the level does not copy the segments, and other threads can read them while the level is played). Renderer and collisions
+	/// read the walls from LevelWalls, where the walls of all the segments are stored in flat arrays. Segments containing a point are found
+	/// by SegmentIndex, that is built with the geometry.
+	class LevelGeometry {
+	private:
+		std::vector<Segment> segments;
+		LevelWalls walls;		///< Walls of the segments. Wall i of segment s has id (walls.getSegmentWalls(s).first + i).
+		SegmentIndex index;		///< Index of the segments in walls.
+
+	public:
+		/// Creates geometry from the segments. Ids of the segments are their indices.
+		explicit LevelGeometry(std::vector<Segment> && segments_);
+
+		/// Gets segment by its id. If no such segment exists SegmentNotFound is thrown.
+		/// \sa SegmentNotFound
+		const Segment& getSegment(std::size_t segmentId) const;
+		/// Gets number of segments (ids of the segments are 0 .. count - 1).
+		std::size_t getSegmentCount() const;
+		/// Gets the walls of all the segments in the layout read by renderer and collisions.
+		const LevelWalls & getWalls() const;
+		/// Returns true if the point lies in the segment.
+		bool isInSegment(std::size_t segmentId, sf::Vector2f point) const;
+		/// Gets ids of all the segments, that contain the point (in increasing order). Portals let segments overlap, so there can be more
+		/// of them.
+		std::vector<std::size_t> findSegments(sf::Vector2f point) const;
+		/// Finds the portal of the segment, behind which the point lies, when the point is known to be slightly out of the segment (e.g. the
+		/// position of an object drifted out of its segment due to rounding errors). Only the segments behind the portals of the segment are
+		/// searched, the point is transformed into their space by the portals. Returns nullptr if the segment contains the point, or if none
+		/// of the neighbours contains it.
+		/// \param segmentId Id of the segment close to the point (it does not have to exist).
+		const Portal * findNeighbourPortal(sf::Vector2f point, std::size_t segmentId) const;
+	};
+
+
+
 	//*******************************************************************
 	// FLOATING OBJECT IN SCENE
 	//*******************************************************************
 
-	class Scene;
-
 	/// Object in scene, that is aware of the scene (meaning it will not pass through walls), and it can be manipulated by applying force on it.
 	/// User must first apply all forces to this object, and the call simulate() to update object speed and angular speed.
 	class FloatingObjInScene : public ObjectInScene {
@@ -82,15 +124,19 @@ namespace ps {
 		float angularSpeed;
 
 		float mass;
-		Scene * scene;
+		const LevelGeometry * geometry;		///< Geometry the object collides with. It is only read, so other threads can read it too.
+
+		Portal crossedPortal;		///< Portal the object stepped through during the last simulate() call (Type::NONE if it did not).
+		float crossingFraction;		///< Fraction of the last movement done before the object stepped through crossedPortal.
 
 	public:
 		/// Creates a new floating object in scene.
 		/// \param mass_ Mass of the object (in kg).
-		/// \param scene_ Scene the object is in.
-		FloatingObjInScene(const ObjectInScene & obj, float mass_, Scene & scene_);
+		/// \param geometry_ Geometry of the level the object is in.
+		FloatingObjInScene(const ObjectInScene & obj, float mass_, const LevelGeometry & geometry_);
 
-		virtual void rotate(float angle) override;
+		using ObjectInScene::rotate;
+		virtual void rotate(float cosAngle, float sinAngle) override;
 		virtual void move(sf::Vector3f offset) override;
 
 		/// Applies force on the object.
@@ -104,8 +150,16 @@ namespace ps {
 		sf::Vector3f getSpeed() const;
 		/// Gets angular speed of the object (in rad/s).
 		float getAngularSpeed() const;
-
-		friend class Scene;
+		/// Gets the portal the object stepped through during the last simulate() call (Type::NONE if it did not step through any). When the
+		/// object was also moved through a portal by recoverSegment(), the portal leads through both of them.
+		const Portal & getCrossedPortal() const;
+		/// Gets the fraction (0 .. 1) of the movement during the last simulate() call, that was done before the object stepped through
+		/// the crossed portal.
+		float getCrossingFraction() const;
+		/// Moves the object through the portal of its segment, behind which its position lies, if its position is not in its segment
+		/// (rounding errors of the simulation can move the object slightly out of its segment). The object stays in its segment, if none of
+		/// the neighbours contains it. Returns true if the segment of the object was changed.
+		bool recoverSegment();
 	};
 
 
@@ -126,10 +180,13 @@ namespace ps {
 	public:
 		Camera(const FloatingObjInScene & obj);
 
-		/// Rotates camera by desired angle (counterclockwise).
-		virtual void rotate(float angle) override;
+		using FloatingObjInScene::rotate;
+		/// Rotates camera by angle given by its cosine and sine (counterclockwise).
+		virtual void rotate(float cosAngle, float sinAngle) override;
 		/// Sets horizontal and vertical field-of-view from horizontal FOV and aspect ratio (width : height).
 		void setFOV(float horizontalFOV, float aspectRatio);
+		/// Places the camera to the position, direction and segment of the pose. Speed and applied forces are not changed.
+		void setPose(const ObjectInScene & pose);
 
 		/// Camera is part of ray-caster. This lets RayCaster fully access Camera's private members.
 		friend class RayCaster;
@@ -141,28 +198,52 @@ namespace ps {
 	// SCENE CLASS
 	//********************************************************************
 	
-	/// Scene is a collection of segments + camera. Scene can be rendered with RayCaster.
+	/// Scene is the state of one session of a level (the camera), on top of the geometry shared by all the sessions. Copying the scene does
+	/// not copy the geometry. Scene can be rendered with RayCaster.
 	class Scene {
 	private:
-		std::vector<Segment> segments;
+		std::shared_ptr<const LevelGeometry> geometry;
 
 	public:
 		Camera camera;
 
-		Scene(const ObjectInScene & camera_);
-		Scene(const Scene & rhs);
-		Scene & operator=(const Scene & rhs);
+		/// Creates scene with camera placed in the geometry.
+		Scene(std::shared_ptr<const LevelGeometry> geometry_, const ObjectInScene & camera_);
 
-		/// Adds a new segment. Its unique id is returned.
-		std::size_t addSegment(Segment && segment_);
-		/// Gets segment by its id. If no such segment exists SegmentNotFound is thrown.
-		/// \sa SegmentNotFound
-		Segment& getSegment(std::size_t segmentId);
+		/// Gets the geometry of the level.
+		const LevelGeometry & getGeometry() const;
 		/// Gets segment by its id. If no such segment exists SegmentNotFound is thrown.
 		/// \sa SegmentNotFound
 		const Segment& getSegment(std::size_t segmentId) const;
+		/// Gets number of segments (ids of the segments are 0 .. count - 1).
+		std::size_t getSegmentCount() const;
+	};
+
+
+
+
+	//********************************************************************
+	// CAMERA SNAPSHOT
+	//********************************************************************
 
-		friend class Level;
+	/// Result of one simulation step of the camera. Simulation thread hands it over to the render thread, which renders from a pose
+	/// interpolated between the poses before and after the step.
+	struct CameraSnapshot {
+		ObjectInScene previous;		///< Pose before the step.
+		ObjectInScene current;		///< Pose after the step.
+		Portal crossedPortal;		///< Portal the camera stepped through during the step (Type::NONE if it did not).
+		float crossingFraction;		///< Fraction of the movement during the step done before stepping through crossedPortal.
+		std::chrono::steady_clock::time_point time;	///< Time the pose after the step belongs to.
+
+		/// Creates snapshot of the object that did not move.
+		CameraSnapshot(const ObjectInScene & pose, std::chrono::steady_clock::time_point time_);
+		/// Creates snapshot of the object after its last simulate() call.
+		CameraSnapshot(const ObjectInScene & previous_, const FloatingObjInScene & current_, std::chrono::steady_clock::time_point time_);
+
+		/// Gets the pose between the pose before the step (alpha = 0) and the pose after it (alpha = 1). Position and direction are
+		/// interpolated linearly. If the camera stepped through a portal during the step, the interpolated pose goes through the portal
+		/// as well (it is in the previous segment before the crossing and in the current one after it).
+		ObjectInScene interpolate(float alpha) const;
 	};
 
 
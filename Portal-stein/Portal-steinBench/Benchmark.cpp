@@ -0,0 +1,390 @@
+#include "Benchmark.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iterator>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include "..\Portal-stein\Math.hpp"
+#include "..\Portal-stein\Lexer.hpp"
+#include "StreamLexer.hpp"
+
+namespace ps {
+
+	FlyThrough::FlyThrough(float timeStep_) : timeStep(timeStep_), targetSegment(0), targetWall(-1), targetTime(0.0f), visits(), portalCrossings(0)
+	{
+		targetTimeout = 8.0f;
+
+		walkForce = 200.0f;
+		rotateTorque = 100.0f;
+
+		walkDragCoefficient1 = 70.0f;
+		walkDragCoefficient2 = 10.0f;
+		rotateDragCoefficient = 100.0f;
+	}
+
+	void FlyThrough::pickTarget(const Scene & scene)
+	{
+		targetSegment = scene.camera.getSegmentId();
+		targetWall = -1;
+		targetTime = 0.0f;
+
+		auto & walls = scene.getSegment(targetSegment).getWalls();
+		sf::Vector2f position = toVector2(scene.camera.getPosition());
+
+		std::vector<int> portals;
+		int closest = -1;
+		for (std::size_t i = 0; i < walls.size(); ++i) {
+			if (!walls[i].isPortal())
+				continue;
+
+			portals.push_back((int)i);
+			if (closest < 0 || walls[i].distanceFromWall(position) < walls[closest].distanceFromWall(position))
+				closest = (int)i;
+		}
+
+		if (portals.size() > 1)
+			portals.erase(std::find(portals.begin(), portals.end(), closest));
+
+		if (!portals.empty())
+			targetWall = portals[visits[targetSegment]++ % portals.size()];
+	}
+
+	void FlyThrough::step(Scene & scene)
+	{
+		Camera & camera = scene.camera;
+		if (targetWall < 0 || targetSegment != camera.getSegmentId() || targetTime > targetTimeout)
+			pickTarget(scene);
+
+		// camera just looks around in segment without portals
+		float walk = 0.0f;
+		float rotate = 1.0f;
+
+		if (targetWall >= 0) {
+			const PortalWall & wall = scene.getSegment(targetSegment).getWalls()[targetWall];
+			sf::Vector2f toTarget = 0.5f * (wall.getFrom() + wall.getTo()) - toVector2(camera.getPosition());
+			sf::Vector2f direction = camera.getDirection();
+			float angle = std::atan2(cross(direction, toTarget), dot(direction, toTarget));
+
+			// turn towards the middle of the portal, and walk only when it is ahead
+			rotate = getMax(getMin(2.0f * angle, 1.0f), -1.0f);
+			walk = getMax(std::cos(angle), 0.0f);
+		}
+
+		camera.applyForce(walk * walkForce * toVector3(camera.getDirection()));
+		camera.applyTorque(rotate * rotateTorque);
+
+		// drag is the same as in Game::simulateDrag
+		auto speed = camera.getSpeed();
+		camera.applyForce(-1.0f * walkDragCoefficient1 * speed - walkDragCoefficient2 * norm(speed) * speed);
+		camera.applyTorque(-1.0f * rotateDragCoefficient * camera.getAngularSpeed());
+
+		camera.simulate(timeStep);
+		targetTime += timeStep;
+
+		if (camera.getCrossedPortal().isPortal()) {
+			portalCrossings++;
+			targetWall = -1;
+		}
+	}
+
+	std::size_t FlyThrough::getPortalCrossings() const
+	{
+		return portalCrossings;
+	}
+
+	double percentile(const std::vector<double> & sortedSamples, double p)
+	{
+		if (sortedSamples.empty())
+			return 0.0;
+
+		std::size_t rank = (std::size_t)std::ceil(p * sortedSamples.size());
+		return sortedSamples[getMax<std::size_t>(rank, 1) - 1];
+	}
+
+	LevelResult summarize(const std::string & name, double loadMs, std::vector<double> frameMs, const std::vector<std::size_t> & raySteps,
+		std::size_t portalCrossings)
+	{
+		std::sort(frameMs.begin(), frameMs.end());
+
+		double totalMs = 0.0;
+		for (double ms : frameMs)
+			totalMs += ms;
+
+		LevelResult result;
+		result.name = name;
+		result.loadMs = loadMs;
+		result.textureKiB = 0;
+		result.frames = frameMs.size();
+		result.portalCrossings = portalCrossings;
+		result.p50Ms = percentile(frameMs, 0.50);
+		result.p95Ms = percentile(frameMs, 0.95);
+		result.p99Ms = percentile(frameMs, 0.99);
+		result.maxMs = (frameMs.empty()) ? 0.0 : frameMs.back();
+		result.fps = (totalMs > 0.0) ? 1000.0 * frameMs.size() / totalMs : 0.0;
+
+		double totalSteps = 0.0;
+		result.maxRaySteps = 0;
+		for (std::size_t steps : raySteps) {
+			totalSteps += steps;
+			result.maxRaySteps = getMax(result.maxRaySteps, steps);
+		}
+		result.meanRaySteps = (raySteps.empty()) ? 0.0 : totalSteps / raySteps.size();
+		return result;
+	}
+
+	// Returns string as JSON string literal.
+	std::string jsonString(const std::string & value) {
+		std::string result = "\"";
+		for (char c : value) {
+			if (c == '"' || c == '\\')
+				result += '\\';
+			result += c;
+		}
+		return result + "\"";
+	}
+
+	void writeReport(std::ostream & output, const BenchmarkConfig & config, const std::vector<LevelResult> & results,
+		const std::vector<std::string> & regressions)
+	{
+		output << std::fixed << std::setprecision(3);
+		output << "{\n";
+		output << "\t\"backend\": " << jsonString(config.software ? "software" : "gpu") << ",\n";
+		output << "\t\"width\": " << config.width << ",\n";
+		output << "\t\"height\": " << config.height << ",\n";
+		output << "\t\"threads\": " << config.threads << ",\n";
+		output << "\t\"traversal\": " << jsonString(config.spans ? "spans" : "columns") << ",\n";
+		output << "\t\"rayStepBudget\": " << config.rayStepBudget << ",\n";
+		output << "\t\"frames\": " << config.frames << ",\n";
+		output << "\t\"levels\": [\n";
+
+		for (std::size_t i = 0; i < results.size(); ++i) {
+			const LevelResult & r = results[i];
+			output << "\t\t{ \"name\": " << jsonString(r.name) <<
+				", \"loadMs\": " << r.loadMs <<
+				", \"textureKiB\": " << r.textureKiB <<
+				", \"frames\": " << r.frames <<
+				", \"portalCrossings\": " << r.portalCrossings <<
+				", \"fps\": " << r.fps <<
+				", \"p50Ms\": " << r.p50Ms <<
+				", \"p95Ms\": " << r.p95Ms <<
+				", \"p99Ms\": " << r.p99Ms <<
+				", \"maxMs\": " << r.maxMs <<
+				", \"meanRaySteps\": " << r.meanRaySteps <<
+				", \"maxRaySteps\": " << r.maxRaySteps << " }" << ((i + 1 < results.size()) ? "," : "") << "\n";
+		}
+
+		output << "\t],\n";
+		output << "\t\"regressions\": [";
+		for (std::size_t i = 0; i < regressions.size(); ++i)
+			output << ((i == 0) ? "\n" : ",\n") << "\t\t" << jsonString(regressions[i]);
+		output << ((regressions.empty()) ? "]\n" : "\n\t]\n");
+		output << "}\n";
+	}
+
+	Baseline readBaseline(std::istream & input)
+	{
+		std::string text{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+
+		// level objects are the only objects without nested objects in the report
+		std::regex objectRegex{ R"re(\{[^{}]*\})re" };
+		std::regex nameRegex{ R"re("name"\s*:\s*"([^"]*)")re" };
+		std::regex numberRegex{ R"re("(\w+)"\s*:\s*(-?[0-9][0-9.eE+-]*))re" };
+
+		Baseline baseline;
+		for (std::sregex_iterator object{ text.begin(), text.end(), objectRegex }, end; object != end; ++object) {
+			std::string objectText = object->str();
+
+			std::smatch name;
+			if (!std::regex_search(objectText, name, nameRegex))
+				continue;
+
+			auto & values = baseline[name[1].str()];
+			for (std::sregex_iterator number{ objectText.begin(), objectText.end(), numberRegex }; number != end; ++number)
+				values[(*number)[1].str()] = std::stod((*number)[2].str());
+		}
+
+		return baseline;
+	}
+
+	std::vector<std::string> findRegressions(const std::vector<LevelResult> & results, const Baseline & baseline, double tolerance)
+	{
+		std::vector<std::string> regressions;
+
+		for (const LevelResult & r : results) {
+			auto level = baseline.find(r.name);
+			if (level == baseline.end())
+				continue;	// level is new, there is nothing to compare with
+
+			// median and tail frame times are compared, maximum is too noisy to be useful
+			std::pair<const char *, double> measured[] = { { "p50Ms", r.p50Ms }, { "p95Ms", r.p95Ms }, { "p99Ms", r.p99Ms } };
+			for (auto & value : measured) {
+				auto stored = level->second.find(value.first);
+				if (stored == level->second.end())
+					continue;
+
+				if (value.second > stored->second * (1.0 + tolerance)) {
+					std::ostringstream description;
+					description << std::fixed << std::setprecision(3) << r.name << ": " << value.first << " " << value.second <<
+						" ms, baseline " << stored->second << " ms";
+					regressions.push_back(description.str());
+				}
+			}
+		}
+
+		return regressions;
+	}
+
+	// Wall queries as they were computed before walls cached their geometry.
+	float widthRecomputed(const Wall & wall) {
+		return norm(wall.getTo() - wall.getFrom());
+	}
+
+	bool facesRayRecomputed(const Wall & wall, const Ray & ray) {
+		return 0 < cross(wall.getTo() - wall.getFrom(), ray.getDirection());
+	}
+
+	float distanceFromWallRecomputed(const Wall & wall, const sf::Vector2f & point) {
+		sf::Vector2f r = wall.getTo() - wall.getFrom();
+		float rDotR = dot(r, r);
+		sf::Vector2f normal(r.y, -r.x);
+
+		sf::Vector2f x = point - wall.getFrom();
+		float rDot = dot(r, x);
+		if (rDot < 0)
+			return norm(x);
+		else if (rDot > rDotR)
+			return norm(x - r);
+		else
+			return (1 / norm(normal)) * dot(normal, x);
+	}
+
+	// Sum of the results of the measured queries is written here, so the compiler cannot remove the queries.
+	static volatile float querySink = 0.0f;
+
+	// Returns average time of one call of the query (in nanoseconds). Query is called for each wall and each sample.
+	template< typename Query >
+	double measureQuery(const std::vector<const Wall *> & walls, const std::vector<Ray> & samples, std::size_t repetitions, Query query) {
+		float sum = 0.0f;
+
+		auto start = std::chrono::steady_clock::now();
+		for (std::size_t r = 0; r < repetitions; ++r) {
+			for (const Wall * wall : walls) {
+				for (const Ray & sample : samples)
+					sum += query(*wall, sample);
+			}
+		}
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		querySink = querySink + sum;
+
+		double calls = (double)repetitions * walls.size() * samples.size();
+		return (calls > 0) ? std::chrono::duration<double, std::nano>(elapsed).count() / calls : 0.0;
+	}
+
+	std::vector<MicroResult> benchmarkWallGeometry(const Scene & scene, std::size_t repetitions)
+	{
+		std::vector<const Wall *> walls;
+		sf::Vector2f low{ 0.0f, 0.0f };
+		sf::Vector2f high{ 0.0f, 0.0f };
+		for (std::size_t i = 0; i < scene.getSegmentCount(); ++i) {
+			for (auto & wall : scene.getSegment(i).getWalls()) {
+				if (walls.empty())
+					low = high = wall.getFrom();
+
+				walls.push_back(&wall);
+				low = sf::Vector2f{ getMin(low.x, wall.getFrom().x), getMin(low.y, wall.getFrom().y) };
+				high = sf::Vector2f{ getMax(high.x, wall.getFrom().x), getMax(high.y, wall.getFrom().y) };
+			}
+		}
+
+		// sample rays are spread over the bounding box of the level (fixed seed, so every run measures the same queries)
+		std::mt19937 generator{ 12345 };
+		std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+		std::vector<Ray> samples;
+		for (int i = 0; i < 64; ++i) {
+			sf::Vector3f position{ low.x + unit(generator) * (high.x - low.x), low.y + unit(generator) * (high.y - low.y), 0.5f };
+			float angle = 2.0f * PI<float> * unit(generator);
+			samples.push_back(Ray{ position, sf::Vector2f{ std::cos(angle), std::sin(angle) }, 0 });
+		}
+
+		std::vector<MicroResult> results;
+		results.push_back(MicroResult{ "getWidth",
+			measureQuery(walls, samples, repetitions, [](const Wall & w, const Ray &) { return widthRecomputed(w); }),
+			measureQuery(walls, samples, repetitions, [](const Wall & w, const Ray &) { return w.getWidth(); }) });
+		results.push_back(MicroResult{ "facesRay",
+			measureQuery(walls, samples, repetitions, [](const Wall & w, const Ray & r) { return facesRayRecomputed(w, r) ? 1.0f : 0.0f; }),
+			measureQuery(walls, samples, repetitions, [](const Wall & w, const Ray & r) { return w.facesRay(r) ? 1.0f : 0.0f; }) });
+		results.push_back(MicroResult{ "distanceFromWall",
+			measureQuery(walls, samples, repetitions, [](const Wall & w, const Ray & r) { return distanceFromWallRecomputed(w, toVector2(r.getPosition())); }),
+			measureQuery(walls, samples, repetitions, [](const Wall & w, const Ray & r) { return w.distanceFromWall(toVector2(r.getPosition())); }) });
+		return results;
+	}
+
+	void writeMicroReport(std::ostream & output, const std::string & levelName, const std::vector<MicroResult> & results)
+	{
+		output << std::fixed << std::setprecision(3);
+		output << "{ \"name\": " << jsonString(levelName) << ", \"wallGeometry\": [\n";
+		for (std::size_t i = 0; i < results.size(); ++i) {
+			const MicroResult & r = results[i];
+			output << "\t{ \"query\": " << jsonString(r.name) <<
+				", \"recomputedNs\": " << r.recomputedNs <<
+				", \"cachedNs\": " << r.cachedNs <<
+				", \"speedup\": " << ((r.cachedNs > 0.0) ? r.recomputedNs / r.cachedNs : 0.0) << " }" << ((i + 1 < results.size()) ? "," : "") << "\n";
+		}
+		output << "] }";
+	}
+
+	// Throughput in MB/s (10^6 bytes per second) of reading given number of bytes in given time.
+	double megabytesPerSecond(std::size_t bytes, std::chrono::steady_clock::duration elapsed) {
+		double seconds = std::chrono::duration<double>(elapsed).count();
+		return (seconds > 0.0) ? bytes / 1e6 / seconds : 0.0;
+	}
+
+	LexerResult benchmarkLexers(const std::string & input, std::size_t repetitions)
+	{
+		using namespace std::chrono;
+
+		// streams are filled before the measurement, only reading of the tokens is measured
+		std::vector<std::istringstream> streams;
+		for (std::size_t i = 0; i < repetitions; ++i)
+			streams.emplace_back(input);
+
+		std::size_t streamTokens = 0;
+		auto streamStart = steady_clock::now();
+		for (auto & stream : streams) {
+			StreamLexer lexer{ stream };
+			while (lexer.getNextToken().type != TokenType::END_OF_STREAM)
+				streamTokens++;
+		}
+		auto streamElapsed = steady_clock::now() - streamStart;
+
+		std::size_t bufferTokens = 0;
+		auto bufferStart = steady_clock::now();
+		for (std::size_t i = 0; i < repetitions; ++i) {
+			// the first token is read by the constructor already
+			Lexer lexer{ input.data(), input.size() };
+			for (TokenType type = lexer.getLookahead().type; type != TokenType::END_OF_STREAM; type = lexer.getNextToken().type)
+				bufferTokens++;
+		}
+		auto bufferElapsed = steady_clock::now() - bufferStart;
+
+		if (streamTokens != bufferTokens)
+			throw std::runtime_error("Lexers read different number of tokens!");
+
+		std::size_t bytes = input.size() * repetitions;
+		return LexerResult{ bytes, bufferTokens, megabytesPerSecond(bytes, streamElapsed), megabytesPerSecond(bytes, bufferElapsed) };
+	}
+
+	void writeLexerReport(std::ostream & output, const LexerResult & result)
+	{
+		output << std::fixed << std::setprecision(3);
+		output << "{ \"bytes\": " << result.bytes <<
+			", \"tokens\": " << result.tokens <<
+			", \"streamMBps\": " << result.streamMBps <<
+			", \"bufferMBps\": " << result.bufferMBps <<
+			", \"speedup\": " << ((result.streamMBps > 0.0) ? result.bufferMBps / result.streamMBps : 0.0) << " }\n";
+	}
+}
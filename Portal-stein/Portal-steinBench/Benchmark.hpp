@@ -0,0 +1,138 @@
+#pragma once
+#ifndef PS_BENCHMARK_INCLUDED
+#define PS_BENCHMARK_INCLUDED
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include "..\Portal-stein\Scene.hpp"
+
+namespace ps {
+
+	//**************************************************************************
+	// FLY-THROUGH
+	//**************************************************************************
+
+	/// Deterministic camera path through a level. Camera is steered by the same forces the player applies by keyboard: it turns towards
+	/// a portal of its segment and walks through it, then it picks a portal of the next segment, and so on. Portals of each segment are
+	/// taken in turns (the one the camera came from is skipped), so the camera tours the whole level. Camera is simulated with fixed
+	/// time step and moved by FloatingObjInScene::move, so every run of the benchmark sees exactly the same frames.
+	class FlyThrough {
+	private:
+		float timeStep;
+		std::size_t targetSegment;			///< Segment the target wall was picked in.
+		int targetWall;						///< Index of the portal wall the camera goes to (-1 if the segment has no portal).
+		float targetTime;					///< Time spent going to the target wall.
+		std::map<std::size_t, std::size_t> visits;	///< Number of targets picked in each segment.
+		std::size_t portalCrossings;
+
+		/// Picks the next portal wall of camera's segment. Wall that is the closest to the camera is skipped if possible, it is either
+		/// the portal the camera just came through, or the target the camera did not manage to reach.
+		void pickTarget(const Scene & scene);
+
+	public:
+		/// Camera gives up the target, if it does not get through it in this time (in seconds).
+		float targetTimeout;
+
+		// same constants the Game uses for the player
+		float walkForce;
+		float rotateTorque;
+		float walkDragCoefficient1;
+		float walkDragCoefficient2;
+		float rotateDragCoefficient;
+
+		/// Creates fly-through that is simulated with given time step (in seconds).
+		FlyThrough(float timeStep_);
+
+		/// Simulates one time step of the flight.
+		void step(Scene & scene);
+		/// Gets number of times the camera went through a portal (or door).
+		std::size_t getPortalCrossings() const;
+	};
+
+
+
+	//**************************************************************************
+	// RESULTS
+	//**************************************************************************
+
+	/// Benchmark settings, that are written to the report along with the results.
+	struct BenchmarkConfig {
+		unsigned int width;
+		unsigned int height;
+		unsigned int frames;		///< Number of frames rendered in each level.
+		unsigned int threads;
+		bool software;				///< If set, frames are rasterized into FrameBuffer instead of GPU render target.
+		bool spans;					///< If set, ray caster uses span traversal.
+		std::size_t rayStepBudget;	///< Ray steps in one frame (0 means no limit).
+		double tolerance;			///< Relative slowdown against the baseline, that is still not considered a regression.
+	};
+
+	/// Measurements of one level.
+	struct LevelResult {
+		std::string name;
+		double loadMs;				///< Time spent by LevelLoader (including the upload of the textures).
+		std::size_t textureKiB;		///< Memory taken by the textures of the level.
+		std::size_t frames;
+		std::size_t portalCrossings;
+		double p50Ms;
+		double p95Ms;
+		double p99Ms;
+		double maxMs;
+		double fps;					///< Rendered frames per second of render time.
+		double meanRaySteps;		///< Average number of ray steps in one frame.
+		std::size_t maxRaySteps;	///< Maximum number of ray steps in one frame.
+	};
+
+	/// Values of the baseline report: level name -> (value name -> value).
+	using Baseline = std::map<std::string, std::map<std::string, double>>;
+
+	/// Returns percentile p (in [0, 1]) of sorted samples, using nearest-rank method.
+	double percentile(const std::vector<double> & sortedSamples, double p);
+	/// Makes result of the level from its load time, frame times (in milliseconds) and ray steps of the frames.
+	LevelResult summarize(const std::string & name, double loadMs, std::vector<double> frameMs, const std::vector<std::size_t> & raySteps,
+		std::size_t portalCrossings);
+
+	/// Writes the report in JSON format.
+	void writeReport(std::ostream & output, const BenchmarkConfig & config, const std::vector<LevelResult> & results,
+		const std::vector<std::string> & regressions);
+	/// Reads values of the levels from report written by writeReport(). Only the numbers of the level objects are read.
+	Baseline readBaseline(std::istream & input);
+	/// Compares results with the baseline. Returns description of each value that got slower by more than tolerance.
+	std::vector<std::string> findRegressions(const std::vector<LevelResult> & results, const Baseline & baseline, double tolerance);
+
+
+
+	//**************************************************************************
+	// MICROBENCHMARKS
+	//**************************************************************************
+
+	/// Time of one wall query, when the geometry of the wall is recomputed on every call and when the cached WallGeometry is used.
+	struct MicroResult {
+		std::string name;
+		double recomputedNs;		///< Average time of one call (in nanoseconds) computing the geometry from the end points.
+		double cachedNs;			///< Average time of one call (in nanoseconds) using Wall::getGeometry().
+	};
+
+	/// Measures the wall queries of the hot path (width of the wall, facing test and distance from the wall) on all walls of the scene.
+	/// Each query is called for every wall and every sample point repeated given number of times.
+	std::vector<MicroResult> benchmarkWallGeometry(const Scene & scene, std::size_t repetitions);
+	/// Writes the microbenchmark results in JSON format.
+	void writeMicroReport(std::ostream & output, const std::string & levelName, const std::vector<MicroResult> & results);
+
+	/// Throughput of the lexer reading the whole input from buffer and of the StreamLexer reading it from stream.
+	struct LexerResult {
+		std::size_t bytes;			///< Size of the input (in bytes) read by each lexer.
+		std::size_t tokens;			///< Number of tokens in the input.
+		double streamMBps;			///< Throughput of StreamLexer (in MB/s).
+		double bufferMBps;			///< Throughput of Lexer (in MB/s).
+	};
+
+	/// Reads all tokens of the input by both lexers, the input is read given number of times. Throws std::runtime_error if the lexers
+	/// do not find the same number of tokens.
+	LexerResult benchmarkLexers(const std::string & input, std::size_t repetitions);
+	/// Writes the lexer benchmark result in JSON format.
+	void writeLexerReport(std::ostream & output, const LexerResult & result);
+}
+
+#endif // !PS_BENCHMARK_INCLUDED
@@ -0,0 +1,162 @@
+#include "StreamLexer.hpp"
+
+namespace ps {
+
+	inline bool isStreamWhite(char c) {
+		return (c == '\n' || c == ' ' || c == '\t' || c == '\r' || c == '\v');
+	}
+
+	inline bool isStreamAlpha(char c) {
+		return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z');
+	}
+
+	inline bool isStreamNum(char c) {
+		return ('0' <= c && c <= '9');
+	}
+
+	inline bool isStreamIDLetter(char c) {
+		return isStreamAlpha(c) || isStreamNum(c) || c == '_';
+	}
+
+	StreamToken::StreamToken(TokenType type_, int lineNumber_) : type(type_), s(), i(0), f(0.0f), lineNumber(lineNumber_) {
+	}
+
+	StreamLexer::StreamLexer(std::istream & input_) : input(input_), lineNumber(1)
+	{
+	}
+
+	std::string StreamLexer::readString()
+	{
+		std::string result;
+		bool escape = false;
+		char c;
+		while (input.get(c)) {
+			if (c == '\n')
+				lineNumber++;
+
+			if (escape) {
+				result.push_back(c);
+				escape = false;
+			}
+			else if (c == '\\') {
+				escape = true;
+			}
+			else if (c == '"') {
+				return result;
+			}
+			else {
+				result.push_back(c);
+			}
+		}
+
+		throw OpenStringLiteralException(lineNumber);
+	}
+
+	std::string StreamLexer::readIdentifier()
+	{
+		std::string result;
+
+		char c;
+		while (input.get(c)) {
+			if (isStreamIDLetter(c)) {
+				result.push_back(c);
+			}
+			else {
+				input.putback(c);
+				return result;
+			}
+		}
+
+		return result;
+	}
+
+	StreamToken StreamLexer::getNextToken()
+	{
+		char c = input.get();
+		while (isStreamWhite(c) || c == '#') {
+			while (isStreamWhite(c)) {
+				if (c == '\n')
+					lineNumber++;
+
+				c = input.get();
+			}
+
+			if (c == '#') {
+				do {
+					c = input.get();
+				} while (c != '\n' && input.good());
+				lineNumber++;
+				c = input.get();
+			}
+		}
+
+		if (input.good() == false)
+			return StreamToken(TokenType::END_OF_STREAM, lineNumber);
+
+		switch (c) {
+		case '*': return StreamToken(TokenType::ASTERISK, lineNumber);
+		case ':': return StreamToken(TokenType::COLON, lineNumber);
+		case ',': return StreamToken(TokenType::COMMA, lineNumber);
+		case '[': return StreamToken(TokenType::LBRA, lineNumber);
+		case ']': return StreamToken(TokenType::RBRA, lineNumber);
+		case '{': return StreamToken(TokenType::LCBRA, lineNumber);
+		case '}': return StreamToken(TokenType::RCBRA, lineNumber);
+		case '(': return StreamToken(TokenType::LPAR, lineNumber);
+		case ')': return StreamToken(TokenType::RPAR, lineNumber);
+		}
+
+		if (c == '"') {
+			StreamToken result(TokenType::STRING, lineNumber);
+			result.s = readString();
+			return result;
+		}
+
+		if (isStreamAlpha(c)) {
+			input.putback(c);
+			StreamToken result(TokenType::ID, lineNumber);
+			result.s = readIdentifier();
+			return result;
+		}
+
+		bool negativeNumber = false;
+		if (c == '-') {
+			c = input.get();
+			if (isStreamNum(c) == false) {
+				input.putback(c);
+				return StreamToken(TokenType::MINUS, lineNumber);
+			}
+			negativeNumber = true;
+		}
+
+		if (isStreamNum(c)) {
+			std::string number;
+			number.push_back(c);
+			bool floatNum = false;
+
+			while (input.get(c)) {
+				if (isStreamNum(c)) {
+					number.push_back(c);
+				}
+				else if (c == '.') {
+					number.push_back(c);
+					floatNum = true;
+				}
+				else {
+					input.putback(c);
+
+					if (floatNum) {
+						StreamToken result(TokenType::FLOAT, lineNumber);
+						result.f = (negativeNumber ? -1.0f : 1.0f) * std::stof(number);
+						return result;
+					}
+
+					StreamToken result(TokenType::INT, lineNumber);
+					result.i = (negativeNumber ? -1 : 1) * std::stoi(number);
+					return result;
+				}
+			}
+		}
+
+		return StreamToken(TokenType::ERROR, lineNumber);
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef PS_STREAM_LEXER_INCLUDED
+#define PS_STREAM_LEXER_INCLUDED
+#include <istream>
+#include <string>
+#include "..\Portal-stein\Lexer.hpp"
+
+namespace ps {
+
+	//***********************************************
+	// STREAM LEXER
+	//***********************************************
+
+	/// Token of StreamLexer, its value is copied out of the stream.
+	struct StreamToken {
+		TokenType type;
+		std::string s;
+		int i;
+		float f;
+		int lineNumber;
+
+		StreamToken(TokenType type, int lineNumber);
+	};
+
+	/// Lexer that reads the level from stream character by character, as the game did before Lexer worked on the buffer of the whole file.
+	/// It is kept only as the baseline of the lexer throughput benchmark, it produces the same tokens as Lexer.
+	class StreamLexer {
+	private:
+		std::istream & input;
+		int lineNumber;
+
+		std::string readString();
+		std::string readIdentifier();
+
+	public:
+		StreamLexer(std::istream & input_);
+
+		/// Gets next token from the input.
+		StreamToken getNextToken();
+	};
+}
+
+#endif // !PS_STREAM_LEXER_INCLUDED
@@ -0,0 +1,262 @@
+#include <SFML\Graphics.hpp>
+#include <SFML\OpenGL.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include "..\Portal-stein\LevelLoader.hpp"
+#include "..\Portal-stein\CompiledLevel.hpp"
+#include "..\Portal-stein\TextureCache.hpp"
+#include "..\Portal-stein\RayCaster.hpp"
+#include "..\Portal-stein\Math.hpp"
+#include "Benchmark.hpp"
+
+namespace ps {
+
+	const char * usage =
+		"Usage: ps_bench [options]\n"
+		"  --levels <dir>       directory with the level files (default: levels)\n"
+		"  --frames <n>         number of frames rendered in each level (default: 1200)\n"
+		"  --size <w> <h>       size of the rendered image (default: 800 600)\n"
+		"  --threads <n>        number of rendering threads (default: all cores)\n"
+		"  --software           rasterize frames on CPU into frame buffer\n"
+		"  --spans              traverse the segments by spans of columns instead of ray per column\n"
+		"  --budget <n>         ray steps in one frame, portals over budget are fogged (default: 0, no limit)\n"
+		"  --output <file>      write the report to file instead of standard output\n"
+		"  --baseline <file>    compare frame times with previously written report\n"
+		"  --tolerance <x>      relative slowdown that is not a regression (default: 0.1)\n"
+		"  --micro              only measure wall queries with and without cached wall geometry\n"
+		"  --lexer              only measure throughput of the lexer reading the level files\n";
+
+	// Milliseconds elapsed from given time point.
+	double millisecondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Runs the microbenchmarks on every level and writes their results as JSON array.
+	int runMicrobenchmarks(const std::vector<std::experimental::filesystem::path> & levelFiles, std::ostream & output) {
+		output << "[";
+		for (std::size_t i = 0; i < levelFiles.size(); ++i) {
+			std::ifstream fileStream{ levelFiles[i].string() };
+			try {
+				LevelLoader loader(fileStream);
+				Level level = loader.loadLevel();
+				auto scene = level.makeScene();
+
+				output << ((i > 0) ? ",\n" : "\n");
+				writeMicroReport(output, levelFiles[i].filename().string(), benchmarkWallGeometry(scene, 2000));
+			}
+			catch (std::exception & e) {
+				std::cerr << "Level \"" << levelFiles[i].string() << "\" could not be benchmarked: " << e.what() << std::endl;
+				return 1;
+			}
+		}
+		output << "\n]\n";
+		return 0;
+	}
+
+	// Measures the lexer on all level files (joined together and read repeatedly) and writes the result as JSON.
+	int runLexerBenchmark(const std::vector<std::experimental::filesystem::path> & levelFiles, std::ostream & output) {
+		std::string input;
+		for (auto & file : levelFiles) {
+			std::ifstream fileStream{ file.string() };
+			input.append(std::istreambuf_iterator<char>(fileStream), std::istreambuf_iterator<char>());
+			input.push_back('\n');
+		}
+
+		// the levels are small, so they are read repeatedly to get at least 16 MiB of input
+		const std::size_t measuredBytes = 16 * 1024 * 1024;
+		std::size_t repetitions = getMax<std::size_t>(measuredBytes / getMax<std::size_t>(input.size(), 1), 1);
+
+		try {
+			writeLexerReport(output, benchmarkLexers(input, repetitions));
+		}
+		catch (std::exception & e) {
+			std::cerr << "Lexers could not be benchmarked: " << e.what() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	int main(int argc, char * argv[]) {
+		using namespace std::experimental::filesystem;
+		using namespace std::chrono;
+
+		BenchmarkConfig config;
+		config.width = 800;
+		config.height = 600;
+		config.frames = 1200;
+		config.threads = getMax(std::thread::hardware_concurrency(), 1u);
+		config.software = false;
+		config.spans = false;
+		config.rayStepBudget = 0;
+		config.tolerance = 0.1;
+
+		std::string levelDirPath = "levels";
+		std::string outputPath;
+		std::string baselinePath;
+		bool micro = false;
+		bool lexer = false;
+
+		for (int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			int remaining = argc - i - 1;
+
+			if (arg == "--levels" && remaining >= 1)
+				levelDirPath = argv[++i];
+			else if (arg == "--frames" && remaining >= 1)
+				config.frames = (unsigned int)std::stoul(argv[++i]);
+			else if (arg == "--size" && remaining >= 2) {
+				config.width = (unsigned int)std::stoul(argv[++i]);
+				config.height = (unsigned int)std::stoul(argv[++i]);
+			}
+			else if (arg == "--threads" && remaining >= 1)
+				config.threads = getMax((unsigned int)std::stoul(argv[++i]), 1u);
+			else if (arg == "--software")
+				config.software = true;
+			else if (arg == "--spans")
+				config.spans = true;
+			else if (arg == "--budget" && remaining >= 1)
+				config.rayStepBudget = (std::size_t)std::stoul(argv[++i]);
+			else if (arg == "--output" && remaining >= 1)
+				outputPath = argv[++i];
+			else if (arg == "--baseline" && remaining >= 1)
+				baselinePath = argv[++i];
+			else if (arg == "--tolerance" && remaining >= 1)
+				config.tolerance = std::stod(argv[++i]);
+			else if (arg == "--micro")
+				micro = true;
+			else if (arg == "--lexer")
+				lexer = true;
+			else {
+				std::cerr << usage;
+				return 1;
+			}
+		}
+
+		// levels are benchmarked in the order of their names, so the reports of two runs can be compared line by line
+		std::vector<path> levelFiles;
+		for (const path & file : directory_iterator(levelDirPath)) {
+			if (is_regular_file(file) && !isCompiledLevelPath(file.string()))
+				levelFiles.push_back(file);
+		}
+		std::sort(levelFiles.begin(), levelFiles.end());
+
+		// microbenchmarks do not render anything, so no render target is needed
+		if (lexer) {
+			if (outputPath.empty())
+				return runLexerBenchmark(levelFiles, std::cout);
+
+			std::ofstream outputStream{ outputPath };
+			return runLexerBenchmark(levelFiles, outputStream);
+		}
+
+		if (micro) {
+			if (outputPath.empty())
+				return runMicrobenchmarks(levelFiles, std::cout);
+
+			std::ofstream outputStream{ outputPath };
+			return runMicrobenchmarks(levelFiles, outputStream);
+		}
+
+		// frames are rendered offscreen, no window is opened
+		FloorCeiling::compileShaders();
+		sf::RenderTexture renderTexture;
+		FrameBuffer frameBuffer;
+		if (config.software)
+			frameBuffer.resize(config.width, config.height);
+		else if (!renderTexture.create(config.width, config.height)) {
+			std::cerr << "Offscreen render target could not be created!\n";
+			return 1;
+		}
+
+		RayCaster caster;
+		caster.setThreadCount(config.threads);
+		caster.setSpanTraversal(config.spans);
+		caster.setRayStepBudget(config.rayStepBudget);
+
+		const float timeStep = 1.0f / 60.0f;
+		std::vector<LevelResult> results;
+
+		for (const path & file : levelFiles) {
+			std::string levelName = file.filename().string();
+			std::cerr << "Benchmarking " << levelName << " ..." << std::endl;
+
+			auto loadStart = steady_clock::now();
+			std::ifstream fileStream{ file.string() };
+			try {
+				LevelLoader loader(fileStream);
+				Level level = loader.loadLevel();
+				TextureCache::getInstance().uploadTextures();
+				double loadMs = millisecondsSince(loadStart);
+				std::size_t textureKiB = TextureCache::getInstance().getTextureMemory() / 1024;
+
+				auto scene = level.makeScene();
+				// textures of the previous level are released, their CPU copies must not be used for new textures at the same address
+				frameBuffer.clearTextures();
+				FlyThrough flight{ timeStep };
+				std::vector<double> frameMs;
+				std::vector<std::size_t> raySteps;
+				frameMs.reserve(config.frames);
+				raySteps.reserve(config.frames);
+
+				for (unsigned int frame = 0; frame < config.frames; ++frame) {
+					flight.step(scene);
+
+					// only rendering is measured, the simulation of the camera is not part of the frame time
+					auto frameStart = steady_clock::now();
+					if (config.software) {
+						frameBuffer.clear(sf::Color::Black);
+						caster.render(frameBuffer, scene);
+					}
+					else {
+						renderTexture.clear(sf::Color::Black);
+						caster.render(renderTexture, scene);
+						renderTexture.display();
+						glFinish();		// draw calls are asynchronous, wait until GPU really finishes the frame
+					}
+					frameMs.push_back(millisecondsSince(frameStart));
+					raySteps.push_back(caster.getRayStepCount());
+				}
+
+				results.push_back(summarize(levelName, loadMs, std::move(frameMs), raySteps, flight.getPortalCrossings()));
+				results.back().textureKiB = textureKiB;
+			}
+			catch (std::exception & e) {
+				std::cerr << "Level \"" << file.string() << "\" could not be benchmarked: " << e.what() << std::endl;
+				return 1;
+			}
+		}
+
+		std::vector<std::string> regressions;
+		if (!baselinePath.empty()) {
+			std::ifstream baselineStream{ baselinePath };
+			if (!baselineStream) {
+				std::cerr << "Baseline \"" << baselinePath << "\" could not be opened!\n";
+				return 1;
+			}
+
+			regressions = findRegressions(results, readBaseline(baselineStream), config.tolerance);
+			for (auto & regression : regressions)
+				std::cerr << "REGRESSION " << regression << std::endl;
+		}
+
+		if (outputPath.empty()) {
+			writeReport(std::cout, config, results, regressions);
+		}
+		else {
+			std::ofstream outputStream{ outputPath };
+			writeReport(outputStream, config, results, regressions);
+		}
+
+		// regressions are reported by the exit code, so the benchmark can be used in automated checks
+		return (regressions.empty()) ? 0 : 2;
+	}
+}
+
+int main(int argc, char * argv[]) {
+	return ps::main(argc, argv);
+}
@@ -0,0 +1,146 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "..\Portal-stein\LevelLoader.hpp"
+#include "..\Portal-stein\CompiledLevel.hpp"
+#include "..\Portal-stein\MappedFile.hpp"
+#include "..\Portal-stein\Math.hpp"
+
+namespace ps {
+
+	const char * usage =
+		"Usage: ps_levelc [options] <level file | level directory>...\n"
+		"  --output <file>      write the compiled level to file (only with single level file)\n"
+		"  --check              only check that the compiled levels are up to date, nothing is written\n"
+		"\n"
+		"Each level is compiled into the file with \".psl\" appended to its name, which the game loads instead of parsing the level.\n";
+
+	// Writes the error of the level, that could not be compiled (the same information, that the game writes into its log).
+	void reportError(const std::string & sourcePath) {
+		try {
+			throw;
+		}
+		catch (UnexpectedTokenException & e) {
+			std::cerr << sourcePath << ":" << e.lineNumber << ": Expected \"" << getTokenString(e.expected) << "\", but \"" <<
+				getTokenString(e.actual) << "\" was read!" << std::endl;
+		}
+		catch (TexureLoadFailedException & e) {
+			std::cerr << sourcePath << ":" << e.lineNumber << ": Texture could not be loaded from \"" << e.path << "\"!" << std::endl;
+		}
+		catch (IdentifierException & e) {
+			std::cerr << sourcePath << ":" << e.lineNumber << ": Identifier \"" << e.id << "\" of type \"" << e.type << "\" : " << e.message << std::endl;
+		}
+		catch (OpenStringLiteralException & e) {
+			std::cerr << sourcePath << ":" << e.lineNumber << ": Ending quote of string literal was not found!" << std::endl;
+		}
+		catch (std::exception & e) {
+			std::cerr << sourcePath << ": " << e.what() << std::endl;
+		}
+	}
+
+	// Warns if the player does not start in the segment the level puts it in (the game moves the player into a segment, that contains the
+	// starting position, as soon as it starts moving).
+	void checkInitialCamera(const std::string & sourcePath, const Level & level) {
+		const ObjectInScene & camera = level.getInitialCamera();
+		sf::Vector2f position = toVector2(camera.getPosition());
+		if (level.getGeometry().isInSegment(camera.getSegmentId(), position))
+			return;
+
+		std::vector<std::size_t> segments = level.getGeometry().findSegments(position);
+		std::cerr << sourcePath << ": warning: Player does not start in its segment (id " << camera.getSegmentId() << "), ";
+		if (segments.empty())
+			std::cerr << "no segment contains the starting position!" << std::endl;
+		else
+			std::cerr << "the starting position lies in the segment with id " << segments.front() << "!" << std::endl;
+	}
+
+	// Returns true if the compiled level of the source exists and it was compiled from the current content of the source.
+	bool isUpToDate(const std::string & sourcePath) {
+		try {
+			std::ifstream input{ sourcePath };
+			std::ostringstream source;
+			source << input.rdbuf();
+			std::string text = source.str();
+
+			MappedFile compiled{ getCompiledLevelPath(sourcePath) };
+			if (!compiled.isOpen())
+				return false;
+
+			readCompiledLevel(compiled.getData(), compiled.getSize(), hashLevelSource(text.data(), text.size()));
+			return true;
+		}
+		catch (std::exception &) {
+			return false;
+		}
+	}
+
+	int main(int argc, char * argv[]) {
+		using namespace std::experimental::filesystem;
+
+		std::vector<std::string> sources;
+		std::string outputPath;
+		bool checkOnly = false;
+
+		for (int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			int remaining = argc - i - 1;
+
+			if (arg == "--output" && remaining >= 1)
+				outputPath = argv[++i];
+			else if (arg == "--check")
+				checkOnly = true;
+			else if (!arg.empty() && arg[0] != '-') {
+				if (is_directory(arg)) {
+					// all the level sources of the directory are compiled (the compiled levels next to them are skipped)
+					for (const path & file : directory_iterator(arg)) {
+						if (is_regular_file(file) && !isCompiledLevelPath(file.string()))
+							sources.push_back(file.string());
+					}
+				}
+				else
+					sources.push_back(arg);
+			}
+			else {
+				std::cerr << usage;
+				return 1;
+			}
+		}
+
+		if (sources.empty() || (!outputPath.empty() && sources.size() != 1)) {
+			std::cerr << usage;
+			return 1;
+		}
+
+		int result = 0;
+		for (auto & sourcePath : sources) {
+			if (checkOnly) {
+				bool upToDate = isUpToDate(sourcePath);
+				std::cout << sourcePath << ((upToDate) ? ": up to date" : ": out of date") << std::endl;
+				if (!upToDate)
+					result = 1;
+				continue;
+			}
+
+			std::string compiledPath = (outputPath.empty()) ? getCompiledLevelPath(sourcePath) : outputPath;
+			try {
+				Level level = compileLevelFile(sourcePath, compiledPath);
+				checkInitialCamera(sourcePath, level);
+				std::cout << sourcePath << " -> " << compiledPath << " (" << level.getGeometry().getSegmentCount() << " segments, " <<
+					level.getTextures().size() << " textures)" << std::endl;
+			}
+			catch (...) {
+				reportError(sourcePath);
+				result = 1;
+			}
+		}
+
+		return result;
+	}
+}
+
+int main(int argc, char * argv[]) {
+	return ps::main(argc, argv);
+}
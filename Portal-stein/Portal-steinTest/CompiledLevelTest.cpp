@@ -0,0 +1,101 @@
+#include "gtest\gtest.h"
+#include <sstream>
+#include <string>
+#include "..\Portal-stein\CompiledLevel.hpp"
+#include "..\Portal-stein\LevelLoader.hpp"
+
+using namespace ps;
+
+class CompiledLevelTest : public ::testing::Test {
+public:
+	CompiledLevelTest() : source(
+		"*VERTICES\n"
+		"a : (0, 0)\n"
+		"b : (0, 2)\n"
+		"c : (2, 2)\n"
+		"d : (2, 0)\n"
+		"e : (4, 2)\n"
+		"f : (4, 0)\n"
+		"*SEGMENTS\n"
+		"left : {\n"
+		"    floor((0, 255, 0))\n"
+		"    walls ((255, 0, 0)) { a-b-c[right]d- }\n"
+		"}\n"
+		"right : {\n"
+		"    walls ((0, 0, 255)) { d[left]c-e-f- }\n"
+		"}\n"
+		"*PLAYER\n"
+		"(1, 1) - (1, 0) - left\n") {
+		hash = hashLevelSource(source.data(), source.size());
+
+		std::istringstream input{ source };
+		LevelLoader loader{ input };
+		Level level = loader.loadLevel();
+
+		std::ostringstream output;
+		writeCompiledLevel(output, level, hash);
+		compiled = output.str();
+	}
+
+	std::string source;
+	std::uint64_t hash;
+	std::string compiled;
+};
+
+TEST_F(CompiledLevelTest, HashIsFnv1a) {
+	EXPECT_EQ(0xcbf29ce484222325ull, hashLevelSource("", 0));
+	EXPECT_EQ(0xaf63dc4c8601ec8cull, hashLevelSource("a", 1));
+}
+
+TEST_F(CompiledLevelTest, CompiledLevelPaths) {
+	EXPECT_EQ("levels/01_The_Room.psl", getCompiledLevelPath("levels/01_The_Room"));
+	EXPECT_TRUE(isCompiledLevelPath("levels/01_The_Room.psl"));
+	EXPECT_FALSE(isCompiledLevelPath("levels/01_The_Room"));
+	EXPECT_FALSE(isCompiledLevelPath("psl"));
+}
+
+TEST_F(CompiledLevelTest, RoundTrip) {
+	Level level = readCompiledLevel(compiled.data(), compiled.size(), hash);
+
+	const LevelGeometry & geometry = level.getGeometry();
+	ASSERT_EQ(2u, geometry.getSegmentCount());
+	EXPECT_EQ(4u, geometry.getWalls().getSegmentWalls(0).count);
+	EXPECT_EQ(4u, geometry.getWalls().getSegmentWalls(1).count);
+	EXPECT_TRUE(level.getTextures().empty());
+
+	// ids are given to the segments when they are referenced for the first time, so the "right" segment is the first one
+	const LevelWalls & walls = geometry.getWalls();
+	std::uint32_t door = walls.getSegmentWalls(1).first + 2;
+	ASSERT_TRUE(walls.isPortal(door));
+	EXPECT_EQ(0u, walls.getPortal(door).getTargetSegment());
+	EXPECT_EQ(sf::Color::Red, walls.getMaterial(door - 1).color);
+
+	EXPECT_EQ(1u, level.getInitialCamera().getSegmentId());
+	EXPECT_FLOAT_EQ(1.0f, level.getInitialCamera().getPosition().x);
+	EXPECT_FLOAT_EQ(1.0f, level.getInitialCamera().getPosition().y);
+
+	// level read from compiled level is compiled the same way again
+	std::ostringstream output;
+	writeCompiledLevel(output, level, hash);
+	EXPECT_EQ(compiled, output.str());
+}
+
+TEST_F(CompiledLevelTest, OtherSourceIsRejected) {
+	EXPECT_THROW(readCompiledLevel(compiled.data(), compiled.size(), hash + 1), CompiledLevelException);
+}
+
+TEST_F(CompiledLevelTest, DamagedLevelIsRejected) {
+	EXPECT_THROW(readCompiledLevel(compiled.data(), compiled.size() - 1, hash), CompiledLevelException);
+	EXPECT_THROW(readCompiledLevel(compiled.data(), 16, hash), CompiledLevelException);
+
+	std::string otherVersion = compiled;
+	otherVersion[4] += 1;
+	EXPECT_THROW(readCompiledLevel(otherVersion.data(), otherVersion.size(), hash), CompiledLevelException);
+}
+
+TEST_F(CompiledLevelTest, OtherVisibilityDepthIsRejected) {
+	// depth of the potentially visible set is the last field of the 72-byte header
+	std::string otherDepth = compiled;
+	otherDepth[68] += 1;
+	EXPECT_THROW(readCompiledLevel(otherDepth.data(), otherDepth.size(), hash), CompiledLevelException);
+}
@@ -0,0 +1,139 @@
+#include "gtest\gtest.h"
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "..\Portal-stein\FrameBuffer.hpp"
+#include "..\Portal-stein\TextureCache.hpp"
+
+using namespace ps;
+
+class FrameBufferTest : public ::testing::Test {
+public:
+	FrameBufferTest() : path("FrameBufferTest.bmp"), frame(4, 4), batch() {
+		// 2x2 image in 24-bit BMP format (rows are padded to 4 bytes, the bottom row is stored first), its pixels are
+		// (0, 0) blue, (1, 0) cyan, (0, 1) red, (1, 1) green
+		const std::uint8_t header[54] = {
+			'B', 'M', 70, 0, 0, 0, 0, 0, 0, 0, 54, 0, 0, 0,
+			40, 0, 0, 0, 2, 0, 0, 0, 2, 0, 0, 0, 1, 0, 24, 0, 0, 0, 0, 0, 16, 0, 0, 0,
+			0x13, 0x0b, 0, 0, 0x13, 0x0b, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+		};
+		const std::uint8_t pixels[16] = {
+			0, 0, 255, 0, 255, 0, 0, 0,
+			255, 0, 0, 255, 255, 0, 0, 0
+		};
+
+		std::ofstream file{ path, std::ios_base::binary };
+		file.write(reinterpret_cast<const char *>(header), sizeof(header));
+		file.write(reinterpret_cast<const char *>(pixels), sizeof(pixels));
+		file.close();
+
+		frame.clear(sf::Color::Black);
+		batch.setViewPlane(1.0f, 4);
+	}
+
+	~FrameBufferTest() {
+		std::remove(path.c_str());
+	}
+
+	std::string path;
+	FrameBuffer frame;
+	RenderBatch batch;
+
+	// Gets the texture of the test image, its image is decoded (the texture is not uploaded, so no OpenGL context is needed).
+	std::shared_ptr<sf::Texture> requestTexture() {
+		auto texture = TextureCache::getInstance().request(path);
+		EXPECT_TRUE(TextureCache::getInstance().waitForImage(path));
+		return texture;
+	}
+
+	sf::Color getPixel(unsigned int column, unsigned int row) const {
+		const sf::Uint8 * pixel = frame.getPixels() + 4 * (row * frame.getWidth() + column);
+		return sf::Color(pixel[0], pixel[1], pixel[2], pixel[3]);
+	}
+
+	static sf::Vertex makeVertex(float column, float y, sf::Vector2f texCoords = sf::Vector2f()) {
+		return sf::Vertex(sf::Vector2f(column, y), sf::Color::White, texCoords);
+	}
+};
+
+TEST_F(FrameBufferTest, LinesAreClippedAtFrameEdges) {
+	// pixel is covered, if its center lies in the line
+	batch.addLine(sf::Vertex(sf::Vector2f(0.0f, -5.0f), sf::Color::Red), sf::Vertex(sf::Vector2f(0.0f, 2.5f), sf::Color::Red));
+	// line given bottom first reaches out of the bottom edge
+	batch.addLine(sf::Vertex(sf::Vector2f(3.0f, 10.0f), sf::Color::Green), sf::Vertex(sf::Vector2f(3.0f, 1.0f), sf::Color::Green));
+	// lines out of the left and right edge are skipped
+	batch.addLine(sf::Vertex(sf::Vector2f(-1.0f, 0.0f), sf::Color::Blue), sf::Vertex(sf::Vector2f(-1.0f, 4.0f), sf::Color::Blue));
+	batch.addLine(sf::Vertex(sf::Vector2f(4.0f, 0.0f), sf::Color::Blue), sf::Vertex(sf::Vector2f(4.0f, 4.0f), sf::Color::Blue));
+	frame.rasterize(batch);
+
+	EXPECT_EQ(sf::Color::Red, getPixel(0, 0));
+	EXPECT_EQ(sf::Color::Red, getPixel(0, 1));
+	EXPECT_EQ(sf::Color::Black, getPixel(0, 2));
+	EXPECT_EQ(sf::Color::Black, getPixel(3, 0));
+	EXPECT_EQ(sf::Color::Green, getPixel(3, 1));
+	EXPECT_EQ(sf::Color::Green, getPixel(3, 3));
+	for (unsigned int row = 0; row < 4; ++row) {
+		EXPECT_EQ(sf::Color::Black, getPixel(1, row));
+		EXPECT_EQ(sf::Color::Black, getPixel(2, row));
+	}
+}
+
+TEST_F(FrameBufferTest, WallTextureIsSampledAlongStrip) {
+	auto texture = requestTexture();
+
+	// texture coordinates are in pixels, the strip has constant x coordinate and covers the texture twice vertically
+	batch.addLine(makeVertex(1.0f, 0.0f, sf::Vector2f(1.0f, 0.0f)), makeVertex(1.0f, 4.0f, sf::Vector2f(1.0f, 4.0f)), texture.get());
+	frame.rasterize(batch);
+
+	EXPECT_EQ(sf::Color::Cyan, getPixel(1, 0));
+	EXPECT_EQ(sf::Color::Green, getPixel(1, 1));
+	EXPECT_EQ(sf::Color::Cyan, getPixel(1, 2));
+	EXPECT_EQ(sf::Color::Green, getPixel(1, 3));
+}
+
+TEST_F(FrameBufferTest, FloorTextureCoordinatesAreDividedByViewPlane) {
+	auto texture = requestTexture();
+
+	// floor strips in the bottom half of the frame, view plane coordinate goes from 0 (row 2) to -1 (bottom edge), texture coordinates
+	// are (point * view plane coordinate), so each strip samples one texel of the (repeated) texture in all its pixels
+	auto addFloor = [this, &texture](float column, sf::Vector2f point) {
+		batch.addFloorCeilingLine(makeVertex(column, 2.0f, point * batch.screenToViewPlane(2.0f)),
+			makeVertex(column, 4.0f, point * batch.screenToViewPlane(4.0f)), texture.get());
+	};
+	addFloor(0.0f, sf::Vector2f(1.5f, 0.5f));
+	addFloor(1.0f, sf::Vector2f(2.5f, 3.5f));
+	addFloor(2.0f, sf::Vector2f(-0.5f, -0.5f));
+	frame.rasterize(batch);
+
+	for (unsigned int row = 2; row < 4; ++row) {
+		EXPECT_EQ(sf::Color::Cyan, getPixel(0, row));
+		EXPECT_EQ(sf::Color::Red, getPixel(1, row));
+		EXPECT_EQ(sf::Color::Green, getPixel(2, row));
+	}
+	EXPECT_EQ(sf::Color::Black, getPixel(0, 1));
+	EXPECT_EQ(sf::Color::Black, getPixel(3, 3));
+}
+
+TEST_F(FrameBufferTest, ClearTexturesDropsCachedImages) {
+	// texture that was not loaded by TextureCache is copied from GPU
+	sf::Image image;
+	image.create(1, 1, sf::Color::Red);
+	sf::Texture texture;
+	ASSERT_TRUE(texture.loadFromImage(image));
+
+	batch.addLine(makeVertex(0.0f, 0.0f), makeVertex(0.0f, 4.0f), &texture);
+	frame.rasterize(batch);
+	EXPECT_EQ(sf::Color::Red, getPixel(0, 0));
+
+	// image is found only the first time the texture is encountered ...
+	image.create(1, 1, sf::Color::Green);
+	ASSERT_TRUE(texture.loadFromImage(image));
+	frame.rasterize(batch);
+	EXPECT_EQ(sf::Color::Red, getPixel(0, 0));
+
+	// ... until the images are dropped
+	frame.clearTextures();
+	frame.rasterize(batch);
+	EXPECT_EQ(sf::Color::Green, getPixel(0, 0));
+}
@@ -119,4 +119,48 @@ TEST_F(GeometryTest, MapLSTestScaled) {
 	EXPECT_VEC3NEAR(sf::Vector3f(4.0f, 2.0f, 0.0f), x.getPosition(), 0.01);
 	EXPECT_VEC2NEAR(sf::Vector2f(0.0f, 1.0f), x.getDirection(), 0.01);
 	EXPECT_EQ(0, x.getSegmentId());
-}
\ No newline at end of file
+}
+
+TEST_F(GeometryTest, AffineTransformMapsEndPoints) {
+	LineSegment from{ sf::Vector2f{ 4.0f, 3.0f }, sf::Vector2f{ 7.0f, 4.0f } };
+	LineSegment to{ sf::Vector2f{ -1.0f, 2.0f }, sf::Vector2f{ 1.0f, -3.0f } };
+
+	auto transform = AffineTransform::mapLineSegments(from, to);
+	EXPECT_VEC2NEAR(to.getFrom(), transform.transformPoint(from.getFrom()), 0.0001f);
+	EXPECT_VEC2NEAR(to.getTo(), transform.transformPoint(from.getTo()), 0.0001f);
+	EXPECT_VEC2NEAR(normalized(to.getTo() - to.getFrom()), transform.transformDirection(normalized(from.getTo() - from.getFrom())), 0.0001f);
+}
+
+TEST_F(GeometryTest, AffineTransformScalesAlongSegment) {
+	LineSegment from{ sf::Vector2f{ 1.0f, 0.0f }, sf::Vector2f{ 1.0f, 4.0f } };
+	LineSegment to{ sf::Vector2f{ 5.0f, 1.0f }, sf::Vector2f{ 5.0, 3.0 } };
+
+	// points off the segment keep their distance from it, only the coordinate along the segment is scaled
+	auto transform = AffineTransform::mapLineSegments(from, to);
+	EXPECT_VEC2NEAR(sf::Vector2f(4.0f, 2.0f), transform.transformPoint(sf::Vector2f{ 0.0f, 2.0f }), 0.0001f);
+	EXPECT_VEC2NEAR(sf::Vector2f(7.0f, 1.5f), transform.transformPoint(sf::Vector2f{ 3.0f, 1.0f }), 0.0001f);
+	EXPECT_VEC2NEAR(sf::Vector2f(1.0f, 0.0f), transform.transformDirection(sf::Vector2f{ 1.0f, 0.0f }), 0.0001f);
+}
+
+TEST_F(GeometryTest, AffineTransformIdentity) {
+	AffineTransform identity;
+	ObjectInScene x{ sf::Vector3f{ 3.0f, -2.0f, 1.0f }, sf::Vector2f{ 0.6f, 0.8f }, 4 };
+
+	identity.apply(x);
+	EXPECT_VEC3NEAR(sf::Vector3f(3.0f, -2.0f, 1.0f), x.getPosition(), 0.0001f);
+	EXPECT_VEC2NEAR(sf::Vector2f(0.6f, 0.8f), x.getDirection(), 0.0001f);
+	EXPECT_EQ(4, x.getSegmentId());
+}
+
+TEST_F(GeometryTest, AffineTransformInverse) {
+	LineSegment from{ sf::Vector2f{ 4.0f, 3.0f }, sf::Vector2f{ 7.0f, 4.0f } };
+	LineSegment to{ sf::Vector2f{ -1.0f, 2.0f }, sf::Vector2f{ 1.0f, -3.0f } };
+	ObjectInScene x{ sf::Vector3f{ 5.0f, 1.0f, 0.5f }, sf::Vector2f{ 0.0f, 1.0f }, 0 };
+
+	auto transform = AffineTransform::mapLineSegments(from, to);
+	transform.apply(x);
+	transform.inverse().apply(x);
+	EXPECT_VEC3NEAR(sf::Vector3f(5.0f, 1.0f, 0.5f), x.getPosition(), 0.0001f);
+	EXPECT_VEC2NEAR(sf::Vector2f(0.0f, 1.0f), x.getDirection(), 0.0001f);
+	EXPECT_VEC2NEAR(from.getTo(), transform.inverse().transformPoint(to.getTo()), 0.0001f);
+}
@@ -0,0 +1,205 @@
+#include "gtest\gtest.h"
+#include <cmath>
+#include <random>
+#include "Common.hpp"
+#include "..\Portal-stein\Intersect.hpp"
+#include "..\Portal-stein\Geometry.hpp"
+#include "..\Portal-stein\Math.hpp"
+
+using namespace ps;
+
+class IntersectTest : public ::testing::Test {
+public:
+	IntersectTest() : room(), randomGenerator(42) {
+		// square room [0, 2] x [0, 2], its walls face the rays going from inside
+		room.add(sf::Vector2f{ 0.0f, 0.0f }, sf::Vector2f{ 0.0f, 2.0f });
+		room.add(sf::Vector2f{ 0.0f, 2.0f }, sf::Vector2f{ 2.0f, 2.0f });
+		room.add(sf::Vector2f{ 2.0f, 2.0f }, sf::Vector2f{ 2.0f, 0.0f });
+		room.add(sf::Vector2f{ 2.0f, 0.0f }, sf::Vector2f{ 0.0f, 0.0f });
+	}
+
+	// Returns convex polygon with given number of vertices, whose walls face the rays going from inside.
+	std::vector<sf::Vector2f> randomPolygon(std::size_t vertexCount) {
+		std::uniform_real_distribution<float> radius{ 1.0f, 3.0f };
+		std::vector<sf::Vector2f> vertices;
+		for (std::size_t i = 0; i < vertexCount; ++i) {
+			float angle = -2.0f * PI<float> * i / vertexCount;
+			float r = radius(randomGenerator);
+			vertices.push_back(sf::Vector2f{ r * std::cos(angle), r * std::sin(angle) });
+		}
+
+		// removes vertices, that would make the polygon non-convex
+		bool removed = true;
+		while (removed && vertices.size() > 3) {
+			removed = false;
+			for (std::size_t i = 0; i < vertices.size(); ++i) {
+				auto & a = vertices[i];
+				auto & b = vertices[(i + 1) % vertices.size()];
+				auto & c = vertices[(i + 2) % vertices.size()];
+				if (cross(b - a, c - b) >= 0.0f) {
+					vertices.erase(vertices.begin() + (i + 1) % vertices.size());
+					removed = true;
+					break;
+				}
+			}
+		}
+
+		return vertices;
+	}
+
+	sf::Vector2f randomDirection() {
+		std::uniform_real_distribution<float> angle{ 0.0f, 2.0f * PI<float> };
+		float a = angle(randomGenerator);
+		return sf::Vector2f{ std::cos(a), std::sin(a) };
+	}
+
+	WallArrays room;
+	std::mt19937 randomGenerator;
+};
+
+TEST_F(IntersectTest, Padding) {
+	EXPECT_EQ(4u, room.size());
+	EXPECT_EQ(WallArrays::padding, room.paddedSize());
+	EXPECT_EQ(room.paddedSize(), room.fromX.size());
+
+	for (int i = 0; i < 5; ++i)
+		room.add(sf::Vector2f{ 0.0f, 0.0f }, sf::Vector2f{ 1.0f, 1.0f });
+	EXPECT_EQ(9u, room.size());
+	EXPECT_EQ(2 * WallArrays::padding, room.paddedSize());
+}
+
+TEST_F(IntersectTest, RoomHit0) {
+	auto hit = intersectWalls(room, sf::Vector2f{ 1.0f, 0.5f }, sf::Vector2f{ -1.0f, 0.0f });
+	ASSERT_EQ(0, hit.wall);
+	EXPECT_FLOAT_EQ(1.0f, hit.rayParameter);
+	EXPECT_FLOAT_EQ(0.25f, hit.wallParameter);
+}
+
+TEST_F(IntersectTest, RoomHit1) {
+	auto hit = intersectWalls(room, sf::Vector2f{ 0.5f, 1.5f }, sf::Vector2f{ 0.0f, 1.0f });
+	ASSERT_EQ(1, hit.wall);
+	EXPECT_FLOAT_EQ(0.5f, hit.rayParameter);
+	EXPECT_FLOAT_EQ(0.25f, hit.wallParameter);
+}
+
+TEST_F(IntersectTest, BackFacingWallIsNotHit) {
+	// ray goes from outside of the room, so it sees the back of the wall at x = 0
+	auto hit = intersectWalls(room, sf::Vector2f{ -1.0f, 1.0f }, sf::Vector2f{ 1.0f, 0.0f });
+	ASSERT_EQ(2, hit.wall);
+	EXPECT_FLOAT_EQ(3.0f, hit.rayParameter);
+}
+
+TEST_F(IntersectTest, MaxRayParameter) {
+	auto hit = intersectWalls(room, sf::Vector2f{ 1.0f, 1.0f }, sf::Vector2f{ 0.5f, 0.0f }, 1.0f);
+	EXPECT_EQ(-1, hit.wall);
+
+	hit = intersectWalls(room, sf::Vector2f{ 1.0f, 1.0f }, sf::Vector2f{ 0.5f, 0.0f }, 2.0f);
+	ASSERT_EQ(2, hit.wall);
+	EXPECT_FLOAT_EQ(2.0f, hit.rayParameter);
+}
+
+TEST_F(IntersectTest, CornerHitReturnsLowestIndex) {
+	auto hit = intersectWalls(room, sf::Vector2f{ 1.0f, 1.0f }, sf::Vector2f{ 1.0f, 1.0f });
+	ASSERT_EQ(1, hit.wall);
+	EXPECT_FLOAT_EQ(1.0f, hit.rayParameter);
+	EXPECT_FLOAT_EQ(1.0f, hit.wallParameter);
+}
+
+TEST_F(IntersectTest, AgreesWithRayLineSegmentIntersection) {
+	for (int polygon = 0; polygon < 50; ++polygon) {
+		auto vertices = randomPolygon(3 + polygon % 14);
+		WallArrays walls;
+		for (std::size_t i = 0; i < vertices.size(); ++i)
+			walls.add(vertices[i], vertices[(i + 1) % vertices.size()]);
+
+		for (int i = 0; i < 20; ++i) {
+			sf::Vector2f direction = randomDirection();
+			Ray ray{ sf::Vector3f{ 0.1f * i - 1.0f, 0.0f, 0.0f }, direction, 0 };
+
+			// the first wall that faces the ray and is intersected is the one the ray leaves the convex polygon through
+			int expectedWall = -1;
+			RayLineSegmentIntersection expected;
+			for (std::size_t w = 0; w < vertices.size() && expectedWall < 0; ++w) {
+				LineSegment wall{ vertices[w], vertices[(w + 1) % vertices.size()] };
+				if (cross(wall.getTo() - wall.getFrom(), direction) <= 0.0f)
+					continue;
+
+				expected = intersect(ray, wall);
+				if (expected.theyIntersect)
+					expectedWall = (int)w;
+			}
+
+			auto hit = intersectWalls(walls, toVector2(ray.getPosition()), direction);
+			ASSERT_EQ(expectedWall, hit.wall);
+			EXPECT_NEAR(expected.rayParameter, hit.rayParameter, 0.0001f);
+			EXPECT_NEAR(expected.lineSegmentParameter, hit.wallParameter, 0.0001f);
+		}
+	}
+}
+
+TEST_F(IntersectTest, SimdAgreesWithScalar) {
+	std::uniform_real_distribution<float> coordinate{ -5.0f, 5.0f };
+	WallArrays walls;
+	for (int i = 0; i < 21; ++i)
+		walls.add(sf::Vector2f{ coordinate(randomGenerator), coordinate(randomGenerator) }, sf::Vector2f{ coordinate(randomGenerator), coordinate(randomGenerator) });
+
+	for (int i = 0; i < 1000; ++i) {
+		sf::Vector2f origin{ coordinate(randomGenerator), coordinate(randomGenerator) };
+		sf::Vector2f direction = randomDirection();
+
+		auto expected = intersectWallsScalar(walls, origin, direction);
+		auto hit = intersectWalls(walls, origin, direction);
+		ASSERT_EQ(expected.wall, hit.wall);
+		EXPECT_EQ(expected.rayParameter, hit.rayParameter);
+		EXPECT_NEAR(expected.wallParameter, hit.wallParameter, 0.0001f);
+	}
+}
+
+TEST_F(IntersectTest, PacketAgreesWithSingleRays) {
+	auto vertices = randomPolygon(11);
+	WallArrays walls;
+	for (std::size_t i = 0; i < vertices.size(); ++i)
+		walls.add(vertices[i], vertices[(i + 1) % vertices.size()]);
+
+	for (int i = 0; i < 100; ++i) {
+		RayPacket packet;
+		sf::Vector2f origin{ 0.01f * i - 0.5f, 0.2f };
+		sf::Vector2f directions[RayPacket::size];
+		for (std::size_t k = 0; k < RayPacket::size; ++k) {
+			directions[k] = randomDirection();
+			packet.set(k, origin, directions[k]);
+		}
+
+		PacketHits hits;
+		intersectWalls(packet, walls, hits);
+
+		for (std::size_t k = 0; k < RayPacket::size; ++k) {
+			auto expected = intersectWalls(walls, origin, directions[k]);
+			ASSERT_EQ(expected.wall, hits[k].wall);
+			EXPECT_EQ(expected.rayParameter, hits[k].rayParameter);
+			EXPECT_NEAR(expected.wallParameter, hits[k].wallParameter, 0.0001f);
+		}
+	}
+}
+
+TEST_F(IntersectTest, SingleWallsAgreeWithAllWalls) {
+	auto vertices = randomPolygon(9);
+	WallArrays walls;
+	for (std::size_t i = 0; i < vertices.size(); ++i)
+		walls.add(vertices[i], vertices[(i + 1) % vertices.size()]);
+
+	for (int i = 0; i < 200; ++i) {
+		sf::Vector2f origin{ 0.005f * i - 0.5f, -0.1f };
+		sf::Vector2f direction = randomDirection();
+
+		// walls are tested in reverse order, the nearest hit has to win anyway
+		WallHit hit;
+		for (std::size_t w = walls.size(); w-- > 0;)
+			intersectWall(walls, w, origin, direction, hit);
+
+		auto expected = intersectWalls(walls, origin, direction);
+		ASSERT_EQ(expected.wall, hit.wall);
+		EXPECT_EQ(expected.rayParameter, hit.rayParameter);
+		EXPECT_NEAR(expected.wallParameter, hit.wallParameter, 0.0001f);
+	}
+}
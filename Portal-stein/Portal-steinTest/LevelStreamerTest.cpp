@@ -0,0 +1,124 @@
+#include "gtest\gtest.h"
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "..\Portal-stein\LevelStreamer.hpp"
+#include "..\Portal-stein\LevelLoader.hpp"
+
+using namespace ps;
+
+class LevelStreamerTest : public ::testing::Test {
+public:
+	LevelStreamerTest() : loaded() {
+	}
+
+	std::vector<std::string> loaded;	///< Files loaded by loadRoom, in the order they were loaded.
+	std::mutex loadedMutex;
+
+	// "Loads" level with one square room, whose size is the name of the file. Files named "broken" cannot be loaded.
+	std::unique_ptr<Level> loadRoom(const std::string & filePath) {
+		{
+			std::lock_guard<std::mutex> lock(loadedMutex);
+			loaded.push_back(filePath);
+		}
+		if (filePath == "broken")
+			return nullptr;
+
+		std::istringstream input{
+			"*VERTICES\n"
+			"a : (0, 0)\n"
+			"b : (0, " + filePath + ")\n"
+			"c : (" + filePath + ", " + filePath + ")\n"
+			"d : (" + filePath + ", 0)\n"
+			"*SEGMENTS\n"
+			"room : {\n"
+			"    walls { a-b-c-d- }\n"
+			"}\n"
+			"*PLAYER\n"
+			"(1, 1) - (1, 0) - room\n" };
+		LevelLoader loader{ input };
+		return std::make_unique<Level>(loader.loadLevel());
+	}
+
+	LevelStreamer::LoadFunction getLoadFunction() {
+		return [this](const std::string & filePath) { return loadRoom(filePath); };
+	}
+
+	float getRoomSize(const Level & level) {
+		return level.getGeometry().getSegment(0).getWalls()[1].getTo().x;
+	}
+};
+
+TEST_F(LevelStreamerTest, LevelsAreTakenInOrder) {
+	LevelStreamer streamer{ getLoadFunction() };
+	streamer.start({ "2", "3", "4" });
+
+	for (float size : { 2.0f, 3.0f, 4.0f }) {
+		auto level = streamer.takeNext();
+		ASSERT_NE(nullptr, level);
+		EXPECT_FLOAT_EQ(size, getRoomSize(*level));
+	}
+
+	EXPECT_EQ(nullptr, streamer.takeNext());
+	EXPECT_TRUE(streamer.isReady());
+}
+
+TEST_F(LevelStreamerTest, NextLevelsArePreparedAhead) {
+	{
+		LevelStreamer streamer{ getLoadFunction(), 2 };
+		streamer.start({ "2", "3", "4", "5" });
+		auto level = streamer.takeNext();
+	}
+
+	// two levels are prepared while the first one is played, but the fourth one is not loaded (the streamer waits for the prepared ones)
+	std::sort(loaded.begin(), loaded.end());
+	EXPECT_EQ((std::vector<std::string>{ "2", "3", "4" }), loaded);
+}
+
+TEST_F(LevelStreamerTest, LevelsArePreparedInParallel) {
+	std::mutex mutex;
+	std::condition_variable started;
+	std::size_t running = 0;
+	std::size_t overlapping = 0;
+
+	// each load waits (for a while) until the others are running too
+	LevelStreamer streamer{ [&](const std::string & filePath) {
+		std::unique_lock<std::mutex> lock(mutex);
+		running++;
+		started.notify_all();
+		if (started.wait_for(lock, std::chrono::seconds(5), [&running]() { return running == 3; }))
+			overlapping++;
+		lock.unlock();
+		return loadRoom(filePath);
+	}, 3 };
+	streamer.start({ "2", "3", "4" });
+
+	for (int i = 0; i < 3; ++i)
+		EXPECT_NE(nullptr, streamer.takeNext());
+	EXPECT_EQ(3u, overlapping);
+}
+
+TEST_F(LevelStreamerTest, BrokenLevelsAreSkipped) {
+	LevelStreamer streamer{ getLoadFunction() };
+	streamer.start({ "broken", "2", "broken" });
+
+	auto level = streamer.takeNext();
+	ASSERT_NE(nullptr, level);
+	EXPECT_FLOAT_EQ(2.0f, getRoomSize(*level));
+	EXPECT_EQ(nullptr, streamer.takeNext());
+	EXPECT_EQ(3u, loaded.size());
+}
+
+TEST_F(LevelStreamerTest, ExceptionIsRethrown) {
+	LevelStreamer streamer{ [](const std::string &) -> std::unique_ptr<Level> { throw std::runtime_error("load failed"); } };
+	streamer.start({ "2" });
+
+	EXPECT_THROW(streamer.takeNext(), std::runtime_error);
+	EXPECT_EQ(nullptr, streamer.takeNext());
+}
@@ -0,0 +1,75 @@
+#include "gtest\gtest.h"
+#include <vector>
+#include "..\Portal-stein\LevelWalls.hpp"
+#include "..\Portal-stein\Wall.hpp"
+
+using namespace ps;
+
+class LevelWallsTest : public ::testing::Test {
+public:
+	LevelWallsTest() : walls() {
+		// two square rooms [0, 2] x [0, 2] and [2, 4] x [0, 2] connected by a door, the second one has 9 walls (its right side is split)
+		std::vector<PortalWall> left;
+		left.push_back(PortalWall(sf::Vector2f{ 0.0f, 0.0f }, sf::Vector2f{ 0.0f, 2.0f }, sf::Color::Red));
+		left.push_back(PortalWall(sf::Vector2f{ 0.0f, 2.0f }, sf::Vector2f{ 2.0f, 2.0f }, sf::Color::Red));
+		left.push_back(makeDoorWall(sf::Vector2f{ 2.0f, 2.0f }, sf::Vector2f{ 2.0f, 0.0f }, 1));
+		left.push_back(PortalWall(sf::Vector2f{ 2.0f, 0.0f }, sf::Vector2f{ 0.0f, 0.0f }, sf::Color::Blue));
+		walls.addSegment(left);
+
+		std::vector<PortalWall> right;
+		right.push_back(makeDoorWall(sf::Vector2f{ 2.0f, 0.0f }, sf::Vector2f{ 2.0f, 2.0f }, 0));
+		right.push_back(PortalWall(sf::Vector2f{ 2.0f, 2.0f }, sf::Vector2f{ 4.0f, 2.0f }, sf::Color::Red));
+		for (int i = 0; i < 6; ++i)
+			right.push_back(PortalWall(sf::Vector2f{ 4.0f, 2.0f - i / 3.0f }, sf::Vector2f{ 4.0f, 2.0f - (i + 1) / 3.0f }, sf::Color::Blue));
+		right.push_back(PortalWall(sf::Vector2f{ 4.0f, 0.0f }, sf::Vector2f{ 2.0f, 0.0f }, sf::Color::Red));
+		walls.addSegment(right);
+	}
+
+	LevelWalls walls;
+};
+
+TEST_F(LevelWallsTest, SegmentsArePadded) {
+	ASSERT_EQ(2u, walls.getSegmentCount());
+
+	EXPECT_EQ(0u, walls.getSegmentWalls(0).first);
+	EXPECT_EQ(4u, walls.getSegmentWalls(0).count);
+	EXPECT_EQ(WallArrays::padding, walls.getWallRange(0).paddedSize());
+
+	// walls of each segment start at a multiple of the padding
+	EXPECT_EQ(WallArrays::padding, walls.getSegmentWalls(1).first);
+	EXPECT_EQ(9u, walls.getSegmentWalls(1).count);
+	EXPECT_EQ(2 * WallArrays::padding, walls.getWallRange(1).paddedSize());
+}
+
+TEST_F(LevelWallsTest, MaterialsAndPortalsAreIndexed) {
+	// red, blue and the white color of the doors
+	EXPECT_EQ(3u, walls.getMaterialCount());
+	EXPECT_EQ(2u, walls.getPortalCount());
+
+	std::uint32_t door = walls.getSegmentWalls(1).first;
+	ASSERT_TRUE(walls.isPortal(door));
+	EXPECT_EQ(0u, walls.getPortal(door).getTargetSegment());
+	EXPECT_FALSE(walls.isPortal(door + 1));
+	EXPECT_EQ(sf::Color::Red, walls.getMaterial(door + 1).color);
+	EXPECT_EQ(&walls.getMaterial(1), &walls.getMaterial(door + 1));
+	EXPECT_EQ(nullptr, walls.getMaterial(door + 1).texture);
+}
+
+TEST_F(LevelWallsTest, RangeHitsTheWallsOfTheSegment) {
+	// ray going right from the middle of the second room hits one of its split walls
+	WallHit hit = intersectWalls(walls.getWallRange(1), sf::Vector2f{ 3.0f, 1.1f }, sf::Vector2f{ 1.0f, 0.0f });
+	ASSERT_EQ(4, hit.wall);
+	EXPECT_FLOAT_EQ(1.0f, hit.rayParameter);
+
+	std::uint32_t wall = walls.getSegmentWalls(1).first + (std::uint32_t)hit.wall;
+	EXPECT_FLOAT_EQ(4.0f, walls.getFrom(wall).x);
+	EXPECT_FLOAT_EQ(1.0f / 3.0f, walls.getLength(wall));
+}
+
+TEST_F(LevelWallsTest, DistanceIsTheSameAsForWall) {
+	PortalWall wall(sf::Vector2f{ 0.0f, 2.0f }, sf::Vector2f{ 2.0f, 2.0f }, sf::Color::Red);
+	std::vector<sf::Vector2f> points = { { 1.0f, 1.0f }, { -1.0f, 3.0f }, { 3.0f, 1.5f }, { 1.0f, 2.5f } };
+
+	for (auto & point : points)
+		EXPECT_FLOAT_EQ(wall.distanceFromWall(point), walls.distanceFromWall(1, point));
+}
@@ -0,0 +1,115 @@
+#include "gtest\gtest.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "..\Portal-stein\LevelWatcher.hpp"
+#include "..\Portal-stein\LevelLoader.hpp"
+
+using namespace ps;
+
+class LevelWatcherTest : public ::testing::Test {
+public:
+	LevelWatcherTest() : path("LevelWatcherTest.lvl"), reloadCount(0) {
+		writeRoom("2");
+	}
+
+	~LevelWatcherTest() {
+		std::remove(path.c_str());
+	}
+
+	std::string path;
+	int reloadCount;
+
+	// Writes level with one square room of given size. Modification time of the file is moved forward, so that the change is seen even
+	// if the file system stores the times in whole seconds.
+	void writeRoom(const std::string & size) {
+		namespace fs = std::experimental::filesystem;
+		std::error_code error;
+		auto previousTime = fs::last_write_time(path, error);
+
+		{
+			std::ofstream file{ path };
+			file <<
+				"*VERTICES\n"
+				"a : (0, 0)\n"
+				"b : (0, " << size << ")\n"
+				"c : (" << size << ", " << size << ")\n"
+				"d : (" << size << ", 0)\n"
+				"*SEGMENTS\n"
+				"room : {\n"
+				"    walls { a-b-c-d- }\n"
+				"}\n"
+				"*PLAYER\n"
+				"(1, 1) - (1, 0) - room\n";
+		}
+
+		if (!error)
+			fs::last_write_time(path, previousTime + std::chrono::seconds(10));
+	}
+
+	std::unique_ptr<Level> loadRoom() {
+		std::ifstream input{ path };
+		LevelLoader loader{ input };
+		return std::make_unique<Level>(loader.loadLevel());
+	}
+
+	LevelWatcher::ReloadFunction getReloadFunction() {
+		return [this](const std::string & filePath, const Level & previous) {
+			reloadCount++;
+			std::ifstream input{ filePath };
+			LevelLoader loader{ input };
+			return std::make_unique<Level>(loader.reloadLevel(previous));
+		};
+	}
+
+	float getRoomSize(const Level & level) {
+		return level.getGeometry().getSegment(0).getWalls()[1].getTo().x;
+	}
+};
+
+TEST_F(LevelWatcherTest, UnchangedFileIsNotReloaded) {
+	auto level = loadRoom();
+	LevelWatcher watcher{ getReloadFunction(), std::chrono::milliseconds(0) };
+	watcher.watch(path);
+
+	EXPECT_EQ(nullptr, watcher.poll(*level));
+	EXPECT_EQ(0, reloadCount);
+}
+
+TEST_F(LevelWatcherTest, ChangedFileIsReloaded) {
+	auto level = loadRoom();
+	LevelWatcher watcher{ getReloadFunction(), std::chrono::milliseconds(0) };
+	watcher.watch(path);
+
+	writeRoom("3");
+	auto reloaded = watcher.poll(*level);
+	ASSERT_NE(nullptr, reloaded);
+	EXPECT_FLOAT_EQ(3.0f, getRoomSize(*reloaded));
+	EXPECT_EQ(1u, reloaded->getVisibility().getSegmentCount());
+
+	// the file is reloaded only once for each change
+	EXPECT_EQ(nullptr, watcher.poll(*reloaded));
+	EXPECT_EQ(1, reloadCount);
+}
+
+TEST_F(LevelWatcherTest, FileIsPolledOncePerInterval) {
+	auto level = loadRoom();
+	LevelWatcher watcher{ getReloadFunction(), std::chrono::hours(1) };
+	watcher.watch(path);
+
+	writeRoom("3");
+	EXPECT_EQ(nullptr, watcher.poll(*level));
+	EXPECT_EQ(0, reloadCount);
+}
+
+TEST_F(LevelWatcherTest, StoppedWatcherDoesNotReload) {
+	auto level = loadRoom();
+	LevelWatcher watcher{ getReloadFunction(), std::chrono::milliseconds(0) };
+	watcher.watch(path);
+	watcher.stop();
+
+	writeRoom("3");
+	EXPECT_EQ(nullptr, watcher.poll(*level));
+	EXPECT_EQ(0, reloadCount);
+}
@@ -0,0 +1,96 @@
+#include "gtest\gtest.h"
+#include <string>
+#include <vector>
+#include "..\Portal-stein\Lexer.hpp"
+
+using namespace ps;
+
+class LexerTest : public ::testing::Test {
+public:
+	// Reads all tokens of the input (including END_OF_STREAM).
+	std::vector<Token> readTokens(const std::string & input) {
+		Lexer lexer{ input.data(), input.size() };
+		std::vector<Token> tokens{ lexer.getLookahead() };
+		while (tokens.back().type != TokenType::END_OF_STREAM)
+			tokens.push_back(lexer.getNextToken());
+		return tokens;
+	}
+};
+
+TEST_F(LexerTest, TokensReferToInput) {
+	std::string input = "*VERTICES\n  abc_1 : (1, -2)";
+	auto tokens = readTokens(input);
+	ASSERT_EQ(10u, tokens.size());
+
+	EXPECT_EQ(TokenType::ASTERISK, tokens[0].type);
+	EXPECT_EQ(TokenType::ID, tokens[1].type);
+	EXPECT_TRUE(tokens[1].value.s == "VERTICES");
+	EXPECT_EQ(input.data() + 1, tokens[1].value.s.data);
+
+	EXPECT_EQ("abc_1", tokens[2].getString());
+	EXPECT_EQ(12u, tokens[2].offset);
+	EXPECT_EQ(2, tokens[2].lineNumber);
+
+	EXPECT_EQ(TokenType::INT, tokens[5].type);
+	EXPECT_EQ(1, tokens[5].value.i);
+	EXPECT_EQ(TokenType::INT, tokens[7].type);
+	EXPECT_EQ(-2, tokens[7].value.i);
+	EXPECT_EQ(TokenType::END_OF_STREAM, tokens[9].type);
+}
+
+TEST_F(LexerTest, NumbersMatchStandardConversion) {
+	auto tokens = readTokens("0.1 -3.75 12.5 2147483647 - 7");
+	ASSERT_EQ(7u, tokens.size());
+
+	EXPECT_EQ(TokenType::FLOAT, tokens[0].type);
+	EXPECT_EQ(std::stof("0.1"), tokens[0].value.f);
+	EXPECT_EQ(-std::stof("3.75"), tokens[1].value.f);
+	EXPECT_EQ(std::stof("12.5"), tokens[2].value.f);
+	EXPECT_EQ(2147483647, tokens[3].value.i);
+	EXPECT_EQ(TokenType::MINUS, tokens[4].type);
+	EXPECT_EQ(7, tokens[5].value.i);
+}
+
+TEST_F(LexerTest, CommentsAndStrings) {
+	auto tokens = readTokens("# comment \"not string\n\"textures\\\\wall.png\" \"two\nlines\" x");
+	ASSERT_EQ(4u, tokens.size());
+
+	EXPECT_EQ(TokenType::STRING, tokens[0].type);
+	EXPECT_EQ("textures\\wall.png", tokens[0].getString());
+	EXPECT_EQ(2, tokens[0].lineNumber);
+	EXPECT_EQ("two\nlines", tokens[1].getString());
+	EXPECT_EQ(3, tokens[2].lineNumber);
+}
+
+TEST_F(LexerTest, ErrorsThrowExceptions) {
+	EXPECT_THROW(readTokens("a \"open string"), OpenStringLiteralException);
+
+	std::string input = "a : 1";
+	Lexer lexer{ input.data(), input.size() };
+	lexer.eat(TokenType::ID);
+	EXPECT_THROW(lexer.eat(TokenType::LPAR), UnexpectedTokenException);
+}
+
+TEST_F(LexerTest, IdentifiersAreInterned) {
+	auto tokens = readTokens("room hall room a");
+	ASSERT_EQ(5u, tokens.size());
+
+	EXPECT_EQ(0u, tokens[0].value.symbol);
+	EXPECT_EQ(1u, tokens[1].value.symbol);
+	EXPECT_EQ(0u, tokens[2].value.symbol);
+	EXPECT_EQ(2u, tokens[3].value.symbol);
+}
+
+TEST_F(LexerTest, SymbolTableGrows) {
+	std::vector<std::string> names;
+	for (int i = 0; i < 1000; ++i)
+		names.push_back("v" + std::to_string(i));
+
+	SymbolTable symbols;
+	for (std::size_t i = 0; i < names.size(); ++i)
+		EXPECT_EQ((Symbol)i, symbols.intern(StringRef{ names[i].data(), names[i].size() }));
+
+	EXPECT_EQ(names.size(), symbols.size());
+	EXPECT_EQ(537u, symbols.intern(StringRef{ "v537", 4 }));
+	EXPECT_TRUE(symbols.getName(999) == "v999");
+}
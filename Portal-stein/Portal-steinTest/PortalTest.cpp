@@ -0,0 +1,85 @@
+#include "gtest\gtest.h"
+#include "Common.hpp"
+#include "..\Portal-stein\Portal.hpp"
+#include "..\Portal-stein\Math.hpp"
+
+using namespace ps;
+
+class PortalTest : public ::testing::Test {
+public:
+	PortalTest() :
+		obj(sf::Vector3f{ 5.0f, 1.0f, 0.5f }, sf::Vector2f{ 0.0f, 1.0f }, 0),
+		from(sf::Vector2f{ 4.0f, 3.0f }, sf::Vector2f{ 7.0f, 3.0f }),
+		to(sf::Vector2f{ 0.0f, 0.0f }, sf::Vector2f{ 0.0f, 3.0f }) {
+	}
+
+	ObjectInScene obj;
+	LineSegment from;
+	LineSegment to;
+};
+
+TEST_F(PortalTest, NoPortal) {
+	Portal portal;
+	EXPECT_FALSE(portal.isPortal());
+
+	portal.stepThrough(obj);
+	EXPECT_VEC3NEAR(sf::Vector3f(5.0f, 1.0f, 0.5f), obj.getPosition(), 0.0001f);
+	EXPECT_EQ(0, obj.getSegmentId());
+}
+
+TEST_F(PortalTest, Door) {
+	Portal portal = makeDoor(3);
+	EXPECT_TRUE(portal.isPortal());
+	EXPECT_EQ(Portal::Type::DOOR, portal.getType());
+
+	portal.stepThrough(obj);
+	EXPECT_VEC3NEAR(sf::Vector3f(5.0f, 1.0f, 0.5f), obj.getPosition(), 0.0001f);
+	EXPECT_VEC2NEAR(sf::Vector2f(0.0f, 1.0f), obj.getDirection(), 0.0001f);
+	EXPECT_EQ(3, obj.getSegmentId());
+}
+
+TEST_F(PortalTest, WallPortal) {
+	Portal portal = makeWallPortal(from, to, 2);
+	EXPECT_EQ(Portal::Type::WALL_PORTAL, portal.getType());
+	EXPECT_EQ(2, portal.getTargetSegment());
+
+	portal.stepThrough(obj);
+	EXPECT_VEC3NEAR(sf::Vector3f(2.0f, 1.0f, 0.5f), obj.getPosition(), 0.0001f);
+	EXPECT_VEC2NEAR(sf::Vector2f(-1.0f, 0.0f), obj.getDirection(), 0.0001f);
+	EXPECT_EQ(2, obj.getSegmentId());
+}
+
+TEST_F(PortalTest, WallPortalThereAndBack) {
+	Portal there = makeWallPortal(from, to, 2);
+	Portal back = makeWallPortal(LineSegment(to.getTo(), to.getFrom()), LineSegment(from.getTo(), from.getFrom()), 0);
+
+	there.stepThrough(obj);
+	back.stepThrough(obj);
+	EXPECT_VEC3NEAR(sf::Vector3f(5.0f, 1.0f, 0.5f), obj.getPosition(), 0.0001f);
+	EXPECT_VEC2NEAR(sf::Vector2f(0.0f, 1.0f), obj.getDirection(), 0.0001f);
+	EXPECT_EQ(0, obj.getSegmentId());
+}
+
+TEST_F(PortalTest, ComposedPortalStepsThroughBoth) {
+	Portal there = makeWallPortal(from, to, 2);
+	Portal further = makeWallPortal(LineSegment(sf::Vector2f(0.0f, 0.0f), sf::Vector2f(0.0f, 3.0f)), LineSegment(sf::Vector2f(1.0f, 5.0f), sf::Vector2f(4.0f, 2.0f)), 4);
+	ObjectInScene stepped = obj;
+
+	there.stepThrough(stepped);
+	further.stepThrough(stepped);
+	Portal composed = there.then(further);
+	EXPECT_EQ(Portal::Type::WALL_PORTAL, composed.getType());
+	EXPECT_EQ(4, composed.getTargetSegment());
+
+	composed.stepThrough(obj);
+	EXPECT_VEC3NEAR(stepped.getPosition(), obj.getPosition(), 0.0001f);
+	EXPECT_VEC2NEAR(stepped.getDirection(), obj.getDirection(), 0.0001f);
+	EXPECT_EQ(4, obj.getSegmentId());
+}
+
+TEST_F(PortalTest, ComposedWithNoPortal) {
+	EXPECT_EQ(Portal::Type::DOOR, Portal().then(makeDoor(3)).getType());
+	EXPECT_EQ(3, Portal().then(makeDoor(3)).getTargetSegment());
+	EXPECT_EQ(Portal::Type::DOOR, makeDoor(1).then(makeDoor(3)).getType());
+	EXPECT_EQ(1, makeDoor(1).then(Portal()).getTargetSegment());
+}
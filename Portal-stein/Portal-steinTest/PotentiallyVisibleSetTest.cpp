@@ -0,0 +1,111 @@
+#include "gtest\gtest.h"
+#include <stdexcept>
+#include "Common.hpp"
+#include "..\Portal-stein\PotentiallyVisibleSet.hpp"
+
+using namespace ps;
+
+class PotentiallyVisibleSetTest : public ::testing::Test {
+public:
+	PotentiallyVisibleSetTest() : graph() {
+	}
+
+	// Adds door to the segment. Door goes from - to in the direction, that has the segment on its right side.
+	void addDoor(std::size_t segment, sf::Vector2f from, sf::Vector2f to, std::size_t target) {
+		if (graph.size() <= getMax(segment, target))
+			graph.resize(getMax(segment, target) + 1);
+		graph[segment].push_back(PortalEdge{ LineSegment(from, to), makeDoor(target) });
+	}
+
+	PortalGraph graph;
+
+private:
+	static std::size_t getMax(std::size_t a, std::size_t b) { return (a > b) ? a : b; }
+};
+
+TEST_F(PotentiallyVisibleSetTest, Empty) {
+	PotentiallyVisibleSet pvs;
+	EXPECT_EQ(0u, pvs.getSegmentCount());
+	EXPECT_THROW(pvs.getVisibleSegments(0), std::out_of_range);
+}
+
+TEST_F(PotentiallyVisibleSetTest, CorridorIsLimitedByDepth) {
+	// rooms [i, i + 1] x [0, 1] connected by doors in their whole walls
+	for (std::size_t i = 0; i < 30; ++i) {
+		float x = (float)i;
+		if (i + 1 < 30)
+			addDoor(i, sf::Vector2f{ x + 1.0f, 1.0f }, sf::Vector2f{ x + 1.0f, 0.0f }, i + 1);
+		if (i > 0)
+			addDoor(i, sf::Vector2f{ x, 0.0f }, sf::Vector2f{ x, 1.0f }, i - 1);
+	}
+
+	PotentiallyVisibleSet pvs{ graph, 20 };
+	ASSERT_EQ(30u, pvs.getSegmentCount());
+	EXPECT_EQ(21u, pvs.getVisibleSegments(0).size());
+	EXPECT_TRUE(pvs.isVisible(0, 20));
+	EXPECT_FALSE(pvs.isVisible(0, 21));
+	EXPECT_EQ(30u, pvs.getVisibleSegments(15).size());
+	EXPECT_TRUE(pvs.isVisible(29, 9));
+	EXPECT_FALSE(pvs.isVisible(29, 8));
+}
+
+TEST_F(PotentiallyVisibleSetTest, CornersHideSegments) {
+	// rooms 3 x 3 around point (3, 3) connected by doors in the middle of their walls: 0 -> 1 -> 2 -> 3
+	addDoor(0, sf::Vector2f{ 3.0f, 2.0f }, sf::Vector2f{ 3.0f, 1.0f }, 1);
+	addDoor(1, sf::Vector2f{ 3.0f, 1.0f }, sf::Vector2f{ 3.0f, 2.0f }, 0);
+	addDoor(1, sf::Vector2f{ 4.0f, 3.0f }, sf::Vector2f{ 5.0f, 3.0f }, 2);
+	addDoor(2, sf::Vector2f{ 5.0f, 3.0f }, sf::Vector2f{ 4.0f, 3.0f }, 1);
+	addDoor(2, sf::Vector2f{ 3.0f, 4.0f }, sf::Vector2f{ 3.0f, 5.0f }, 3);
+	addDoor(3, sf::Vector2f{ 3.0f, 5.0f }, sf::Vector2f{ 3.0f, 4.0f }, 2);
+
+	PotentiallyVisibleSet pvs{ graph, 20 };
+	EXPECT_EQ((std::vector<std::size_t>{ 0, 1, 2 }), pvs.getVisibleSegments(0));
+	EXPECT_EQ((std::vector<std::size_t>{ 0, 1, 2, 3 }), pvs.getVisibleSegments(1));
+	EXPECT_EQ((std::vector<std::size_t>{ 1, 2, 3 }), pvs.getVisibleSegments(3));
+	EXPECT_FALSE(pvs.isVisible(0, 3));
+}
+
+TEST_F(PotentiallyVisibleSetTest, WallPortalTransformsChain) {
+	// room 0 [0, 1] x [0, 1] sees through its right wall into room 1 [10, 11] x [10, 11] (entered through its bottom wall), room 1 has
+	// doors in the middle of its top wall (to room 2) and of its right wall (to room 3)
+	graph.resize(4);
+	graph[0].push_back(PortalEdge{ LineSegment(sf::Vector2f{ 1.0f, 1.0f }, sf::Vector2f{ 1.0f, 0.0f }),
+		makeWallPortal(LineSegment(sf::Vector2f{ 1.0f, 1.0f }, sf::Vector2f{ 1.0f, 0.0f }), LineSegment(sf::Vector2f{ 10.0f, 10.0f }, sf::Vector2f{ 11.0f, 10.0f }), 1) });
+	addDoor(1, sf::Vector2f{ 10.25f, 11.0f }, sf::Vector2f{ 10.75f, 11.0f }, 2);
+	addDoor(1, sf::Vector2f{ 11.0f, 10.75f }, sf::Vector2f{ 11.0f, 10.25f }, 3);
+
+	PotentiallyVisibleSet pvs{ graph, 20 };
+	EXPECT_EQ((std::vector<std::size_t>{ 0, 1, 2, 3 }), pvs.getVisibleSegments(0));
+
+	// only the wall portal is followed
+	PotentiallyVisibleSet limited{ graph, 1 };
+	EXPECT_EQ((std::vector<std::size_t>{ 0, 1 }), limited.getVisibleSegments(0));
+}
+
+TEST_F(PotentiallyVisibleSetTest, EditKeepsDistantSets) {
+	// corridor of rooms [i, i + 1] x [0, 1], the door between the last two rooms is walled up by the edit
+	for (std::size_t i = 0; i < 30; ++i) {
+		float x = (float)i;
+		if (i + 1 < 30)
+			addDoor(i, sf::Vector2f{ x + 1.0f, 1.0f }, sf::Vector2f{ x + 1.0f, 0.0f }, i + 1);
+		if (i > 0)
+			addDoor(i, sf::Vector2f{ x, 0.0f }, sf::Vector2f{ x, 1.0f }, i - 1);
+	}
+	PortalGraph previousGraph = graph;
+	PotentiallyVisibleSet previous{ previousGraph, 5 };
+
+	graph[28].erase(graph[28].begin());
+	graph[29].clear();
+
+	std::vector<bool> affected = findAffectedSegments(graph, previousGraph, 5);
+	EXPECT_FALSE(affected[22]);
+	EXPECT_TRUE(affected[23]);
+	EXPECT_TRUE(affected[29]);
+
+	PotentiallyVisibleSet edited{ graph, 5, previousGraph, previous };
+	PotentiallyVisibleSet computed{ graph, 5 };
+	ASSERT_EQ(30u, edited.getSegmentCount());
+	for (std::size_t i = 0; i < 30; ++i)
+		EXPECT_EQ(computed.getVisibleSegments(i), edited.getVisibleSegments(i));
+	EXPECT_FALSE(edited.isVisible(27, 29));
+}
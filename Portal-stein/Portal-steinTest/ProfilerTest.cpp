@@ -0,0 +1,71 @@
+#include "gtest\gtest.h"
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "..\Portal-stein\Profiler.hpp"
+
+using namespace ps;
+
+class ProfilerTest : public ::testing::Test {
+public:
+	ProfilerTest() {
+		Profiler::clear();
+	}
+
+	~ProfilerTest() {
+		Profiler::clear();
+	}
+
+	// Counts occurrences of the pattern in the text.
+	static std::size_t count(const std::string & text, const std::string & pattern) {
+		std::size_t result = 0;
+		for (std::size_t i = text.find(pattern); i != std::string::npos; i = text.find(pattern, i + 1))
+			result++;
+		return result;
+	}
+};
+
+TEST_F(ProfilerTest, EmptyTrace) {
+	std::ostringstream output;
+	Profiler::writeChromeTrace(output);
+
+	EXPECT_EQ(0u, Profiler::getEventCount());
+	EXPECT_EQ(0u, count(output.str(), "\"ph\""));
+	EXPECT_EQ(1u, count(output.str(), "\"traceEvents\""));
+}
+
+TEST_F(ProfilerTest, ScopesOfAllThreadsAreWritten) {
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([]() {
+			for (int i = 0; i < 100; ++i) {
+				ProfileScope outer{ "outer" };
+				ProfileScope inner{ "inner" };
+			}
+		});
+	}
+	for (auto & thread : threads)
+		thread.join();
+
+	std::ostringstream output;
+	Profiler::writeChromeTrace(output);
+	std::string trace = output.str();
+
+	EXPECT_EQ(800u, Profiler::getEventCount());
+	EXPECT_EQ(400u, count(trace, "\"name\": \"outer\""));
+	EXPECT_EQ(400u, count(trace, "\"name\": \"inner\""));
+	EXPECT_EQ(800u, count(trace, "\"ph\": \"X\""));
+}
+
+TEST_F(ProfilerTest, NestedScopeLiesInsideOuterScope) {
+	auto start = Profiler::Clock::now();
+	Profiler::record("outer", start, start + std::chrono::milliseconds(3));
+	Profiler::record("inner", start + std::chrono::milliseconds(1), start + std::chrono::milliseconds(2));
+
+	std::ostringstream output;
+	Profiler::writeChromeTrace(output);
+	std::string trace = output.str();
+
+	EXPECT_EQ(1u, count(trace, "\"dur\": 3000.000"));
+	EXPECT_EQ(1u, count(trace, "\"dur\": 1000.000"));
+}
@@ -0,0 +1,174 @@
+#include "gtest\gtest.h"
+#include <sstream>
+#include <string>
+#include <vector>
+#include "..\Portal-stein\RayCaster.hpp"
+#include "..\Portal-stein\LevelLoader.hpp"
+
+using namespace ps;
+
+class RayCasterTest : public ::testing::Test {
+public:
+	// room "left" sees room "right" through a door in the middle of its right wall (the rest of the wall hides the right room), the far
+	// wall of "right" is a wall portal leading back into "left", so the rooms repeat until the recursion limit
+	RayCasterTest() : level(loadLevel(
+		"*VERTICES\n"
+		"a : (0, 0)\n"
+		"b : (0, 4)\n"
+		"c : (4, 4)\n"
+		"d : (4, 3)\n"
+		"e : (4, 1)\n"
+		"f : (4, 0)\n"
+		"g : (8, 4)\n"
+		"h : (8, 0)\n"
+		"*SEGMENTS\n"
+		"left : {\n"
+		"    floor((0, 128, 0))\n"
+		"    ceiling((0, 0, 128))\n"
+		"    walls ((255, 0, 0)) { a-b((255, 255, 0))c-d[right]e-f((0, 255, 255)) }\n"
+		"}\n"
+		"right : {\n"
+		"    floor((128, 128, 0))\n"
+		"    ceiling((128, 0, 128))\n"
+		"    walls ((0, 0, 255)) { f-e[left]d-c((255, 255, 255))g[left-b-a]h- }\n"
+		"}\n"
+		"*PLAYER\n"
+		"(1, 2.5) - (1, -0.2) - left\n")), scene(level.makeScene()) {
+	}
+
+	static constexpr unsigned int width = 150;	///< Not a multiple of the tile width, so the last tile is narrower.
+	static constexpr unsigned int height = 100;
+
+	Level level;
+	Scene scene;
+
+	static Level loadLevel(const std::string & source) {
+		std::istringstream input{ source };
+		LevelLoader loader{ input };
+		return loader.loadLevel();
+	}
+
+	// Renders the scene into frame buffer cleared by given color and returns its pixels.
+	std::vector<sf::Uint8> render(RayCaster & caster, sf::Color clearColor = sf::Color::Black) {
+		FrameBuffer frame{ width, height };
+		frame.clear(clearColor);
+		caster.render(frame, scene);
+		return std::vector<sf::Uint8>(frame.getPixels(), frame.getPixels() + 4 * width * height);
+	}
+
+	// Counts the pixels, that have given color.
+	static std::size_t countPixels(const std::vector<sf::Uint8> & pixels, sf::Color color) {
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < pixels.size(); i += 4) {
+			if (sf::Color(pixels[i], pixels[i + 1], pixels[i + 2], pixels[i + 3]) == color)
+				count++;
+		}
+		return count;
+	}
+
+	// Counts the pixels, that differ in the images.
+	static std::size_t countDifferentPixels(const std::vector<sf::Uint8> & a, const std::vector<sf::Uint8> & b) {
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < a.size(); i += 4) {
+			if (a[i] != b[i] || a[i + 1] != b[i + 1] || a[i + 2] != b[i + 2] || a[i + 3] != b[i + 3])
+				count++;
+		}
+		return count;
+	}
+};
+
+constexpr unsigned int RayCasterTest::width;
+constexpr unsigned int RayCasterTest::height;
+
+TEST_F(RayCasterTest, MultipleThreadsRenderSamePicture) {
+	for (bool spanTraversal : { false, true }) {
+		RayCaster single;
+		single.setSpanTraversal(spanTraversal);
+		std::vector<sf::Uint8> expected = render(single);
+
+		RayCaster multiple;
+		multiple.setSpanTraversal(spanTraversal);
+		multiple.setThreadCount(4);
+		EXPECT_EQ(4u, multiple.getThreadCount());
+		EXPECT_EQ(0u, countDifferentPixels(expected, render(multiple)));
+		EXPECT_EQ(single.getRayStepCount(), multiple.getRayStepCount());
+
+		// the picture is not trivial (the door and the rooms behind it are seen)
+		EXPECT_LT(0u, countPixels(expected, sf::Color(0, 0, 255)));
+		EXPECT_LT(0u, countPixels(expected, sf::Color(255, 0, 0)));
+	}
+}
+
+TEST_F(RayCasterTest, SpanTraversalRendersSamePictureAsColumns) {
+	// door seen from both sides (the walls around it hide parts of the rooms behind it), and the wall portal seen from the right room
+	std::vector<ObjectInScene> poses = {
+		scene.camera,
+		ObjectInScene(sf::Vector3f{ 0.5f, 0.5f, 0.5f }, sf::Vector2f{ 0.8f, 0.6f }, 0),
+		ObjectInScene(sf::Vector3f{ 7.0f, 2.0f, 0.5f }, sf::Vector2f{ -1.0f, 0.1f }, 1),
+		ObjectInScene(sf::Vector3f{ 5.0f, 3.5f, 0.3f }, sf::Vector2f{ 0.6f, -0.8f }, 1),
+	};
+
+	for (const ObjectInScene & pose : poses) {
+		scene.camera.setPose(pose);
+
+		RayCaster columns;
+		std::vector<sf::Uint8> expected = render(columns);
+
+		RayCaster spans;
+		spans.setSpanTraversal(true);
+		EXPECT_TRUE(spans.getSpanTraversal());
+		EXPECT_EQ(0u, countDifferentPixels(expected, render(spans)));
+	}
+}
+
+TEST_F(RayCasterTest, UnlimitedBudgetRendersSamePicture) {
+	for (bool spanTraversal : { false, true }) {
+		RayCaster unbudgeted;
+		unbudgeted.setSpanTraversal(spanTraversal);
+		EXPECT_EQ(0u, unbudgeted.getRayStepBudget());
+		std::vector<sf::Uint8> expected = render(unbudgeted);
+
+		RayCaster budgeted;
+		budgeted.setSpanTraversal(spanTraversal);
+		budgeted.setRayStepBudget(1000000);
+		EXPECT_EQ(0u, countDifferentPixels(expected, render(budgeted)));
+		EXPECT_EQ(unbudgeted.getRayStepCount(), budgeted.getRayStepCount());
+	}
+}
+
+TEST_F(RayCasterTest, ExhaustedBudgetFillsPortalsWithFog) {
+	const sf::Color fog{ 255, 0, 255 };
+	const sf::Color background{ 1, 2, 3 };	// color no line has, pixels left uncovered would keep it
+
+	for (bool spanTraversal : { false, true }) {
+		// every column can do one step, so no portal is entered and the door is filled with fog
+		RayCaster exhausted;
+		exhausted.setSpanTraversal(spanTraversal);
+		exhausted.setFogColor(fog);
+		exhausted.setRayStepBudget(width);
+		std::vector<sf::Uint8> pixels = render(exhausted, background);
+		EXPECT_EQ(width, exhausted.getRayStepCount());
+		EXPECT_LT(0u, countPixels(pixels, fog));
+		EXPECT_EQ(0u, countPixels(pixels, background));
+		EXPECT_EQ(0u, countPixels(pixels, sf::Color(0, 0, 255)));		// walls behind the door
+		EXPECT_EQ(0u, countPixels(pixels, sf::Color(128, 128, 0)));	// floor behind the door
+
+		// two steps per column go through the door, the wall portal behind it is filled with fog
+		RayCaster limited;
+		limited.setSpanTraversal(spanTraversal);
+		limited.setFogColor(fog);
+		limited.setRayStepBudget(2 * width);
+		pixels = render(limited, background);
+		EXPECT_GE(2 * width, limited.getRayStepCount());
+		EXPECT_LT(0u, countPixels(pixels, fog));
+		EXPECT_EQ(0u, countPixels(pixels, background));
+		EXPECT_LT(0u, countPixels(pixels, sf::Color(0, 0, 255)));
+		EXPECT_LT(0u, countPixels(pixels, sf::Color(128, 128, 0)));
+
+		// fog is used only when the budget runs out
+		RayCaster unbudgeted;
+		unbudgeted.setSpanTraversal(spanTraversal);
+		unbudgeted.setFogColor(fog);
+		EXPECT_EQ(0u, countPixels(render(unbudgeted), fog));
+	}
+}
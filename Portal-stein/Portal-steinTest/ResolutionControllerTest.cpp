@@ -0,0 +1,63 @@
+#include "gtest\gtest.h"
+#include "..\Portal-stein\ResolutionController.hpp"
+
+using namespace ps;
+
+// Render time of the frame, that costs costMs in full resolution (cost is proportional to the number of pixels).
+double renderTime(const ResolutionController & controller, double costMs) {
+	return costMs * controller.getHorizontalScale() * controller.getVerticalScale();
+}
+
+TEST(ResolutionControllerTest, FastFramesKeepFullResolution) {
+	ResolutionController controller{ 16.0 };
+	for (int i = 0; i < 100; ++i)
+		controller.update(renderTime(controller, 5.0));
+
+	EXPECT_FLOAT_EQ(1.0f, controller.getHorizontalScale());
+	EXPECT_FLOAT_EQ(1.0f, controller.getVerticalScale());
+	EXPECT_EQ(sf::Vector2u(800, 600), controller.getRenderSize(sf::Vector2u(800, 600)));
+}
+
+TEST(ResolutionControllerTest, SlowFramesLowerHorizontalScaleFirst) {
+	ResolutionController controller{ 16.0 };
+	for (int i = 0; i < 200; ++i)
+		controller.update(renderTime(controller, 24.0));
+
+	EXPECT_NEAR(16.0, renderTime(controller, 24.0), 16.0 * ResolutionController::tolerance);
+	EXPECT_LT(controller.getHorizontalScale(), 1.0f);
+	EXPECT_FLOAT_EQ(1.0f, controller.getVerticalScale());
+}
+
+TEST(ResolutionControllerTest, VerticalScaleIsLoweredAtHorizontalMinimum) {
+	ResolutionController controller{ 10.0 };
+	controller.setHorizontalRange(0.5f, 1.0f);
+	for (int i = 0; i < 300; ++i)
+		controller.update(renderTime(controller, 40.0));
+
+	EXPECT_FLOAT_EQ(0.5f, controller.getHorizontalScale());
+	EXPECT_LT(controller.getVerticalScale(), 1.0f);
+	EXPECT_NEAR(10.0, renderTime(controller, 40.0), 10.0 * ResolutionController::tolerance);
+	EXPECT_EQ(400u, controller.getRenderSize(sf::Vector2u(800, 600)).x);
+}
+
+TEST(ResolutionControllerTest, ResolutionRecovers) {
+	ResolutionController controller{ 16.0 };
+	for (int i = 0; i < 200; ++i)
+		controller.update(renderTime(controller, 40.0));
+	for (int i = 0; i < 500; ++i)
+		controller.update(renderTime(controller, 8.0));
+
+	EXPECT_FLOAT_EQ(1.0f, controller.getHorizontalScale());
+	EXPECT_FLOAT_EQ(1.0f, controller.getVerticalScale());
+}
+
+TEST(ResolutionControllerTest, FixedAxis) {
+	ResolutionController controller{ 16.0 };
+	controller.setVerticalRange(1.0f, 1.0f);
+	controller.setHorizontalRange(0.75f, 1.0f);
+	for (int i = 0; i < 200; ++i)
+		controller.update(renderTime(controller, 100.0));
+
+	EXPECT_FLOAT_EQ(0.75f, controller.getHorizontalScale());
+	EXPECT_FLOAT_EQ(1.0f, controller.getVerticalScale());
+}
@@ -0,0 +1,151 @@
+#include "gtest\gtest.h"
+#include <vector>
+#include <random>
+#include "..\Portal-stein\Scene.hpp"
+#include "..\Portal-stein\SegmentBuilder.hpp"
+#include "..\Portal-stein\SegmentIndex.hpp"
+
+using namespace ps;
+
+class SegmentIndexTest : public ::testing::Test {
+public:
+	SegmentIndexTest() : segments() {
+		// rooms [0, 2] x [0, 2] and [2, 4] x [0, 2] connected by a door, and room [1, 3] x [0, 2] overlapping both of them (as if it was
+		// reached through a wall portal)
+		addRoom(sf::Vector2f{ 0.0f, 0.0f }, sf::Vector2f{ 2.0f, 2.0f }, noDoor, 1);
+		addRoom(sf::Vector2f{ 2.0f, 0.0f }, sf::Vector2f{ 4.0f, 2.0f }, 0, noDoor);
+		addRoom(sf::Vector2f{ 1.0f, 0.0f }, sf::Vector2f{ 3.0f, 2.0f }, noDoor, noDoor);
+	}
+
+	static constexpr std::size_t noDoor = 1000;
+
+	// Adds rectangular room, that has doors in its left and right walls (unless the target is noDoor).
+	void addRoom(sf::Vector2f min, sf::Vector2f max, std::size_t leftDoor, std::size_t rightDoor) {
+		SegmentBuilder builder(Floor(sf::Color::Blue), Ceiling(sf::Color::Green));
+		builder.addWall(makeWall(min, sf::Vector2f{ min.x, max.y }, leftDoor));
+		builder.addWall(PortalWall(sf::Vector2f{ min.x, max.y }, max, sf::Color::Red));
+		builder.addWall(makeWall(max, sf::Vector2f{ max.x, min.y }, rightDoor));
+		builder.addWall(PortalWall(sf::Vector2f{ max.x, min.y }, min, sf::Color::Red));
+		segments.push_back(builder.finalize());
+	}
+
+	std::vector<Segment> segments;
+
+private:
+	static PortalWall makeWall(sf::Vector2f from, sf::Vector2f to, std::size_t door) {
+		return (door == noDoor) ? PortalWall(from, to, sf::Color::Red) : makeDoorWall(from, to, door);
+	}
+};
+
+TEST_F(SegmentIndexTest, FindsAllSegmentsContainingPoint) {
+	LevelGeometry geometry{ std::move(segments) };
+
+	EXPECT_EQ(std::vector<std::size_t>({ 0 }), geometry.findSegments(sf::Vector2f{ 0.5f, 1.0f }));
+	EXPECT_EQ(std::vector<std::size_t>({ 0, 2 }), geometry.findSegments(sf::Vector2f{ 1.5f, 1.0f }));
+	EXPECT_EQ(std::vector<std::size_t>({ 1, 2 }), geometry.findSegments(sf::Vector2f{ 2.5f, 1.0f }));
+	EXPECT_EQ(std::vector<std::size_t>({ 0, 1, 2 }), geometry.findSegments(sf::Vector2f{ 2.0f, 1.0f }));
+	EXPECT_TRUE(geometry.findSegments(sf::Vector2f{ 5.0f, 1.0f }).empty());
+	EXPECT_TRUE(geometry.findSegments(sf::Vector2f{ -1.0f, -1.0f }).empty());
+}
+
+TEST_F(SegmentIndexTest, FindNeighbourPortal) {
+	LevelGeometry geometry{ std::move(segments) };
+
+	// segment 0 leads to segment 1 by door, segment 2 lies at the same place only in the coordinates
+	const Portal * portal = geometry.findNeighbourPortal(sf::Vector2f{ 2.5f, 1.0f }, 0);
+	ASSERT_NE(nullptr, portal);
+	EXPECT_EQ(Portal::Type::DOOR, portal->getType());
+	EXPECT_EQ(1u, portal->getTargetSegment());
+
+	EXPECT_EQ(nullptr, geometry.findNeighbourPortal(sf::Vector2f{ 2.5f, 1.0f }, 2));
+	EXPECT_EQ(nullptr, geometry.findNeighbourPortal(sf::Vector2f{ 2.5f, 1.0f }, 7));
+	EXPECT_EQ(nullptr, geometry.findNeighbourPortal(sf::Vector2f{ 9.0f, 9.0f }, 0));
+	// segment 1 contains the point, but segment 2 has no portal into it
+	EXPECT_EQ(nullptr, geometry.findNeighbourPortal(sf::Vector2f{ 3.5f, 1.0f }, 2));
+}
+
+TEST_F(SegmentIndexTest, RecoverSegmentOfDriftedObject) {
+	LevelGeometry geometry{ std::move(segments) };
+
+	FloatingObjInScene object{ ObjectInScene(sf::Vector3f{ 1.0f, 1.0f, 0.5f }, sf::Vector2f{ 1.0f, 0.0f }, 0), 50.0f, geometry };
+	EXPECT_FALSE(object.recoverSegment());
+	EXPECT_EQ(0u, object.getSegmentId());
+
+	// object is slightly behind the door of its segment
+	FloatingObjInScene drifted{ ObjectInScene(sf::Vector3f{ 2.001f, 1.0f, 0.5f }, sf::Vector2f{ 1.0f, 0.0f }, 0), 50.0f, geometry };
+	EXPECT_TRUE(drifted.recoverSegment());
+	EXPECT_EQ(1u, drifted.getSegmentId());
+
+	// object is slightly out of segment without portals, segment 1 contains it, but it is not connected to the segment
+	FloatingObjInScene unconnected{ ObjectInScene(sf::Vector3f{ 3.001f, 1.0f, 0.5f }, sf::Vector2f{ 1.0f, 0.0f }, 2), 50.0f, geometry };
+	EXPECT_FALSE(unconnected.recoverSegment());
+	EXPECT_EQ(2u, unconnected.getSegmentId());
+}
+
+TEST_F(SegmentIndexTest, RecoverSegmentThroughWallPortal) {
+	// right wall of segment 2 leads into room [10, 12] x [0, 2] (segment 3), so the space continues there moved by 7 along x axis
+	SegmentBuilder builder(Floor(sf::Color::Blue), Ceiling(sf::Color::Green));
+	builder.addWall(PortalWall(sf::Vector2f{ 1.0f, 0.0f }, sf::Vector2f{ 1.0f, 2.0f }, sf::Color::Red));
+	builder.addWall(PortalWall(sf::Vector2f{ 1.0f, 2.0f }, sf::Vector2f{ 3.0f, 2.0f }, sf::Color::Red));
+	builder.addWall(makeWallPortalWall(LineSegment(sf::Vector2f{ 3.0f, 2.0f }, sf::Vector2f{ 3.0f, 0.0f }),
+		LineSegment(sf::Vector2f{ 10.0f, 2.0f }, sf::Vector2f{ 10.0f, 0.0f }), 3));
+	builder.addWall(PortalWall(sf::Vector2f{ 3.0f, 0.0f }, sf::Vector2f{ 1.0f, 0.0f }, sf::Color::Red));
+	segments[2] = builder.finalize();
+	addRoom(sf::Vector2f{ 10.0f, 0.0f }, sf::Vector2f{ 12.0f, 2.0f }, noDoor, noDoor);
+	LevelGeometry geometry{ std::move(segments) };
+
+	// segment 1 contains the position too, but the object continues into segment 3
+	FloatingObjInScene drifted{ ObjectInScene(sf::Vector3f{ 3.001f, 1.0f, 0.5f }, sf::Vector2f{ 1.0f, 0.0f }, 2), 50.0f, geometry };
+	EXPECT_TRUE(drifted.recoverSegment());
+	EXPECT_EQ(3u, drifted.getSegmentId());
+	EXPECT_NEAR(10.001f, drifted.getPosition().x, 1e-4f);
+	EXPECT_NEAR(1.0f, drifted.getPosition().y, 1e-4f);
+	EXPECT_EQ(Portal::Type::WALL_PORTAL, drifted.getCrossedPortal().getType());
+}
+
+TEST_F(SegmentIndexTest, GridMatchesLinearScan) {
+	// 30 x 30 rooms of different sizes, the last row of rooms overlaps the others
+	LevelWalls walls;
+	for (int i = 0; i < 30; ++i) {
+		for (int j = 0; j < 30; ++j) {
+			sf::Vector2f min{ i * 2.0f, (j < 29) ? j * 3.0f : 10.0f };
+			sf::Vector2f max = min + sf::Vector2f{ 1.0f + (i % 3), 1.0f + (j % 4) };
+			std::vector<PortalWall> room;
+			room.push_back(PortalWall(min, sf::Vector2f{ min.x, max.y }, sf::Color::Red));
+			room.push_back(PortalWall(sf::Vector2f{ min.x, max.y }, max, sf::Color::Red));
+			room.push_back(PortalWall(max, sf::Vector2f{ max.x, min.y }, sf::Color::Red));
+			room.push_back(PortalWall(sf::Vector2f{ max.x, min.y }, min, sf::Color::Red));
+			walls.addSegment(room);
+		}
+	}
+	SegmentIndex index{ walls };
+	EXPECT_LE(walls.getSegmentCount(), index.getCellCount());
+	EXPECT_GE(4 * walls.getSegmentCount(), index.getCellCount());
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> coordinate(-5.0f, 95.0f);
+	std::size_t found = 0;
+	for (int i = 0; i < 2000; ++i) {
+		sf::Vector2f point{ coordinate(random), coordinate(random) };
+		std::vector<std::size_t> expected;
+		for (std::size_t segmentId = 0; segmentId < walls.getSegmentCount(); ++segmentId) {
+			if (isPointInSegment(walls, segmentId, point))
+				expected.push_back(segmentId);
+		}
+
+		std::vector<std::size_t> result;
+		index.findSegments(walls, point, result);
+		EXPECT_EQ(expected, result);
+		found += result.size();
+	}
+	EXPECT_LT(100u, found);
+}
+
+TEST_F(SegmentIndexTest, EmptyIndex) {
+	LevelWalls walls;
+	SegmentIndex index{ walls };
+
+	std::vector<std::size_t> result;
+	index.findSegments(walls, sf::Vector2f{ 0.0f, 0.0f }, result);
+	EXPECT_TRUE(result.empty());
+}
@@ -0,0 +1,104 @@
+#include "gtest\gtest.h"
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "..\Portal-stein\TextureCache.hpp"
+#include "..\Portal-stein\Wall.hpp"
+#include "..\Portal-stein\FloorCeiling.hpp"
+
+using namespace ps;
+
+class TextureCacheTest : public ::testing::Test {
+public:
+	TextureCacheTest() : path("TextureCacheTest.bmp"), cache() {
+		// 2x2 image in 24-bit BMP format (rows are padded to 4 bytes)
+		const std::uint8_t header[54] = {
+			'B', 'M', 70, 0, 0, 0, 0, 0, 0, 0, 54, 0, 0, 0,
+			40, 0, 0, 0, 2, 0, 0, 0, 2, 0, 0, 0, 1, 0, 24, 0, 0, 0, 0, 0, 16, 0, 0, 0,
+			0x13, 0x0b, 0, 0, 0x13, 0x0b, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+		};
+		const std::uint8_t pixels[16] = {
+			0, 0, 255, 0, 255, 0, 0, 0,
+			255, 0, 0, 255, 255, 255, 0, 0
+		};
+
+		std::ofstream file{ path, std::ios_base::binary };
+		file.write(reinterpret_cast<const char *>(header), sizeof(header));
+		file.write(reinterpret_cast<const char *>(pixels), sizeof(pixels));
+	}
+
+	~TextureCacheTest() {
+		std::remove(path.c_str());
+	}
+
+	std::string path;
+	TextureCache cache;
+};
+
+TEST_F(TextureCacheTest, FileIsLoadedOnce) {
+	auto first = cache.request(path);
+	auto second = cache.request("./" + path);
+	EXPECT_EQ(first.get(), second.get());
+
+	EXPECT_TRUE(cache.waitForImage(path));
+	EXPECT_EQ(1u, cache.getDecodeCount());
+	EXPECT_EQ(1u, cache.getTextureCount());
+}
+
+TEST_F(TextureCacheTest, TextureIsEmptyUntilUploaded) {
+	auto texture = cache.request(path);
+	ASSERT_TRUE(cache.waitForImage(path));
+	EXPECT_EQ(0u, texture->getSize().x);
+	EXPECT_EQ(0u, cache.getTextureMemory());
+
+	cache.uploadTextures();
+	EXPECT_EQ(2u, texture->getSize().x);
+	EXPECT_EQ(2u, texture->getSize().y);
+	EXPECT_EQ(2u * 2u * 4u, cache.getTextureMemory());
+}
+
+TEST_F(TextureCacheTest, UnusedTextureIsReleased) {
+	{
+		// entry of the released texture is erased by the upload, so its decoding is waited for here
+		auto texture = cache.request(path);
+		ASSERT_TRUE(cache.waitForImage(path));
+	}
+	cache.uploadTextures();
+	EXPECT_EQ(0u, cache.getTextureCount());
+
+	// texture nobody holds is loaded again
+	auto texture = cache.request(path);
+	cache.uploadTextures();
+	EXPECT_EQ(2u, cache.getDecodeCount());
+	EXPECT_EQ(1u, cache.getTextureCount());
+}
+
+TEST_F(TextureCacheTest, MissingFileFails) {
+	auto texture = cache.request("TextureCacheTest_missing.bmp");
+	EXPECT_FALSE(cache.waitForImage("TextureCacheTest_missing.bmp"));
+	EXPECT_FALSE(cache.waitForImage("TextureCacheTest_never_requested.bmp"));
+
+	cache.uploadTextures();
+	EXPECT_EQ(0u, texture->getSize().x);
+}
+
+TEST_F(TextureCacheTest, TexturesAreRepeated) {
+	auto texture = cache.request(path);
+	EXPECT_TRUE(texture->isRepeated());
+
+	// walls and floors only share the texture, they must not change it
+	Wall wall{ sf::Vector2f(0.0f, 0.0f), sf::Vector2f(1.0f, 0.0f), sf::Color::Red, texture };
+	PortalWall portalWall{ sf::Vector2f(1.0f, 0.0f), sf::Vector2f(1.0f, 1.0f), sf::Color::Red, texture };
+	Floor floor{ sf::Color::Green, texture };
+	Ceiling ceiling{ sf::Color::Blue, texture };
+	EXPECT_EQ(texture.get(), floor.getTexture().get());
+	EXPECT_EQ(texture.get(), ceiling.getTexture().get());
+	EXPECT_TRUE(texture->isRepeated());
+	EXPECT_EQ(0u, texture->getSize().x);
+
+	ASSERT_TRUE(cache.waitForImage(path));
+	cache.uploadTextures();
+	EXPECT_TRUE(texture->isRepeated());
+	EXPECT_EQ(2u, texture->getSize().x);
+}
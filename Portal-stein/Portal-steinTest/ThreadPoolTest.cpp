@@ -0,0 +1,55 @@
+#include "gtest\gtest.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "..\Portal-stein\ThreadPool.hpp"
+
+using namespace ps;
+
+TEST(ThreadPoolTest, WaitRunsTasksOfAllQueues) {
+	ThreadPool pool{ 4 };
+	std::atomic<int> finished{ 0 };
+
+	// queue 0 belongs to the thread calling wait(), the others are emptied by the workers (or stolen)
+	for (int i = 0; i < 200; ++i)
+		pool.submit(i % 4, [&finished]() { finished++; });
+	pool.wait();
+	EXPECT_EQ(200, finished);
+
+	// pool can be waited for again
+	for (int i = 0; i < 100; ++i)
+		pool.submit(3, [&finished]() { finished++; });
+	pool.wait();
+	EXPECT_EQ(300, finished);
+}
+
+TEST(ThreadPoolTest, TasksSubmittedFromSeveralThreads) {
+	ThreadPool pool{ 3 };
+	std::atomic<int> finished{ 0 };
+
+	std::vector<std::thread> submitters;
+	for (int i = 0; i < 4; ++i) {
+		submitters.emplace_back([&pool, &finished]() {
+			for (int j = 0; j < 250; ++j)
+				pool.submit([&finished]() { finished++; });
+		});
+	}
+	for (auto & submitter : submitters)
+		submitter.join();
+
+	pool.wait();
+	EXPECT_EQ(1000, finished);
+}
+
+TEST(ThreadPoolTest, SingleThreadRunsTasksInWait) {
+	ThreadPool pool{ 1 };
+	EXPECT_EQ(1u, pool.getThreadCount());
+
+	std::vector<std::thread::id> threads;
+	for (int i = 0; i < 10; ++i)
+		pool.submit([&threads]() { threads.push_back(std::this_thread::get_id()); });
+	EXPECT_TRUE(threads.empty());
+
+	pool.wait();
+	EXPECT_EQ(std::vector<std::thread::id>(10, std::this_thread::get_id()), threads);
+}
@@ -0,0 +1,60 @@
+#include "gtest\gtest.h"
+#include <thread>
+#include "..\Portal-stein\TripleBuffer.hpp"
+
+using namespace ps;
+
+TEST(TripleBufferTest, InitialValue) {
+	TripleBuffer<int> buffer{ 7 };
+	EXPECT_FALSE(buffer.update());
+	EXPECT_EQ(7, buffer.getReadBuffer());
+}
+
+TEST(TripleBufferTest, ReaderTakesNewestValue) {
+	TripleBuffer<int> buffer{ 0 };
+	for (int i = 1; i <= 3; ++i) {
+		buffer.getWriteBuffer() = i;
+		buffer.publish();
+	}
+
+	EXPECT_TRUE(buffer.update());
+	EXPECT_EQ(3, buffer.getReadBuffer());
+	EXPECT_FALSE(buffer.update());
+	EXPECT_EQ(3, buffer.getReadBuffer());
+
+	buffer.getWriteBuffer() = 4;
+	buffer.publish();
+	EXPECT_TRUE(buffer.update());
+	EXPECT_EQ(4, buffer.getReadBuffer());
+}
+
+TEST(TripleBufferTest, ConcurrentValuesAreComplete) {
+	struct Pair {
+		int a;
+		int b;
+	};
+
+	TripleBuffer<Pair> buffer{ Pair{ 0, 0 } };
+	const int count = 200000;
+
+	std::thread writer{ [&]() {
+		for (int i = 1; i <= count; ++i) {
+			buffer.getWriteBuffer() = Pair{ i, -i };
+			buffer.publish();
+		}
+	} };
+
+	// values are never torn, and they never go back in time
+	int last = 0;
+	bool consistent = true;
+	while (last < count) {
+		buffer.update();
+		const Pair & value = buffer.getReadBuffer();
+		consistent = consistent && (value.a == -value.b) && (value.a >= last);
+		last = value.a;
+	}
+	writer.join();
+
+	EXPECT_TRUE(consistent);
+	EXPECT_EQ(count, last);
+}